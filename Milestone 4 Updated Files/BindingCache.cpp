@@ -0,0 +1,114 @@
+/***********************************************************
+ *
+ *  BindingCache.cpp
+ *	============
+ *  shadow of OpenGL object bindings that drops redundant binds
+ *
+ ***********************************************************/
+
+#include "BindingCache.h"
+
+
+BindingCache::BindingCache() : m_vao(0), m_vaoValid(false), m_issued(0), m_skipped(0) {
+}
+
+
+void BindingCache::Invalidate() {
+    m_vaoValid = false;
+    m_buffers.clear();
+    m_indexed.clear();
+    m_vertexBuffers.clear();
+}
+
+
+bool BindingCache::Count(bool redundant) {
+    if (redundant) ++m_skipped;
+    else ++m_issued;
+    return !redundant;
+}
+
+
+void BindingCache::BindVertexArray(GLuint vao) {
+    if (!Count(m_vaoValid && m_vao == vao)) return;
+    glBindVertexArray(vao);
+    m_vao = vao;
+    m_vaoValid = true;
+}
+
+
+void BindingCache::BindBuffer(GLenum target, GLuint buffer) {
+    for (BufferBinding& binding : m_buffers) {
+        if (binding.target != target) continue;
+        if (!Count(binding.buffer == buffer)) return;
+        glBindBuffer(target, buffer);
+        binding.buffer = buffer;
+        return;
+    }
+    Count(false);
+    glBindBuffer(target, buffer);
+    m_buffers.push_back({ target, buffer });
+}
+
+
+void BindingCache::ForgetBuffer(GLenum target) {
+    for (size_t i = 0; i < m_buffers.size(); ++i) {
+        if (m_buffers[i].target != target) continue;
+        m_buffers[i] = m_buffers.back();
+        m_buffers.pop_back();
+        return;
+    }
+}
+
+
+// --- Enhancement: Compare an indexed binding with its shadow, then remember it ---
+bool BindingCache::UpdateIndexed(const IndexedBinding& binding) {
+    for (IndexedBinding& known : m_indexed) {
+        if (known.target != binding.target || known.index != binding.index) continue;
+        if (!Count(known.buffer == binding.buffer && known.offset == binding.offset &&
+                   known.size == binding.size))
+            return false;
+        known = binding;
+        return true;
+    }
+    Count(false);
+    m_indexed.push_back(binding);
+    return true;
+}
+
+
+void BindingCache::BindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+    if (!UpdateIndexed({ target, index, buffer, 0, -1 })) return;
+    glBindBufferBase(target, index, buffer);
+    // the non-indexed binding of the target changed too
+    ForgetBuffer(target);
+}
+
+
+void BindingCache::BindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size) {
+    if (!UpdateIndexed({ target, index, buffer, offset, size })) return;
+    glBindBufferRange(target, index, buffer, offset, size);
+    ForgetBuffer(target);
+}
+
+
+void BindingCache::BindVertexBuffer(GLuint binding, GLuint buffer, GLintptr offset, GLsizei stride) {
+    if (!m_vaoValid) {
+        // the binding belongs to a vertex array we do not know
+        Count(false);
+        glBindVertexBuffer(binding, buffer, offset, stride);
+        return;
+    }
+
+    for (VertexBufferBinding& known : m_vertexBuffers) {
+        if (known.vao != m_vao || known.binding != binding) continue;
+        if (!Count(known.buffer == buffer && known.offset == offset && known.stride == stride)) return;
+        glBindVertexBuffer(binding, buffer, offset, stride);
+        known.buffer = buffer;
+        known.offset = offset;
+        known.stride = stride;
+        return;
+    }
+    Count(false);
+    glBindVertexBuffer(binding, buffer, offset, stride);
+    m_vertexBuffers.push_back({ m_vao, binding, buffer, offset, stride });
+}
@@ -0,0 +1,93 @@
+/***********************************************************
+ *
+ *  BindingCache.h
+ *	============
+ *  shadow of OpenGL object bindings that drops redundant binds
+ *
+ ***********************************************************/
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <GL/glew.h>
+
+
+/***********************************************************
+ *  BindingCache
+ *
+ *  Remembers the last vertex array, buffer, indexed buffer
+ *  range and vertex buffer binding made through it, and drops
+ *  a bind that would not change anything. Only binds made
+ *  through the cache are known to it: code that binds the
+ *  same targets directly must call one of the Invalidate
+ *  functions afterwards, and an unknown binding is always
+ *  sent. Vertex buffer bindings are part of the vertex array
+ *  and are remembered per vertex array.
+ ***********************************************************/
+class BindingCache {
+public:
+    BindingCache();
+
+    void BindVertexArray(GLuint vao);
+
+    // Non-indexed target, e.g. GL_DRAW_INDIRECT_BUFFER
+    void BindBuffer(GLenum target, GLuint buffer);
+
+    // Indexed target (GL_UNIFORM_BUFFER, GL_SHADER_STORAGE_BUFFER, ...);
+    // both also bind the buffer to the target's non-indexed binding
+    void BindBufferBase(GLenum target, GLuint index, GLuint buffer);
+    void BindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+
+    // Vertex buffer binding point of the currently bound vertex array
+    void BindVertexBuffer(GLuint binding, GLuint buffer, GLintptr offset, GLsizei stride);
+
+    // --- Enhancement: Forget bindings changed behind the cache's back ---
+    // Only the current vertex array; the bindings stored in each vertex array stay known
+    void InvalidateVertexArray() { m_vaoValid = false; }
+    // Everything
+    void Invalidate();
+
+    // Binds sent to OpenGL / dropped as redundant since the last reset
+    uint32_t IssuedCount() const { return m_issued; }
+    uint32_t SkippedCount() const { return m_skipped; }
+    void ResetCounters() { m_issued = m_skipped = 0; }
+
+private:
+    struct BufferBinding {
+        GLenum target;
+        GLuint buffer;
+    };
+
+    struct IndexedBinding {
+        GLenum target;
+        GLuint index;
+        GLuint buffer;
+        GLintptr offset;
+        GLsizeiptr size;        // -1 = whole buffer (glBindBufferBase)
+    };
+
+    struct VertexBufferBinding {
+        GLuint vao;
+        GLuint binding;
+        GLuint buffer;
+        GLintptr offset;
+        GLsizei stride;
+    };
+
+    // Records a bind; false if it matches the shadow and can be dropped
+    bool Count(bool redundant);
+    void ForgetBuffer(GLenum target);
+    bool UpdateIndexed(const IndexedBinding& binding);
+
+    GLuint m_vao;
+    bool m_vaoValid;
+
+    // a handful of targets are bound through the cache, so these are searched linearly
+    std::vector<BufferBinding> m_buffers;
+    std::vector<IndexedBinding> m_indexed;
+    std::vector<VertexBufferBinding> m_vertexBuffers;
+
+    uint32_t m_issued;
+    uint32_t m_skipped;
+};
@@ -0,0 +1,47 @@
+/***********************************************************
+ *
+ *  CameraPath.cpp
+ *	============
+ *  scripted camera movement for headless runs
+ *
+ ***********************************************************/
+
+#include "CameraPath.h"
+#include <algorithm>
+
+
+bool CameraPath::Load(const std::string& filename) {
+    std::vector<CameraKey> keys;
+    if (!JsonDatabase::LoadCameraPath(keys, filename)) return false;
+
+    std::stable_sort(keys.begin(), keys.end(),
+        [](const CameraKey& a, const CameraKey& b) { return a.frame < b.frame; });
+    m_keys.swap(keys);
+    return true;
+}
+
+
+void CameraPath::Hold(const CameraState& camera) {
+    m_keys.assign(1, CameraKey{ 0, camera });
+}
+
+
+// --- Enhancement: Blend the two keys around a frame ---
+CameraState CameraPath::Sample(int frame) const {
+    if (m_keys.empty()) return CameraState{ glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f), 45.0f };
+    if (frame <= m_keys.front().frame) return m_keys.front().camera;
+    if (frame >= m_keys.back().frame) return m_keys.back().camera;
+
+    size_t next = 1;
+    while (m_keys[next].frame <= frame) ++next;
+    const CameraKey& a = m_keys[next - 1];
+    const CameraKey& b = m_keys[next];
+    float t = static_cast<float>(frame - a.frame) / static_cast<float>(b.frame - a.frame);
+
+    CameraState camera;
+    camera.position = glm::mix(a.camera.position, b.camera.position, t);
+    camera.front = glm::normalize(glm::mix(a.camera.front, b.camera.front, t));
+    camera.up = glm::normalize(glm::mix(a.camera.up, b.camera.up, t));
+    camera.zoom = a.camera.zoom + t * (b.camera.zoom - a.camera.zoom);
+    return camera;
+}
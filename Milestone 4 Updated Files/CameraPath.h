@@ -0,0 +1,40 @@
+/***********************************************************
+ *
+ *  CameraPath.h
+ *	============
+ *  scripted camera movement for headless runs
+ *
+ ***********************************************************/
+
+#pragma once
+#include <string>
+#include <vector>
+#include "JsonDatabase.h"
+
+
+/***********************************************************
+ *  CameraPath
+ *
+ *  Camera keyframes by frame number. Between two keys the
+ *  position, view direction, up vector and zoom are blended
+ *  linearly; before the first and after the last key the
+ *  camera holds still. A path with a single key is a fixed
+ *  camera, which is what a run without a path file uses.
+ ***********************************************************/
+class CameraPath {
+public:
+    // Reads the keys with JsonDatabase::LoadCameraPath()
+    bool Load(const std::string& filename);
+
+    // Replaces the path with a camera that never moves
+    void Hold(const CameraState& camera);
+
+    bool Empty() const { return m_keys.empty(); }
+    size_t KeyCount() const { return m_keys.size(); }
+
+    // Camera state on the given frame
+    CameraState Sample(int frame) const;
+
+private:
+    std::vector<CameraKey> m_keys;     // sorted by frame
+};
@@ -0,0 +1,412 @@
+/***********************************************************
+ *
+ *  CommandCapture.cpp
+ *	============
+ *  records the frames' draw command stream into a binary file
+ *
+ ***********************************************************/
+
+#include "CommandCapture.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+
+namespace
+{
+    // --- Enhancement: Components and getter of a uniform type; 0 = not captured ---
+    int ComponentCount(GLenum type, bool& isFloat) {
+        isFloat = true;
+        switch (type) {
+        case GL_FLOAT: return 1;
+        case GL_FLOAT_VEC2: return 2;
+        case GL_FLOAT_VEC3: return 3;
+        case GL_FLOAT_VEC4: return 4;
+        case GL_FLOAT_MAT3: return 9;
+        case GL_FLOAT_MAT4: return 16;
+        default: break;
+        }
+
+        isFloat = false;
+        switch (type) {
+        case GL_INT:
+        case GL_BOOL:
+        case GL_SAMPLER_2D:
+        case GL_SAMPLER_2D_ARRAY:
+        case GL_SAMPLER_2D_SHADOW:
+        case GL_SAMPLER_CUBE:
+            return 1;
+        case GL_INT_VEC2: case GL_BOOL_VEC2: return 2;
+        case GL_INT_VEC3: case GL_BOOL_VEC3: return 3;
+        case GL_INT_VEC4: case GL_BOOL_VEC4: return 4;
+        default: return 0;
+        }
+    }
+}
+
+
+CommandCapture::CommandCapture()
+    : m_frames(0), m_framesLeft(0), m_snapshotDone(false), m_recordStart(0) {
+}
+
+
+void CommandCapture::Start(const std::string& filename, int frames) {
+    if (frames <= 0) return;
+
+    m_filename = filename;
+    m_frames = m_framesLeft = frames;
+    m_snapshotDone = false;
+    m_stream.clear();
+    m_blocks.clear();
+    m_recordedBatches.clear();
+}
+
+
+// --- Enhancement: Frame boundaries; the program state and textures are snapshotted once ---
+void CommandCapture::BeginFrame(GLuint program, GLenum textureTarget, GLint textureUnits) {
+    if (!IsRecording()) return;
+
+    if (!m_snapshotDone) {
+        SnapshotProgram(program);
+        SnapshotTextures(textureTarget, textureUnits);
+        m_snapshotDone = true;
+    }
+
+    GLint viewport[4] = { 0, 0, 0, 0 };
+    GLfloat clearColor[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+
+    Begin(CAPTURE_FRAME_BEGIN);
+    Put(static_cast<uint32_t>(viewport[2]));
+    Put(static_cast<uint32_t>(viewport[3]));
+    Put(clearColor, sizeof(clearColor));
+    End();
+}
+
+
+void CommandCapture::EndFrame() {
+    if (!IsRecording()) return;
+
+    Begin(CAPTURE_FRAME_END);
+    End();
+    if (--m_framesLeft > 0) return;
+
+    if (Write())
+        std::cout << "Captured " << m_frames << " frames (" << (m_stream.size() + 1023) / 1024
+            << " KB) to " << m_filename << std::endl;
+    else
+        std::cout << "Failed to write capture " << m_filename << std::endl;
+    m_stream.clear();
+    m_stream.shrink_to_fit();
+    m_blocks.clear();
+}
+
+
+// --- Enhancement: Every default-block uniform of the program, by name ---
+// Uniforms set before the capture (lighting switches, sampler units, ...)
+// are otherwise never seen by the frames' records.
+void CommandCapture::SnapshotProgram(GLuint program) {
+    if (program == 0) return;
+
+    GLint uniformCount = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &uniformCount);
+    for (GLint i = 0; i < uniformCount; ++i) {
+        GLuint index = static_cast<GLuint>(i);
+        GLint blockIndex = -1;
+        glGetActiveUniformsiv(program, 1, &index, GL_UNIFORM_BLOCK_INDEX, &blockIndex);
+        if (blockIndex != -1) continue;     // block members come from the uniform buffers
+
+        char name[256];
+        GLsizei nameLength = 0;
+        GLint arraySize = 0;
+        GLenum type = 0;
+        glGetActiveUniform(program, index, sizeof(name), &nameLength, &arraySize, &type, name);
+
+        bool isFloat = false;
+        int components = ComponentCount(type, isFloat);
+        if (components == 0) continue;
+
+        // arrays are captured one element at a time
+        std::string baseName(name, nameLength);
+        if (arraySize > 1 && baseName.size() > 3 && baseName.compare(baseName.size() - 3, 3, "[0]") == 0)
+            baseName.resize(baseName.size() - 3);
+
+        for (GLint element = 0; element < arraySize; ++element) {
+            std::string elementName = arraySize > 1 ? baseName + "[" + std::to_string(element) + "]" : baseName;
+            GLint location = glGetUniformLocation(program, elementName.c_str());
+            if (location < 0) continue;
+
+            // ints and floats have the same size, so one buffer holds either
+            float value[16];
+            if (isFloat) glGetUniformfv(program, location, value);
+            else glGetUniformiv(program, location, reinterpret_cast<GLint*>(value));
+
+            Begin(CAPTURE_PROGRAM_UNIFORM);
+            Put(static_cast<uint32_t>(type));
+            Put(static_cast<uint32_t>(elementName.size()));
+            Put(elementName.data(), elementName.size());
+            Put(value, components * sizeof(float));
+            End();
+        }
+    }
+}
+
+
+// --- Enhancement: The texels and sampling state of the loaded textures ---
+// Level 0 is read back as RGBA8 and the internal format is kept, so
+// replay samples the same images at the same size; the mipmaps are
+// generated again from level 0, as TextureManager generates them.
+void CommandCapture::SnapshotTextures(GLenum target, GLint unitCount) {
+    GLenum bindingQuery = target == GL_TEXTURE_2D_ARRAY ? GL_TEXTURE_BINDING_2D_ARRAY : GL_TEXTURE_BINDING_2D;
+    GLint activeUnit = GL_TEXTURE0;
+    glGetIntegerv(GL_ACTIVE_TEXTURE, &activeUnit);
+
+    std::vector<uint8_t> texels;
+    for (GLint unit = 0; unit < unitCount; ++unit) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        GLint texture = 0;
+        glGetIntegerv(bindingQuery, &texture);
+        if (texture == 0) continue;
+
+        GLint internalFormat = GL_RGBA8, width = 0, height = 0, layers = 1;
+        glGetTexLevelParameteriv(target, 0, GL_TEXTURE_INTERNAL_FORMAT, &internalFormat);
+        glGetTexLevelParameteriv(target, 0, GL_TEXTURE_WIDTH, &width);
+        glGetTexLevelParameteriv(target, 0, GL_TEXTURE_HEIGHT, &height);
+        if (target == GL_TEXTURE_2D_ARRAY)
+            glGetTexLevelParameteriv(target, 0, GL_TEXTURE_DEPTH, &layers);
+        if (width <= 0 || height <= 0 || layers <= 0) continue;
+
+        GLint sampling[4] = { GL_LINEAR, GL_LINEAR, GL_REPEAT, GL_REPEAT };
+        glGetTexParameteriv(target, GL_TEXTURE_MIN_FILTER, &sampling[0]);
+        glGetTexParameteriv(target, GL_TEXTURE_MAG_FILTER, &sampling[1]);
+        glGetTexParameteriv(target, GL_TEXTURE_WRAP_S, &sampling[2]);
+        glGetTexParameteriv(target, GL_TEXTURE_WRAP_T, &sampling[3]);
+
+        texels.resize(static_cast<size_t>(width) * height * layers * 4);
+        glGetTexImage(target, 0, GL_RGBA, GL_UNSIGNED_BYTE, texels.data());
+
+        Begin(CAPTURE_TEXTURE);
+        Put(static_cast<uint32_t>(unit));
+        Put(static_cast<uint32_t>(target));
+        Put(static_cast<uint32_t>(internalFormat));
+        Put(static_cast<uint32_t>(width));
+        Put(static_cast<uint32_t>(height));
+        Put(static_cast<uint32_t>(layers));
+        for (GLint value : sampling)
+            Put(static_cast<uint32_t>(value));
+        Put(texels.data(), texels.size());
+        End();
+    }
+    glActiveTexture(static_cast<GLenum>(activeUnit));
+}
+
+
+void CommandCapture::Uniform(UniformHandle handle, CaptureValue type, const void* value, size_t size) {
+    if (!IsRecording()) return;
+
+    Begin(CAPTURE_UNIFORM);
+    Put(static_cast<uint8_t>(handle));
+    Put(type);
+    Put(value, size);
+    End();
+}
+
+
+// --- Enhancement: Read back the range bound to a uniform block binding ---
+void CommandCapture::ReadUniformBlock(GLuint binding) {
+    if (!IsRecording()) return;
+
+    GLint buffer = 0;
+    GLint64 start = 0, size = 0;
+    glGetIntegeri_v(GL_UNIFORM_BUFFER_BINDING, binding, &buffer);
+    if (buffer == 0) return;
+    glGetInteger64i_v(GL_UNIFORM_BUFFER_START, binding, &start);
+    glGetInteger64i_v(GL_UNIFORM_BUFFER_SIZE, binding, &size);
+
+    glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+    if (size == 0) {
+        // bound with glBindBufferBase: the whole buffer
+        glGetBufferParameteri64v(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &size);
+        size -= start;
+    }
+    std::vector<uint8_t> contents(static_cast<size_t>(size));
+    if (!contents.empty())
+        glGetBufferSubData(GL_COPY_READ_BUFFER, start, size, contents.data());
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+    UniformBlock(binding, contents.data(), contents.size());
+}
+
+
+void CommandCapture::UniformBlock(GLuint binding, const void* data, size_t size, bool fromRing) {
+    if (!IsRecording()) return;
+
+    if (binding >= m_blocks.size()) m_blocks.resize(binding + 1);
+    std::vector<uint8_t>& last = m_blocks[binding];
+    if (!fromRing && last.size() == size && memcmp(last.data(), data, size) == 0) return;
+    last.assign(static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + size);
+
+    Begin(CAPTURE_UNIFORM_BLOCK);
+    Put(static_cast<uint32_t>(binding));
+    Put(static_cast<uint8_t>(fromRing ? 1 : 0));
+    Put(data, size);
+    End();
+}
+
+
+void CommandCapture::Instances(const std::vector<InstanceData>& instances, bool fromRing) {
+    if (!IsRecording()) return;
+
+    Begin(CAPTURE_INSTANCES);
+    Put(static_cast<uint8_t>(fromRing ? 1 : 0));
+    Put(instances.data(), instances.size() * sizeof(InstanceData));
+    End();
+}
+
+
+void CommandCapture::DrawCommands(const std::vector<DrawElementsIndirectCommand>& commands,
+                                  const std::vector<DrawData>& drawData, bool fromRing) {
+    if (!IsRecording()) return;
+
+    Begin(CAPTURE_DRAW_COMMANDS);
+    Put(static_cast<uint8_t>(fromRing ? 1 : 0));
+    Put(static_cast<uint32_t>(commands.size()));
+    Put(commands.data(), commands.size() * sizeof(DrawElementsIndirectCommand));
+    Put(drawData.data(), drawData.size() * sizeof(DrawData));
+    End();
+}
+
+
+void CommandCapture::DrawMesh(MeshType mesh, int lod) {
+    if (!IsRecording()) return;
+
+    Begin(CAPTURE_DRAW_MESH);
+    Put(static_cast<uint8_t>(mesh));
+    Put(static_cast<uint8_t>(lod));
+    End();
+}
+
+
+void CommandCapture::DrawShape(MeshType mesh) {
+    if (!IsRecording()) return;
+
+    Begin(CAPTURE_DRAW_SHAPE);
+    Put(static_cast<uint8_t>(mesh));
+    End();
+}
+
+
+void CommandCapture::DrawInstanced(MeshType mesh, int lod, GLuint baseInstance, GLsizei count) {
+    if (!IsRecording()) return;
+
+    Begin(CAPTURE_DRAW_INSTANCED);
+    Put(static_cast<uint8_t>(mesh));
+    Put(static_cast<uint8_t>(lod));
+    Put(static_cast<uint32_t>(baseInstance));
+    Put(static_cast<uint32_t>(count));
+    End();
+}
+
+
+void CommandCapture::MultiDrawIndirect(size_t firstCommand, GLsizei count) {
+    if (!IsRecording()) return;
+
+    Begin(CAPTURE_MULTI_DRAW_INDIRECT);
+    Put(static_cast<uint32_t>(firstCommand));
+    Put(static_cast<uint32_t>(count));
+    End();
+}
+
+
+// --- Enhancement: A static batch draw, preceded by its geometry the first time ---
+void CommandCapture::DrawStatic(uint32_t batch, GLuint vertexBuffer, GLuint indexBuffer, GLsizei indexCount) {
+    if (!IsRecording()) return;
+
+    if (batch >= m_recordedBatches.size()) m_recordedBatches.resize(batch + 1, false);
+    if (!m_recordedBatches[batch]) {
+        m_recordedBatches[batch] = true;
+
+        GLint64 vertexBytes = 0;
+        glBindBuffer(GL_COPY_READ_BUFFER, vertexBuffer);
+        glGetBufferParameteri64v(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &vertexBytes);
+        std::vector<uint8_t> vertices(static_cast<size_t>(vertexBytes));
+        if (!vertices.empty())
+            glGetBufferSubData(GL_COPY_READ_BUFFER, 0, vertexBytes, vertices.data());
+
+        std::vector<GLuint> indices(indexCount);
+        glBindBuffer(GL_COPY_READ_BUFFER, indexBuffer);
+        if (!indices.empty())
+            glGetBufferSubData(GL_COPY_READ_BUFFER, 0, indices.size() * sizeof(GLuint), indices.data());
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+        Begin(CAPTURE_STATIC_BATCH);
+        Put(batch);
+        Put(static_cast<uint32_t>(vertices.size() / sizeof(MeshVertex)));
+        Put(vertices.data(), vertices.size());
+        Put(indices.data(), indices.size() * sizeof(GLuint));
+        End();
+    }
+
+    Begin(CAPTURE_DRAW_STATIC);
+    Put(batch);
+    End();
+}
+
+
+void CommandCapture::DepthFunc(GLenum func) {
+    if (!IsRecording()) return;
+
+    Begin(CAPTURE_DEPTH_FUNC);
+    Put(static_cast<uint32_t>(func));
+    End();
+}
+
+
+void CommandCapture::ColorMask(bool enabled) {
+    if (!IsRecording()) return;
+
+    Begin(CAPTURE_COLOR_MASK);
+    Put(static_cast<uint8_t>(enabled ? 1 : 0));
+    End();
+}
+
+
+// --- Enhancement: Record framing: opcode, payload size patched in by End() ---
+void CommandCapture::Begin(CaptureOp op) {
+    m_recordStart = m_stream.size();
+    m_stream.push_back(op);
+    Put(static_cast<uint32_t>(0));
+}
+
+
+void CommandCapture::End() {
+    uint32_t size = static_cast<uint32_t>(m_stream.size() - m_recordStart - 1 - sizeof(uint32_t));
+    memcpy(&m_stream[m_recordStart + 1], &size, sizeof(size));
+}
+
+
+void CommandCapture::Put(const void* data, size_t size) {
+    if (size == 0) return;
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    m_stream.insert(m_stream.end(), bytes, bytes + size);
+}
+
+
+bool CommandCapture::Write() const {
+    std::ofstream file(m_filename, std::ios::binary);
+    if (!file) return false;
+
+    CaptureHeader header;
+    memcpy(header.magic, "RCAP", 4);
+    header.version = VERSION;
+    header.frameCount = static_cast<uint32_t>(m_frames);
+    header.instanceSize = sizeof(InstanceData);
+    header.drawCommandSize = sizeof(DrawElementsIndirectCommand);
+    header.drawDataSize = sizeof(DrawData);
+    header.vertexSize = sizeof(MeshVertex);
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(m_stream.data()), m_stream.size());
+    return static_cast<bool>(file);
+}
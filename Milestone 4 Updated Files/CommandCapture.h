@@ -0,0 +1,158 @@
+/***********************************************************
+ *
+ *  CommandCapture.h
+ *	============
+ *  records the frames' draw command stream into a binary file
+ *
+ ***********************************************************/
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <GL/glew.h>
+#include "MeshLibrary.h"
+#include "UniformCache.h"
+
+
+// --- Enhancement: Record types of a capture file ---
+// Every record is an opcode byte, a 32-bit payload size and the payload.
+enum CaptureOp : uint8_t {
+    CAPTURE_PROGRAM_UNIFORM = 1,    // GLenum type, name, value: initial state of a program uniform
+    CAPTURE_FRAME_BEGIN,            // width, height, clear color
+    CAPTURE_FRAME_END,
+    CAPTURE_UNIFORM,                // UniformHandle, CaptureValue, value
+    CAPTURE_UNIFORM_BLOCK,          // binding, ring flag, contents
+    CAPTURE_INSTANCES,              // ring flag, InstanceData[]
+    CAPTURE_DRAW_COMMANDS,          // ring flag, count, DrawElementsIndirectCommand[count], DrawData[count]
+    CAPTURE_STATIC_BATCH,           // batch, vertex count, MeshVertex[], GLuint indices[]
+    CAPTURE_DRAW_MESH,              // MeshType, LOD
+    CAPTURE_DRAW_INSTANCED,         // MeshType, LOD, base instance, count
+    CAPTURE_MULTI_DRAW_INDIRECT,    // first command, count
+    CAPTURE_DRAW_STATIC,            // batch
+    CAPTURE_DEPTH_FUNC,             // GLenum
+    CAPTURE_COLOR_MASK,             // 0 or 1
+    CAPTURE_TEXTURE,                // unit, target, internal format, width, height, layers,
+                                    // min and mag filter, wrap s and t, RGBA8 texels of level 0
+    CAPTURE_DRAW_SHAPE              // MeshType: a ShapeMeshes draw, which binds its own VAO
+};
+
+
+// --- Enhancement: Value types of a CAPTURE_UNIFORM record, one per UniformCache setter ---
+enum CaptureValue : uint8_t {
+    CAPTURE_INT = 0,
+    CAPTURE_FLOAT,
+    CAPTURE_VEC2,
+    CAPTURE_VEC3,
+    CAPTURE_VEC4,
+    CAPTURE_MAT3,
+    CAPTURE_MAT4
+};
+
+
+// --- Enhancement: First bytes of a capture file ---
+// The records hold the engine's structs as they are in memory, so a
+// file only replays in a build whose struct sizes match.
+struct CaptureHeader {
+    char magic[4];                  // "RCAP"
+    uint32_t version;
+    uint32_t frameCount;
+    uint32_t instanceSize;          // sizeof(InstanceData)
+    uint32_t drawCommandSize;       // sizeof(DrawElementsIndirectCommand)
+    uint32_t drawDataSize;          // sizeof(DrawData)
+    uint32_t vertexSize;            // sizeof(MeshVertex)
+};
+
+
+/***********************************************************
+ *  CommandCapture
+ *
+ *  Records what the render paths send to OpenGL for a number
+ *  of frames: uniform sets, uniform buffer contents, instance
+ *  and indirect data, depth state and every draw, with the
+ *  draws naming MeshLibrary meshes and static batch ids
+ *  instead of buffer objects. The frames are kept in memory
+ *  and written to one compact binary file after the last one,
+ *  which CommandReplay can re-issue without the rest of the
+ *  application.
+ *
+ *  The program's uniforms and the loaded textures are
+ *  snapshotted when the first frame begins, and the material
+ *  and light buffers and the static batch geometry are read
+ *  back from the GPU, so that state made before the capture
+ *  is part of the file too. Reading back stalls the
+ *  pipeline; that is only paid while recording. Data the
+ *  frame wrote into its ring buffer section is flagged, so
+ *  replay sends it through a ring buffer as well. Every
+ *  record call does nothing when idle.
+ ***********************************************************/
+class CommandCapture {
+public:
+    static const uint32_t VERSION = 2;
+
+    CommandCapture();
+
+    // Records the next `frames` frames and writes them to `filename`
+    // when the last one ends
+    void Start(const std::string& filename, int frames);
+    bool IsRecording() const { return m_framesLeft > 0; }
+
+    // Frame boundaries; BeginFrame() snapshots the program and the
+    // `textureTarget` textures bound to units [0, textureUnits) the first time
+    void BeginFrame(GLuint program, GLenum textureTarget, GLint textureUnits);
+    void EndFrame();
+
+    // A uniform set that UniformCache sent to OpenGL
+    void Uniform(UniformHandle handle, CaptureValue type, const void* value, size_t size);
+
+    // Contents of the uniform buffer bound to `binding`, read back from the GPU
+    void ReadUniformBlock(GLuint binding);
+    // Contents of a uniform block already known on the CPU; `fromRing` if
+    // the frame wrote it into the ring buffer, in which case it is recorded
+    // every frame, as the frame writes it
+    void UniformBlock(GLuint binding, const void* data, size_t size, bool fromRing = false);
+
+    // Data written for the instanced and indirect draws, from the ring
+    // buffer or uploaded into the MeshLibrary's own buffers
+    void Instances(const std::vector<InstanceData>& instances, bool fromRing);
+    void DrawCommands(const std::vector<DrawElementsIndirectCommand>& commands,
+                      const std::vector<DrawData>& drawData, bool fromRing);
+
+    // Draws; a static batch's geometry is read back the first time it is drawn
+    void DrawMesh(MeshType mesh, int lod);
+    void DrawShape(MeshType mesh);
+    void DrawInstanced(MeshType mesh, int lod, GLuint baseInstance, GLsizei count);
+    void MultiDrawIndirect(size_t firstCommand, GLsizei count);
+    void DrawStatic(uint32_t batch, GLuint vertexBuffer, GLuint indexBuffer, GLsizei indexCount);
+
+    // Fixed-function state the render paths change
+    void DepthFunc(GLenum func);
+    void ColorMask(bool enabled);
+
+    // Static batches were baked again; their geometry is recorded again when next drawn
+    void InvalidateStaticBatches() { m_recordedBatches.clear(); }
+
+private:
+    void SnapshotProgram(GLuint program);
+    void SnapshotTextures(GLenum target, GLint unitCount);
+    bool Write() const;
+
+    // Starts a record; the payload is appended with Put()
+    void Begin(CaptureOp op);
+    void End();
+    void Put(const void* data, size_t size);
+    template <typename T> void Put(const T& value) { Put(&value, sizeof(T)); }
+
+    std::string m_filename;
+    int m_frames;
+    int m_framesLeft;
+    bool m_snapshotDone;
+
+    std::vector<uint8_t> m_stream;
+    size_t m_recordStart;
+
+    // last contents recorded per uniform block binding; unchanged blocks are not recorded again
+    std::vector<std::vector<uint8_t>> m_blocks;
+    std::vector<bool> m_recordedBatches;
+};
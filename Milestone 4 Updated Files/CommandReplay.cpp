@@ -0,0 +1,593 @@
+/***********************************************************
+ *
+ *  CommandReplay.cpp
+ *	============
+ *  re-issues a captured draw command stream without the scene
+ *
+ ***********************************************************/
+
+#include "CommandReplay.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+
+namespace
+{
+    // Vertex attribute locations shared with vertexShader.glsl
+    const GLuint ATTRIB_POSITION = 0;
+    const GLuint ATTRIB_NORMAL = 1;
+    const GLuint ATTRIB_UV = 2;
+
+    // Texture units given a white placeholder; covers TextureManager::SPARE_TEXTURE_UNIT
+    const GLint PLACEHOLDER_UNITS = 32;
+
+    // Reads a value from a record's payload and advances past it
+    template <typename T> T Take(const uint8_t*& data) {
+        T value;
+        memcpy(&value, data, sizeof(T));
+        data += sizeof(T);
+        return value;
+    }
+
+    // Whether a record holds data the captured frame wrote into its ring buffer
+    bool WrittenToRing(CaptureOp op, const uint8_t* data, uint32_t size) {
+        switch (op) {
+        case CAPTURE_UNIFORM_BLOCK:
+            return size > sizeof(uint32_t) && data[sizeof(uint32_t)] != 0;
+        case CAPTURE_INSTANCES:
+        case CAPTURE_DRAW_COMMANDS:
+            return size > 0 && data[0] != 0;
+        default:
+            return false;
+        }
+    }
+}
+
+
+CommandReplay::CommandReplay()
+    : m_prologueEnd(0), m_nextFrame(0), m_width(0), m_height(0), m_program(0),
+      m_whiteTexture(0), m_whiteTextureArray(0), m_nextTexture(0), m_nextDefinition(0), m_drawCalls(0) {
+}
+
+CommandReplay::~CommandReplay() {
+    Destroy();
+}
+
+
+// --- Enhancement: Read the file and find the frame boundaries ---
+bool CommandReplay::Load(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file) {
+        std::cout << "Cannot open capture " << filename << std::endl;
+        return false;
+    }
+
+    CaptureHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        memcmp(header.magic, "RCAP", 4) != 0) {
+        std::cout << filename << " is not a capture file" << std::endl;
+        return false;
+    }
+    if (header.version != CommandCapture::VERSION ||
+        header.instanceSize != sizeof(InstanceData) ||
+        header.drawCommandSize != sizeof(DrawElementsIndirectCommand) ||
+        header.drawDataSize != sizeof(DrawData) ||
+        header.vertexSize != sizeof(MeshVertex)) {
+        std::cout << filename << " was captured by a different build (version " << header.version << ")" << std::endl;
+        return false;
+    }
+    m_stream.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+    m_frames.clear();
+    m_prologueEnd = 0;
+    size_t offset = 0;
+    size_t recordStart = 0;
+    Frame frame = { 0, 0, 0, 0 };
+    bool inFrame = false;
+    Record record;
+    for (; NextRecord(offset, m_stream.size(), record); recordStart = offset) {
+        if (record.op == CAPTURE_FRAME_BEGIN) {
+            if (m_frames.empty() && !inFrame) {
+                // everything before the first frame is the program snapshot
+                m_prologueEnd = recordStart;
+                const uint8_t* data = record.data;
+                m_width = static_cast<int>(Take<uint32_t>(data));
+                m_height = static_cast<int>(Take<uint32_t>(data));
+            }
+            frame = { recordStart, 0, 0, 0 };
+            inFrame = true;
+        }
+        else if (record.op == CAPTURE_FRAME_END && inFrame) {
+            frame.end = offset;
+            m_frames.push_back(frame);
+            inFrame = false;
+        }
+        else if (inFrame && WrittenToRing(record.op, record.data, record.size)) {
+            frame.ringBytes += record.size;
+            frame.ringAllocations += record.op == CAPTURE_DRAW_COMMANDS ? 2 : 1;
+        }
+    }
+    if (offset != m_stream.size() || m_frames.empty()) {
+        std::cout << filename << " is truncated or holds no frames" << std::endl;
+        m_frames.clear();
+        return false;
+    }
+    return true;
+}
+
+
+// --- Enhancement: Every GL object the frames need, created up front ---
+bool CommandReplay::Prepare(GLuint program) {
+    if (program == 0 || m_frames.empty()) return false;
+    Destroy();
+
+    m_program = program;
+    glUseProgram(program);
+    m_uniforms.Resolve(program);
+    // the capture only holds sets that reached OpenGL; replay sends all of them
+    m_uniforms.SetShadowing(false);
+
+    m_meshes.SetBindingCache(&m_bindings);
+    m_meshes.LoadMeshes();
+
+    // the captured textures and static batch geometry, one object per definition in the file
+    glActiveTexture(GL_TEXTURE0);
+    size_t offset = 0;
+    Record record;
+    while (NextRecord(offset, m_stream.size(), record)) {
+        if (record.op == CAPTURE_TEXTURE)
+            CreateTexture(record);
+        else if (record.op == CAPTURE_STATIC_BATCH)
+            CreateStaticBatch(record);
+    }
+
+    // white placeholders for both sampler types on every unit; the
+    // prologue then binds the captured textures over them
+    const GLubyte white[4] = { 255, 255, 255, 255 };
+    glGenTextures(1, &m_whiteTexture);
+    glGenTextures(1, &m_whiteTextureArray);
+    for (GLint unit = 0; unit < PLACEHOLDER_UNITS; ++unit) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(GL_TEXTURE_2D, m_whiteTexture);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, m_whiteTextureArray);
+        if (unit == 0) {
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, 1, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        }
+    }
+    glActiveTexture(GL_TEXTURE0);
+
+    // a ring buffer if the capture wrote into one, sized for the largest frame
+    size_t ringBytes = 0;
+    for (const Frame& frame : m_frames)
+        ringBytes = std::max(ringBytes, RingBytes(frame));
+    if (ringBytes > 0)
+        m_ring.Create(ringBytes);
+    m_bindings.Invalidate();
+
+    Rewind();
+    return true;
+}
+
+
+void CommandReplay::CreateStaticBatch(const Record& record) {
+    const uint8_t* data = record.data;
+    Take<uint32_t>(data);   // batch id, mapped when the record is replayed
+    uint32_t vertexCount = Take<uint32_t>(data);
+    size_t vertexBytes = vertexCount * sizeof(MeshVertex);
+    size_t indexBytes = record.size - 2 * sizeof(uint32_t) - vertexBytes;
+
+    StaticBatch batch;
+    batch.indexCount = static_cast<GLsizei>(indexBytes / sizeof(GLuint));
+    glGenVertexArrays(1, &batch.vao);
+    glGenBuffers(1, &batch.vertexBuffer);
+    glGenBuffers(1, &batch.indexBuffer);
+    glBindVertexArray(batch.vao);
+
+    glBindBuffer(GL_ARRAY_BUFFER, batch.vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, vertexBytes, data, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(ATTRIB_POSITION);
+    glVertexAttribPointer(ATTRIB_POSITION, 3, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (void*)offsetof(MeshVertex, position));
+    glEnableVertexAttribArray(ATTRIB_NORMAL);
+    glVertexAttribPointer(ATTRIB_NORMAL, 3, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (void*)offsetof(MeshVertex, normal));
+    glEnableVertexAttribArray(ATTRIB_UV);
+    glVertexAttribPointer(ATTRIB_UV, 2, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (void*)offsetof(MeshVertex, uv));
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, batch.indexBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, data + vertexBytes, GL_STATIC_DRAW);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    m_definitions.push_back(batch);
+}
+
+
+// --- Enhancement: A captured texture, at its captured size and format ---
+void CommandReplay::CreateTexture(const Record& record) {
+    const uint8_t* data = record.data;
+    const size_t headerSize = 10 * sizeof(uint32_t);
+    if (record.size < headerSize) {
+        m_textures.push_back({ 0, GL_TEXTURE_2D, 0 });
+        return;
+    }
+
+    Texture texture;
+    texture.unit = Take<uint32_t>(data);
+    texture.target = Take<uint32_t>(data);
+    texture.id = 0;
+    GLenum internalFormat = Take<uint32_t>(data);
+    GLsizei width = static_cast<GLsizei>(Take<uint32_t>(data));
+    GLsizei height = static_cast<GLsizei>(Take<uint32_t>(data));
+    GLsizei layers = static_cast<GLsizei>(Take<uint32_t>(data));
+    GLint sampling[4];
+    for (GLint& value : sampling)
+        value = static_cast<GLint>(Take<uint32_t>(data));
+
+    size_t texelBytes = static_cast<size_t>(width) * height * layers * 4;
+    bool isArray = texture.target == GL_TEXTURE_2D_ARRAY;
+    if ((!isArray && texture.target != GL_TEXTURE_2D) || width <= 0 || height <= 0 || layers <= 0 ||
+        texelBytes != record.size - headerSize) {
+        m_textures.push_back(texture);
+        return;
+    }
+
+    // the full mip chain, generated from level 0 as TextureManager generates it
+    GLsizei levels = 1;
+    while ((std::max(width, height) >> levels) > 0) ++levels;
+
+    glGenTextures(1, &texture.id);
+    glBindTexture(texture.target, texture.id);
+    if (isArray) {
+        glTexStorage3D(GL_TEXTURE_2D_ARRAY, levels, internalFormat, width, height, layers);
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, width, height, layers, GL_RGBA, GL_UNSIGNED_BYTE, data);
+    }
+    else {
+        glTexStorage2D(GL_TEXTURE_2D, levels, internalFormat, width, height);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, data);
+    }
+    glTexParameteri(texture.target, GL_TEXTURE_MIN_FILTER, sampling[0]);
+    glTexParameteri(texture.target, GL_TEXTURE_MAG_FILTER, sampling[1]);
+    glTexParameteri(texture.target, GL_TEXTURE_WRAP_S, sampling[2]);
+    glTexParameteri(texture.target, GL_TEXTURE_WRAP_T, sampling[3]);
+    glGenerateMipmap(texture.target);
+    glBindTexture(texture.target, 0);
+    m_textures.push_back(texture);
+}
+
+
+size_t CommandReplay::RingBytes(const Frame& frame) const {
+    return frame.ringBytes + frame.ringAllocations * std::max(m_ring.UniformAlignment(), m_ring.StorageAlignment());
+}
+
+
+void* CommandReplay::WriteRing(const void* data, size_t size, size_t alignment, GLintptr& offset) {
+    void* mapped = m_ring.Allocate(size, alignment, offset);
+    if (mapped) memcpy(mapped, data, size);
+    return mapped;
+}
+
+
+// --- Enhancement: Back to the state the capture started from ---
+void CommandReplay::Rewind() {
+    m_nextFrame = 0;
+    m_nextTexture = 0;
+    m_nextDefinition = 0;
+    m_batches.clear();
+
+    glUseProgram(m_program);
+    glEnable(GL_DEPTH_TEST);
+    glDepthFunc(GL_LESS);
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    m_bindings.Invalidate();
+
+    size_t offset = 0;
+    Record record;
+    while (NextRecord(offset, m_prologueEnd, record))
+        Execute(record);
+}
+
+
+bool CommandReplay::ReplayFrame() {
+    if (m_nextFrame >= m_frames.size()) return false;
+
+    m_drawCalls = 0;
+    const Frame& frame = m_frames[m_nextFrame];
+    // a grown ring is a new buffer, which may have been given the old name
+    if (m_ring.BeginFrame(RingBytes(frame)))
+        m_bindings.Invalidate();
+
+    size_t offset = frame.begin;
+    Record record;
+    while (NextRecord(offset, frame.end, record))
+        Execute(record);
+    m_ring.EndFrame();
+    ++m_nextFrame;
+    return true;
+}
+
+
+bool CommandReplay::NextRecord(size_t& offset, size_t end, Record& record) const {
+    const size_t headerSize = sizeof(uint8_t) + sizeof(uint32_t);
+    if (offset + headerSize > end) return false;
+
+    const uint8_t* data = m_stream.data() + offset;
+    record.op = static_cast<CaptureOp>(Take<uint8_t>(data));
+    record.size = Take<uint32_t>(data);
+    record.data = data;
+    if (offset + headerSize + record.size > end) return false;
+
+    offset += headerSize + record.size;
+    return true;
+}
+
+
+// --- Enhancement: One record back into OpenGL ---
+void CommandReplay::Execute(const Record& record) {
+    const uint8_t* data = record.data;
+    switch (record.op) {
+    case CAPTURE_PROGRAM_UNIFORM:
+        SetProgramUniform(record);
+        break;
+
+    case CAPTURE_FRAME_BEGIN: {
+        Take<uint32_t>(data);
+        Take<uint32_t>(data);
+        GLfloat clearColor[4];
+        memcpy(clearColor, data, sizeof(clearColor));
+        glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        break;
+    }
+
+    case CAPTURE_UNIFORM:
+        SetUniform(record);
+        break;
+
+    case CAPTURE_UNIFORM_BLOCK: {
+        GLuint binding = Take<uint32_t>(data);
+        bool fromRing = Take<uint8_t>(data) != 0;
+        size_t size = record.size - sizeof(uint32_t) - sizeof(uint8_t);
+        GLintptr offset = 0;
+        if (fromRing && WriteRing(data, size, m_ring.UniformAlignment(), offset)) {
+            m_bindings.BindBufferRange(GL_UNIFORM_BUFFER, binding, m_ring.Buffer(), offset, size);
+            break;
+        }
+
+        if (binding >= m_blockBuffers.size()) m_blockBuffers.resize(binding + 1, 0);
+        GLuint& buffer = m_blockBuffers[binding];
+        if (buffer == 0) glGenBuffers(1, &buffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+        glBufferData(GL_UNIFORM_BUFFER, size, data, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        m_bindings.BindBufferBase(GL_UNIFORM_BUFFER, binding, buffer);
+        break;
+    }
+
+    case CAPTURE_INSTANCES: {
+        bool fromRing = Take<uint8_t>(data) != 0;
+        size_t size = (record.size - sizeof(uint8_t)) / sizeof(InstanceData) * sizeof(InstanceData);
+        GLintptr offset = 0;
+        if (fromRing && WriteRing(data, size, 16, offset)) {
+            m_meshes.SetInstanceSource(m_ring.Buffer(), offset);
+            break;
+        }
+
+        m_instances.resize(size / sizeof(InstanceData));
+        if (size > 0) memcpy(m_instances.data(), data, size);
+        m_meshes.UploadInstances(m_instances);
+        break;
+    }
+
+    case CAPTURE_DRAW_COMMANDS: {
+        bool fromRing = Take<uint8_t>(data) != 0;
+        uint32_t count = Take<uint32_t>(data);
+        size_t commandBytes = count * sizeof(DrawElementsIndirectCommand);
+        size_t drawDataBytes = count * sizeof(DrawData);
+        GLintptr commandOffset = 0;
+        GLintptr drawDataOffset = 0;
+        if (fromRing && WriteRing(data, commandBytes, 16, commandOffset) &&
+            WriteRing(data + commandBytes, drawDataBytes, m_ring.StorageAlignment(), drawDataOffset)) {
+            m_meshes.SetDrawCommandSource(m_ring.Buffer(), commandOffset,
+                m_ring.Buffer(), drawDataOffset, drawDataBytes);
+            break;
+        }
+
+        m_drawCommands.resize(count);
+        m_drawData.resize(count);
+        if (count > 0) {
+            memcpy(m_drawCommands.data(), data, commandBytes);
+            memcpy(m_drawData.data(), data + commandBytes, drawDataBytes);
+        }
+        m_meshes.UploadDrawCommands(m_drawCommands, m_drawData);
+        break;
+    }
+
+    case CAPTURE_TEXTURE:
+        if (m_nextTexture < m_textures.size()) {
+            const Texture& texture = m_textures[m_nextTexture++];
+            if (texture.id == 0) break;
+            glActiveTexture(GL_TEXTURE0 + texture.unit);
+            glBindTexture(texture.target, texture.id);
+            glActiveTexture(GL_TEXTURE0);
+        }
+        break;
+
+    case CAPTURE_STATIC_BATCH: {
+        uint32_t batch = Take<uint32_t>(data);
+        if (batch >= m_batches.size()) m_batches.resize(batch + 1, -1);
+        m_batches[batch] = static_cast<int>(m_nextDefinition++);
+        break;
+    }
+
+    case CAPTURE_DRAW_MESH: {
+        MeshType mesh = static_cast<MeshType>(Take<uint8_t>(data));
+        int lod = Take<uint8_t>(data);
+        if (mesh >= MESH_COUNT || lod >= MeshLibrary::LOD_COUNT) break;
+        m_meshes.Bind();
+        m_meshes.Draw(mesh, lod);
+        m_drawCalls++;
+        break;
+    }
+
+    case CAPTURE_DRAW_SHAPE: {
+        MeshType mesh = static_cast<MeshType>(Take<uint8_t>(data));
+        if (mesh >= MESH_COUNT) break;
+        // ShapeMeshes binds the shape's vertex array in every draw
+        m_bindings.InvalidateVertexArray();
+        m_meshes.Bind();
+        m_meshes.Draw(mesh, 0);
+        m_drawCalls++;
+        break;
+    }
+
+    case CAPTURE_DRAW_INSTANCED: {
+        MeshType mesh = static_cast<MeshType>(Take<uint8_t>(data));
+        int lod = Take<uint8_t>(data);
+        GLuint baseInstance = Take<uint32_t>(data);
+        GLsizei count = static_cast<GLsizei>(Take<uint32_t>(data));
+        if (mesh >= MESH_COUNT || lod >= MeshLibrary::LOD_COUNT) break;
+        m_meshes.Bind();
+        m_meshes.DrawInstanced(mesh, baseInstance, count, lod);
+        m_drawCalls++;
+        break;
+    }
+
+    case CAPTURE_MULTI_DRAW_INDIRECT: {
+        uint32_t firstCommand = Take<uint32_t>(data);
+        GLsizei count = static_cast<GLsizei>(Take<uint32_t>(data));
+        m_meshes.BindIndirect();
+        m_meshes.MultiDrawIndirect(firstCommand, count);
+        m_drawCalls++;
+        break;
+    }
+
+    case CAPTURE_DRAW_STATIC: {
+        uint32_t batch = Take<uint32_t>(data);
+        if (batch >= m_batches.size() || m_batches[batch] < 0) break;
+        const StaticBatch& definition = m_definitions[m_batches[batch]];
+        if (definition.indexCount == 0) break;
+        m_bindings.BindVertexArray(definition.vao);
+        glDrawElements(GL_TRIANGLES, definition.indexCount, GL_UNSIGNED_INT, (void*)0);
+        m_drawCalls++;
+        break;
+    }
+
+    case CAPTURE_DEPTH_FUNC:
+        glDepthFunc(static_cast<GLenum>(Take<uint32_t>(data)));
+        break;
+
+    case CAPTURE_COLOR_MASK: {
+        GLboolean enabled = Take<uint8_t>(data) ? GL_TRUE : GL_FALSE;
+        glColorMask(enabled, enabled, enabled, enabled);
+        break;
+    }
+
+    default:
+        // FRAME_END, and records of a newer writer
+        break;
+    }
+}
+
+
+// --- Enhancement: Initial value of a program uniform, looked up by name ---
+void CommandReplay::SetProgramUniform(const Record& record) {
+    const uint8_t* data = record.data;
+    GLenum type = Take<uint32_t>(data);
+    uint32_t nameLength = Take<uint32_t>(data);
+    std::string name(reinterpret_cast<const char*>(data), nameLength);
+    data += nameLength;
+
+    GLint location = glGetUniformLocation(m_program, name.c_str());
+    if (location < 0) return;
+
+    float value[16];
+    memcpy(value, data, std::min<size_t>(record.size - 2 * sizeof(uint32_t) - nameLength, sizeof(value)));
+    const GLint* ints = reinterpret_cast<const GLint*>(value);
+    switch (type) {
+    case GL_FLOAT: glUniform1fv(location, 1, value); break;
+    case GL_FLOAT_VEC2: glUniform2fv(location, 1, value); break;
+    case GL_FLOAT_VEC3: glUniform3fv(location, 1, value); break;
+    case GL_FLOAT_VEC4: glUniform4fv(location, 1, value); break;
+    case GL_FLOAT_MAT3: glUniformMatrix3fv(location, 1, GL_FALSE, value); break;
+    case GL_FLOAT_MAT4: glUniformMatrix4fv(location, 1, GL_FALSE, value); break;
+    case GL_INT_VEC2: case GL_BOOL_VEC2: glUniform2iv(location, 1, ints); break;
+    case GL_INT_VEC3: case GL_BOOL_VEC3: glUniform3iv(location, 1, ints); break;
+    case GL_INT_VEC4: case GL_BOOL_VEC4: glUniform4iv(location, 1, ints); break;
+    default: glUniform1iv(location, 1, ints); break;
+    }
+}
+
+
+// --- Enhancement: A uniform set by handle, through the replay's own UniformCache ---
+void CommandReplay::SetUniform(const Record& record) {
+    const uint8_t* data = record.data;
+    uint8_t handleValue = Take<uint8_t>(data);
+    CaptureValue type = static_cast<CaptureValue>(Take<uint8_t>(data));
+    if (handleValue >= U_COUNT) return;
+    UniformHandle handle = static_cast<UniformHandle>(handleValue);
+
+    float value[16];
+    memcpy(value, data, std::min<size_t>(record.size - 2, sizeof(value)));
+    switch (type) {
+    case CAPTURE_INT: {
+        GLint intValue;
+        memcpy(&intValue, value, sizeof(intValue));
+        m_uniforms.SetInt(handle, intValue);
+        break;
+    }
+    case CAPTURE_FLOAT: m_uniforms.SetFloat(handle, value[0]); break;
+    case CAPTURE_VEC2: m_uniforms.SetVec2(handle, glm::vec2(value[0], value[1])); break;
+    case CAPTURE_VEC3: m_uniforms.SetVec3(handle, glm::vec3(value[0], value[1], value[2])); break;
+    case CAPTURE_VEC4: m_uniforms.SetVec4(handle, glm::vec4(value[0], value[1], value[2], value[3])); break;
+    case CAPTURE_MAT3: {
+        glm::mat3 matrix;
+        memcpy(&matrix[0][0], value, sizeof(float) * 9);
+        m_uniforms.SetMat3(handle, matrix);
+        break;
+    }
+    case CAPTURE_MAT4: {
+        glm::mat4 matrix;
+        memcpy(&matrix[0][0], value, sizeof(float) * 16);
+        m_uniforms.SetMat4(handle, matrix);
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+
+void CommandReplay::Destroy() {
+    for (StaticBatch& batch : m_definitions) {
+        glDeleteBuffers(1, &batch.indexBuffer);
+        glDeleteBuffers(1, &batch.vertexBuffer);
+        glDeleteVertexArrays(1, &batch.vao);
+    }
+    m_definitions.clear();
+    m_batches.clear();
+
+    for (GLuint& buffer : m_blockBuffers) {
+        if (buffer) glDeleteBuffers(1, &buffer);
+    }
+    m_blockBuffers.clear();
+
+    for (Texture& texture : m_textures) {
+        if (texture.id) glDeleteTextures(1, &texture.id);
+    }
+    m_textures.clear();
+    m_ring.Destroy();
+
+    if (m_whiteTexture) glDeleteTextures(1, &m_whiteTexture);
+    if (m_whiteTextureArray) glDeleteTextures(1, &m_whiteTextureArray);
+    m_whiteTexture = m_whiteTextureArray = 0;
+
+    if (m_program != 0) m_meshes.DestroyMeshes();
+    m_bindings.Invalidate();
+    m_program = 0;
+}
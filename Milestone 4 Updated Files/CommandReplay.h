@@ -0,0 +1,142 @@
+/***********************************************************
+ *
+ *  CommandReplay.h
+ *	============
+ *  re-issues a captured draw command stream without the scene
+ *
+ ***********************************************************/
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <GL/glew.h>
+#include "BindingCache.h"
+#include "CommandCapture.h"
+#include "MeshLibrary.h"
+#include "RingBuffer.h"
+#include "UniformCache.h"
+
+
+/***********************************************************
+ *  CommandReplay
+ *
+ *  Plays a CommandCapture file back on the scene program.
+ *  Nothing of the application is needed beyond the shaders:
+ *  the meshes come from MeshLibrary, which builds the same
+ *  geometry the capture named, and the textures, uniform
+ *  buffers, instance and indirect data and static batches
+ *  come from the file. Data the captured frame wrote into its
+ *  ring buffer goes through the replay's own ring buffer, so
+ *  it is sourced the way it was. Texture units the capture
+ *  holds nothing for get a white placeholder. ShapeMeshes
+ *  draws are replayed with MeshLibrary's matching mesh, with
+ *  the vertex array bound again for every draw as ShapeMeshes
+ *  binds it.
+ *
+ *  Frames must be replayed in order from Rewind(), because a
+ *  frame only records what changed since the one before. The
+ *  GL objects are all created by Prepare(), so a replayed
+ *  frame only does the work of the captured one.
+ ***********************************************************/
+class CommandReplay {
+public:
+    CommandReplay();
+    ~CommandReplay();
+
+    // Reads and checks a capture file
+    bool Load(const std::string& filename);
+
+    // Creates the meshes, buffers, textures, ring buffer and static
+    // batches on the current context; `program` is the linked scene program
+    bool Prepare(GLuint program);
+
+    int FrameCount() const { return static_cast<int>(m_frames.size()); }
+    // Viewport of the first captured frame
+    int Width() const { return m_width; }
+    int Height() const { return m_height; }
+
+    // Restores the program state from the start of the capture
+    void Rewind();
+
+    // Issues the next frame into the bound framebuffer; false after the last one
+    bool ReplayFrame();
+
+    // Draw calls issued by the last ReplayFrame()
+    uint32_t DrawCalls() const { return m_drawCalls; }
+
+    // Deletes every GL object
+    void Destroy();
+
+private:
+    struct Record {
+        CaptureOp op;
+        const uint8_t* data;
+        uint32_t size;
+    };
+
+    struct Frame {
+        size_t begin;
+        size_t end;
+        size_t ringBytes;           // data the capture wrote into the ring buffer
+        size_t ringAllocations;     // and the number of pieces it was written in
+    };
+
+    struct Texture {
+        GLuint unit;
+        GLenum target;
+        GLuint id;                  // 0 if the record was malformed
+    };
+
+    struct StaticBatch {
+        GLuint vao = 0;
+        GLuint vertexBuffer = 0;
+        GLuint indexBuffer = 0;
+        GLsizei indexCount = 0;
+    };
+
+    // Steps through the records of [begin, end)
+    bool NextRecord(size_t& offset, size_t end, Record& record) const;
+    void Execute(const Record& record);
+    void SetProgramUniform(const Record& record);
+    void SetUniform(const Record& record);
+    void CreateStaticBatch(const Record& record);
+    void CreateTexture(const Record& record);
+
+    // Ring buffer section a frame needs, with room for each piece's alignment
+    size_t RingBytes(const Frame& frame) const;
+    // Copies `size` bytes into the frame's ring section; nullptr without a ring
+    void* WriteRing(const void* data, size_t size, size_t alignment, GLintptr& offset);
+
+    std::vector<uint8_t> m_stream;
+    size_t m_prologueEnd;                       // records before the first frame
+    std::vector<Frame> m_frames;
+    size_t m_nextFrame;
+    int m_width;
+    int m_height;
+
+    GLuint m_program;
+    UniformCache m_uniforms;
+    BindingCache m_bindings;
+    MeshLibrary m_meshes;
+    std::vector<GLuint> m_blockBuffers;          // per uniform block binding
+    std::vector<InstanceData> m_instances;
+    std::vector<DrawElementsIndirectCommand> m_drawCommands;
+    std::vector<DrawData> m_drawData;
+    RingBuffer m_ring;
+    GLuint m_whiteTexture;
+    GLuint m_whiteTextureArray;
+
+    // captured textures in file order; the prologue binds them to their units
+    std::vector<Texture> m_textures;
+    size_t m_nextTexture;
+
+    // every captured static batch definition, in file order; m_batches maps
+    // a batch id to the definition most recently replayed for it
+    std::vector<StaticBatch> m_definitions;
+    size_t m_nextDefinition;
+    std::vector<int> m_batches;
+
+    uint32_t m_drawCalls;
+};
@@ -0,0 +1,215 @@
+/***********************************************************
+ *
+ *  DeferredRenderer.cpp
+ *	============
+ *  G-buffer and light volumes for scenes with many lights
+ *
+ ***********************************************************/
+
+#include "DeferredRenderer.h"
+#include "BindingCache.h"
+#include "ShaderFiles.h"
+#include <iostream>
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace {
+    // MeshLibrary's sphere LODs are inscribed in the unit sphere; LOD 1
+    // (12 stacks, 18 sectors) dips below it by under 5%, the margin covers that
+    const int VOLUME_LOD = 1;
+    const float VOLUME_MARGIN = 1.1f;
+
+    GLuint CreateTarget(GLenum internalFormat, GLenum format, GLenum type, int width, int height) {
+        GLuint texture = 0;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, NULL);
+        // read with texelFetch only, but an integer texture must not filter
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        return texture;
+    }
+}
+
+
+DeferredRenderer::DeferredRenderer()
+    : m_program(0), m_lightVolumeLocation(-1), m_inverseViewProjectionLocation(-1),
+      m_viewportSizeLocation(-1), m_framebuffer(0), m_albedo(0), m_normal(0), m_material(0),
+      m_depth(0), m_width(0), m_height(0), m_targetFramebuffer(0), m_emptyVao(0),
+      m_lightVolumes(0), m_bindings(nullptr) {
+}
+
+DeferredRenderer::~DeferredRenderer() {
+    Destroy();
+}
+
+
+bool DeferredRenderer::LoadShaders(const std::string& vertexPath, const std::string& fragmentPath) {
+    if (m_program) {
+        glDeleteProgram(m_program);
+        m_program = 0;
+    }
+
+    GLuint program = LinkProgramFiles(vertexPath, fragmentPath, "Deferred lighting");
+    if (!program) return false;
+
+    m_program = program;
+    m_lightVolumeLocation = glGetUniformLocation(m_program, "bLightVolume");
+    m_inverseViewProjectionLocation = glGetUniformLocation(m_program, "inverseViewProjection");
+    m_viewportSizeLocation = glGetUniformLocation(m_program, "viewportSize");
+
+    if (!m_emptyVao) glGenVertexArrays(1, &m_emptyVao);
+    return true;
+}
+
+
+// --- Enhancement: G-buffer, one texture per attribute plus depth ---
+bool DeferredRenderer::Resize(int width, int height) {
+    if (m_framebuffer && width == m_width && height == m_height) return true;
+    DestroyGBuffer();
+    if (width <= 0 || height <= 0) return false;
+    m_width = width;
+    m_height = height;
+
+    GLint previous = 0;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previous);
+
+    m_albedo = CreateTarget(GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, width, height);
+    m_normal = CreateTarget(GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT, width, height);
+    m_material = CreateTarget(GL_R16I, GL_RED_INTEGER, GL_SHORT, width, height);
+    m_depth = CreateTarget(GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, width, height);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenFramebuffers(1, &m_framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_albedo, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, m_normal, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, m_material, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_depth, 0);
+
+    // same locations as the outputs of fragmentShader.glsl
+    const GLenum drawBuffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
+    glDrawBuffers(3, drawBuffers);
+
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindFramebuffer(GL_FRAMEBUFFER, previous);
+    if (!complete) {
+        std::cout << "Deferred G-buffer is incomplete" << std::endl;
+        DestroyGBuffer();
+        return false;
+    }
+    return true;
+}
+
+
+void DeferredRenderer::BeginGeometryPass() {
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &m_targetFramebuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_framebuffer);
+
+    // color writes may be masked off by a depth pre-pass, clears obey the mask
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    glDepthMask(GL_TRUE);
+    const GLfloat zero[] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    const GLint unlit[] = { -1, 0, 0, 0 };
+    const GLfloat farDepth = 1.0f;
+    glClearBufferfv(GL_COLOR, 0, zero);
+    glClearBufferfv(GL_COLOR, 1, zero);
+    glClearBufferiv(GL_COLOR, 2, unlit);
+    glClearBufferfv(GL_DEPTH, 0, &farDepth);
+}
+
+
+// --- Enhancement: Full-viewport pass, then one additive sphere per ranged light ---
+void DeferredRenderer::LightingPass(const LightManager& lights, const glm::mat4& view,
+                                    const glm::mat4& projection, MeshLibrary& meshes) {
+    m_lightVolumes = 0;
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_targetFramebuffer);
+
+    const GLuint gBuffer[] = { m_albedo, m_normal, m_material, m_depth };
+    for (int i = 0; i < 4; ++i) {
+        glActiveTexture(GL_TEXTURE0 + FIRST_TEXTURE_UNIT + i);
+        glBindTexture(GL_TEXTURE_2D, gBuffer[i]);
+    }
+    glActiveTexture(GL_TEXTURE0);
+
+    glUseProgram(m_program);
+    glm::mat4 inverseViewProjection = glm::inverse(projection * view);
+    glUniformMatrix4fv(m_inverseViewProjectionLocation, 1, GL_FALSE, &inverseViewProjection[0][0]);
+    glUniform2f(m_viewportSizeLocation, static_cast<float>(m_width), static_cast<float>(m_height));
+
+    // the G-buffer's depth decides visibility, the target's is not used
+    glDisable(GL_DEPTH_TEST);
+    glDepthMask(GL_FALSE);
+
+    glUniform1i(m_lightVolumeLocation, GL_FALSE);
+    BindVertexArray(m_emptyVao);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    m_volumes.clear();
+    for (int i = 0; i < lights.LightCount(); ++i) {
+        const LightSource* light = lights.GetLight(i);
+        if (light->range <= 0.0f) continue;
+        InstanceData volume = {};
+        volume.model = glm::scale(glm::translate(glm::mat4(1.0f), light->position),
+                                  glm::vec3(light->range * VOLUME_MARGIN));
+        volume.materialIndex = i;
+        m_volumes.push_back(volume);
+    }
+
+    if (!m_volumes.empty()) {
+        m_lightVolumes = static_cast<uint32_t>(m_volumes.size());
+        meshes.UploadInstances(m_volumes);
+        meshes.Bind();
+
+        // back faces cover the screen even with the camera inside the volume;
+        // depth clamping keeps the part of a volume past the far plane, so a
+        // light larger than the view distance still reaches every pixel
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE, GL_ONE);
+        glEnable(GL_CULL_FACE);
+        glCullFace(GL_FRONT);
+        glEnable(GL_DEPTH_CLAMP);
+
+        glUniform1i(m_lightVolumeLocation, GL_TRUE);
+        meshes.DrawInstanced(MESH_SPHERE, 0, static_cast<GLsizei>(m_volumes.size()), VOLUME_LOD);
+
+        glDisable(GL_DEPTH_CLAMP);
+        glCullFace(GL_BACK);
+        glDisable(GL_CULL_FACE);
+        glDisable(GL_BLEND);
+    }
+
+    glDepthMask(GL_TRUE);
+    glEnable(GL_DEPTH_TEST);
+}
+
+
+void DeferredRenderer::BindVertexArray(GLuint vao) const {
+    if (m_bindings) m_bindings->BindVertexArray(vao);
+    else glBindVertexArray(vao);
+}
+
+
+void DeferredRenderer::DestroyGBuffer() {
+    if (m_framebuffer) glDeleteFramebuffers(1, &m_framebuffer);
+    const GLuint textures[] = { m_albedo, m_normal, m_material, m_depth };
+    for (GLuint texture : textures)
+        if (texture) glDeleteTextures(1, &texture);
+    m_framebuffer = m_albedo = m_normal = m_material = m_depth = 0;
+    m_width = m_height = 0;
+}
+
+
+void DeferredRenderer::Destroy() {
+    DestroyGBuffer();
+    if (m_emptyVao) {
+        if (m_bindings) m_bindings->InvalidateVertexArray();
+        glDeleteVertexArrays(1, &m_emptyVao);
+        m_emptyVao = 0;
+    }
+    if (m_program) {
+        glDeleteProgram(m_program);
+        m_program = 0;
+    }
+}
@@ -0,0 +1,100 @@
+/***********************************************************
+ *
+ *  DeferredRenderer.h
+ *	============
+ *  G-buffer and light volumes for scenes with many lights
+ *
+ ***********************************************************/
+
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include "LightManager.h"
+#include "MeshLibrary.h"
+
+class BindingCache;
+
+
+/***********************************************************
+ *  DeferredRenderer
+ *
+ *  The forward shader evaluates every light for every
+ *  fragment it shades, overdrawn ones included. On the
+ *  deferred path the scene is drawn once into a G-buffer
+ *  (albedo, normal, material index and depth) by the scene
+ *  shader itself, with bWriteGBuffer set, and is lit
+ *  afterwards, once per visible pixel:
+ *
+ *  - one full-viewport pass copies the unlit pixels and
+ *    applies the lights without a range
+ *  - every light with a range is a sphere around it, drawn
+ *    with additive blending, whose fragments shade only the
+ *    pixels whose surface is within that range
+ *
+ *  Light volumes are MeshLibrary spheres drawn in a single
+ *  instanced call. Back faces are drawn so a volume that
+ *  contains the camera still covers the screen. The result
+ *  goes into the framebuffer that was bound before the
+ *  G-buffer pass; that framebuffer's depth is not written.
+ ***********************************************************/
+class DeferredRenderer {
+public:
+    // First of the four units the G-buffer is bound to for the lighting
+    // pass (albedo, normal, material, depth); must match the sampler
+    // bindings in deferredLightFragment.glsl and stay clear of the units
+    // TextureManager uses
+    static const GLint FIRST_TEXTURE_UNIT = 27;
+
+    DeferredRenderer();
+    ~DeferredRenderer();
+
+    // Compiles and links the lighting pass shaders
+    bool LoadShaders(const std::string& vertexPath, const std::string& fragmentPath);
+    bool IsReady() const { return m_program != 0; }
+
+    // Routes the vertex array binds through `bindings`; nullptr binds directly
+    void SetBindingCache(BindingCache* bindings) { m_bindings = bindings; }
+
+    // (Re)creates the G-buffer if the size changed
+    bool Resize(int width, int height);
+
+    // Makes the cleared G-buffer the draw target; the framebuffer bound
+    // now is the one LightingPass() writes to
+    void BeginGeometryPass();
+
+    // Shades the target from the G-buffer and returns to the scene program
+    void LightingPass(const LightManager& lights, const glm::mat4& view,
+                      const glm::mat4& projection, MeshLibrary& meshes);
+
+    // Light volumes drawn by the last LightingPass()
+    uint32_t LightVolumes() const { return m_lightVolumes; }
+
+    // Deletes the G-buffer and the lighting program
+    void Destroy();
+
+private:
+    void DestroyGBuffer();
+    void BindVertexArray(GLuint vao) const;
+
+    GLuint m_program;
+    GLint m_lightVolumeLocation;
+    GLint m_inverseViewProjectionLocation;
+    GLint m_viewportSizeLocation;
+
+    GLuint m_framebuffer;
+    GLuint m_albedo;            // RGBA8
+    GLuint m_normal;            // RGBA16F, xyz = world normal
+    GLuint m_material;          // R16I, -1 = unlit
+    GLuint m_depth;             // DEPTH_COMPONENT24
+    int m_width;
+    int m_height;
+
+    GLint m_targetFramebuffer;  // bound before the G-buffer pass
+    GLuint m_emptyVao;          // the full-viewport triangle has no attributes
+    std::vector<InstanceData> m_volumes;
+    uint32_t m_lightVolumes;
+    BindingCache* m_bindings;
+};
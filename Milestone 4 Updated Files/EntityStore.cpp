@@ -0,0 +1,130 @@
+/***********************************************************
+ *
+ *  EntityStore.cpp
+ *	============
+ *  scene objects as generational handles and SoA components
+ *
+ ***********************************************************/
+
+#include "EntityStore.h"
+#include <glm/gtx/transform.hpp>
+
+
+// --- Enhancement: Reuse a free slot, or grow every component array by one ---
+EntityHandle EntityStore::Create(const glm::vec3& position, float radius, const std::string& tag) {
+    uint32_t slot;
+    if (!m_freeSlots.empty()) {
+        slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    }
+    else {
+        slot = static_cast<uint32_t>(m_generation.size());
+        m_generation.push_back(0);
+        m_alive.push_back(0);
+        localPosition.emplace_back();
+        localRotation.emplace_back();
+        localScale.emplace_back();
+        parent.emplace_back();
+        worldPosition.emplace_back();
+        boundingRadius.push_back(0.0f);
+        descriptorIndex.push_back(-1);
+        tagId.push_back(0);
+        isStatic.push_back(0);
+        objectId.push_back(0);
+    }
+
+    m_alive[slot] = 1;
+    localPosition[slot] = position;
+    localRotation[slot] = glm::vec3(0.0f);
+    localScale[slot] = glm::vec3(1.0f);
+    parent[slot] = EntityHandle();
+    worldPosition[slot] = position;
+    boundingRadius[slot] = radius;
+    descriptorIndex[slot] = -1;
+    tagId[slot] = InternTag(tag);
+    isStatic[slot] = 0;
+    objectId[slot] = m_nextObjectId++;
+    m_slotById[objectId[slot]] = slot;
+    return { slot, m_generation[slot] };
+}
+
+
+bool EntityStore::Destroy(EntityHandle entity) {
+    if (!IsAlive(entity)) return false;
+
+    m_alive[entity.index] = 0;
+    ++m_generation[entity.index];
+    m_slotById.erase(objectId[entity.index]);
+    descriptorIndex[entity.index] = -1;
+    parent[entity.index] = EntityHandle();
+    isStatic[entity.index] = 0;
+    m_freeSlots.push_back(entity.index);
+    return true;
+}
+
+
+bool EntityStore::AssignObjectId(uint32_t slot, uint32_t id) {
+    if (!IsSlotAlive(slot) || id == 0) return false;
+    if (objectId[slot] == id) return true;
+    if (!m_slotById.emplace(id, slot).second) return false;
+
+    m_slotById.erase(objectId[slot]);
+    objectId[slot] = id;
+    return true;
+}
+
+
+void EntityStore::Clear() {
+    // generations keep counting, so handles from before stay stale
+    for (uint32_t slot = 0; slot < m_generation.size(); ++slot) {
+        if (m_alive[slot]) Destroy(HandleAt(slot));
+    }
+    // hand slots out from 0 again, in order
+    m_freeSlots.clear();
+    for (size_t slot = m_generation.size(); slot-- > 0;)
+        m_freeSlots.push_back(static_cast<uint32_t>(slot));
+}
+
+
+// --- Enhancement: Start over from another store's generations ---
+void EntityStore::Clear(const std::vector<uint32_t>& previousGenerations) {
+    // bumping every slot covers the ones that were alive over there
+    *this = EntityStore();
+    m_generation = previousGenerations;
+    for (uint32_t& generation : m_generation) ++generation;
+
+    size_t capacity = m_generation.size();
+    m_alive.assign(capacity, 0);
+    localPosition.resize(capacity);
+    localRotation.resize(capacity);
+    localScale.resize(capacity, glm::vec3(1.0f));
+    parent.resize(capacity);
+    worldPosition.resize(capacity);
+    boundingRadius.resize(capacity, 0.0f);
+    descriptorIndex.resize(capacity, -1);
+    tagId.resize(capacity, 0);
+    isStatic.resize(capacity, 0);
+    objectId.resize(capacity, 0);
+    Clear();
+}
+
+
+glm::mat4 EntityStore::LocalMatrix(uint32_t slot) const {
+    const glm::vec3& rotation = localRotation[slot];
+    return glm::translate(localPosition[slot]) *
+        glm::rotate(glm::radians(rotation.x), glm::vec3(1.0f, 0.0f, 0.0f)) *
+        glm::rotate(glm::radians(rotation.y), glm::vec3(0.0f, 1.0f, 0.0f)) *
+        glm::rotate(glm::radians(rotation.z), glm::vec3(0.0f, 0.0f, 1.0f)) *
+        glm::scale(localScale[slot]);
+}
+
+
+uint32_t EntityStore::InternTag(const std::string& tag) {
+    auto it = m_tagIds.find(tag);
+    if (it != m_tagIds.end()) return it->second;
+
+    uint32_t id = static_cast<uint32_t>(m_tagNames.size());
+    m_tagNames.push_back(tag);
+    m_tagIds.emplace(tag, id);
+    return id;
+}
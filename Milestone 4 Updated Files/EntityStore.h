@@ -0,0 +1,136 @@
+/***********************************************************
+ *
+ *  EntityStore.h
+ *	============
+ *  scene objects as generational handles and SoA components
+ *
+ ***********************************************************/
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+
+
+// --- Enhancement: Stable reference to a scene object ---
+// The index is the entity's slot in every component array. The generation
+// is bumped each time the slot is freed, so a handle to a removed object
+// is recognized as stale instead of silently pointing at its successor.
+struct EntityHandle {
+    uint32_t index = UINT32_MAX;
+    uint32_t generation = 0;
+
+    bool IsNull() const { return index == UINT32_MAX; }
+    bool operator==(const EntityHandle& other) const {
+        return index == other.index && generation == other.generation;
+    }
+    bool operator!=(const EntityHandle& other) const { return !(*this == other); }
+};
+
+
+/***********************************************************
+ *  EntityStore
+ *
+ *  Scene objects stored component by component. Each array
+ *  below has one entry per slot, so a pass only streams the
+ *  arrays it reads: culling the bounds, the transform update
+ *  the transform and render arrays, command generation the
+ *  render arrays. Slots of removed objects are recycled, and
+ *  handles (never pointers) are what other systems keep.
+ ***********************************************************/
+class EntityStore {
+public:
+    // --- transform: position, rotation (degrees about X, Y, Z) and scale
+    // relative to the parent, if any ---
+    std::vector<glm::vec3> localPosition;
+    std::vector<glm::vec3> localRotation;
+    std::vector<glm::vec3> localScale;
+    std::vector<EntityHandle> parent;
+
+    // --- bounds: derived world position and culling radius ---
+    std::vector<glm::vec3> worldPosition;
+    std::vector<float> boundingRadius;
+
+    // --- render: index into SceneManager's descriptor table, or -1 ---
+    std::vector<int> descriptorIndex;
+
+    // --- tag: interned object tag, see TagName() ---
+    std::vector<uint32_t> tagId;
+
+    // --- batching: 1 = never moves, may be merged into a static batch ---
+    std::vector<uint8_t> isStatic;
+
+    // --- identity: persistent ID, saved with the object; never 0. Set
+    // with AssignObjectId(), which keeps the ID index in step ---
+    std::vector<uint32_t> objectId;
+
+    // Creates an entity with default components and a new object ID, and
+    // returns its handle
+    EntityHandle Create(const glm::vec3& position, float radius, const std::string& tag);
+
+    // New object IDs start above `id`, so IDs taken from a save stay unique
+    void ReserveObjectIds(uint32_t id) { if (id >= m_nextObjectId) m_nextObjectId = id + 1; }
+
+    // Gives a live entity the object ID `id` in place of its own; false,
+    // and nothing changes, if another live entity has it
+    bool AssignObjectId(uint32_t slot, uint32_t id);
+
+    // Live entity with an object ID, or a null handle
+    EntityHandle FindObject(uint32_t id) const {
+        auto it = m_slotById.find(id);
+        return it != m_slotById.end() ? HandleAt(it->second) : EntityHandle();
+    }
+
+    // Frees the entity's slot; its handles become stale. False if already stale.
+    bool Destroy(EntityHandle entity);
+
+    // Removes every entity; all existing handles become stale
+    void Clear();
+
+    // Removes every entity and takes over the slot generations of a store
+    // this one replaces, so that store's handles are stale here as well
+    void Clear(const std::vector<uint32_t>& previousGenerations);
+
+    bool IsAlive(EntityHandle entity) const {
+        return entity.index < m_generation.size() && m_alive[entity.index] &&
+            m_generation[entity.index] == entity.generation;
+    }
+    bool IsSlotAlive(uint32_t slot) const { return slot < m_alive.size() && m_alive[slot] != 0; }
+
+    // Transform of a slot relative to its parent: translation, then the X,
+    // Y and Z rotations, then scale, the order of the descriptors' shapes
+    glm::mat4 LocalMatrix(uint32_t slot) const;
+
+    // Handle of the entity currently in a slot
+    EntityHandle HandleAt(uint32_t slot) const { return { slot, m_generation[slot] }; }
+
+    // Slots in use, including free ones; the size of every component array
+    size_t Capacity() const { return m_generation.size(); }
+    size_t Count() const { return m_generation.size() - m_freeSlots.size(); }
+
+    // Current generation of every slot, and 1 for every slot in use
+    const std::vector<uint32_t>& Generations() const { return m_generation; }
+    const std::vector<uint8_t>& AliveSlots() const { return m_alive; }
+
+    // Tag strings are stored once and referred to by ID
+    uint32_t InternTag(const std::string& tag);
+    const std::string& TagName(uint32_t id) const { return m_tagNames[id]; }
+    size_t TagCount() const { return m_tagNames.size(); }
+
+private:
+    std::vector<uint32_t> m_generation;
+    std::vector<uint8_t> m_alive;
+    std::vector<uint32_t> m_freeSlots;
+
+    std::vector<std::string> m_tagNames;
+    std::unordered_map<std::string, uint32_t> m_tagIds;
+
+    // slot of every live entity by object ID, kept by Create(), Destroy()
+    // and AssignObjectId()
+    std::unordered_map<uint32_t, uint32_t> m_slotById;
+
+    uint32_t m_nextObjectId = 1;
+};
@@ -0,0 +1,87 @@
+/***********************************************************
+ *
+ *  FrameBudget.cpp
+ *	============
+ *  trades render quality for frame time to hold a target
+ *
+ ***********************************************************/
+
+#include "FrameBudget.h"
+#include <algorithm>
+
+
+namespace
+{
+    // weight of the newest frame in the smoothed cost
+    const double SMOOTHING = 0.2;
+}
+
+
+FrameBudget::FrameBudget()
+    : m_targetMs(0.0), m_smoothedMs(0.0), m_quality(1.0f),
+      m_overFrames(0), m_underFrames(0), m_settleFrames(0) {
+    m_full = { 15.0f, 0.0f, 0.0f };
+    m_lowest = m_full;
+    Apply();
+}
+
+
+void FrameBudget::SetLimits(const QualitySettings& full, const QualitySettings& lowest) {
+    m_full = full;
+    m_lowest = lowest;
+    Apply();
+}
+
+
+void FrameBudget::SetTarget(double frameMs) {
+    m_targetMs = std::max(frameMs, 0.0);
+    m_smoothedMs = 0.0;
+    m_overFrames = m_underFrames = m_settleFrames = 0;
+    if (!IsEnabled()) {
+        m_quality = 1.0f;
+        Apply();
+    }
+}
+
+
+// --- Enhancement: One control step, with a dead band between the thresholds ---
+bool FrameBudget::Update(double cpuMs, double gpuMs) {
+    if (!IsEnabled()) return false;
+
+    // CPU and GPU overlap, so the slower of the two sets the frame time
+    double cost = std::max(cpuMs, gpuMs);
+    m_smoothedMs = m_smoothedMs > 0.0 ? m_smoothedMs + SMOOTHING * (cost - m_smoothedMs) : cost;
+
+    if (m_settleFrames > 0) {
+        --m_settleFrames;
+        return false;
+    }
+
+    if (m_smoothedMs > m_targetMs) {
+        m_underFrames = 0;
+        if (++m_overFrames < LOWER_AFTER_FRAMES || m_quality <= 0.0f) return false;
+        m_quality = std::max(m_quality - LOWER_STEP, 0.0f);
+    }
+    else if (m_smoothedMs < m_targetMs * RAISE_BELOW) {
+        m_overFrames = 0;
+        if (++m_underFrames < RAISE_AFTER_FRAMES || m_quality >= 1.0f) return false;
+        m_quality = std::min(m_quality + RAISE_STEP, 1.0f);
+    }
+    else {
+        m_overFrames = m_underFrames = 0;
+        return false;
+    }
+
+    m_overFrames = m_underFrames = 0;
+    m_settleFrames = SETTLE_FRAMES;
+    Apply();
+    return true;
+}
+
+
+void FrameBudget::Apply() {
+    float t = m_quality;
+    m_settings.viewRange = m_lowest.viewRange + t * (m_full.viewRange - m_lowest.viewRange);
+    m_settings.lodBias = m_lowest.lodBias + t * (m_full.lodBias - m_lowest.lodBias);
+    m_settings.smallObjectCull = m_lowest.smallObjectCull + t * (m_full.smallObjectCull - m_lowest.smallObjectCull);
+}
@@ -0,0 +1,80 @@
+/***********************************************************
+ *
+ *  FrameBudget.h
+ *	============
+ *  trades render quality for frame time to hold a target
+ *
+ ***********************************************************/
+
+#pragma once
+
+
+// --- Enhancement: The knobs FrameBudget turns ---
+struct QualitySettings {
+    float viewRange;        // half size of the culling box around the camera
+    float lodBias;          // 0 = pick LOD by screen size; +1 treats objects as half their size
+    float smallObjectCull;  // objects whose radius / distance is below this are not drawn
+};
+
+
+/***********************************************************
+ *  FrameBudget
+ *
+ *  Holds a target frame time by moving a single quality level
+ *  between 1 (full settings) and 0 (lowest settings); the
+ *  view range, LOD bias and small-object threshold are all
+ *  interpolated from that level. The cost of a frame is the
+ *  larger of its CPU and GPU time, smoothed over a few frames.
+ *
+ *  Quality does not oscillate because of three kinds of
+ *  hysteresis: it is lowered only when the cost has been over
+ *  the target for several frames, and raised only when it has
+ *  been well under the target for much longer; costs between
+ *  the two thresholds change nothing. After every change the
+ *  controller waits for the GPU timings to catch up.
+ ***********************************************************/
+class FrameBudget {
+public:
+    // Fraction of the target a frame must stay under before quality is raised
+    static constexpr double RAISE_BELOW = 0.75;
+    // Frames over / under the thresholds before a step is taken
+    static const int LOWER_AFTER_FRAMES = 5;
+    static const int RAISE_AFTER_FRAMES = 60;
+    // Frames to wait after a step, longer than GpuTimer::LATENCY
+    static const int SETTLE_FRAMES = 8;
+    // Quality lost / regained per step: down quickly, up carefully
+    static constexpr float LOWER_STEP = 0.1f;
+    static constexpr float RAISE_STEP = 0.05f;
+
+    FrameBudget();
+
+    // Settings at quality 1 and 0
+    void SetLimits(const QualitySettings& full, const QualitySettings& lowest);
+
+    // Frame time to hold, in milliseconds; 0 turns the controller off
+    // and goes back to full quality
+    void SetTarget(double frameMs);
+    double Target() const { return m_targetMs; }
+    bool IsEnabled() const { return m_targetMs > 0.0; }
+
+    // Feeds the cost of the last frame; returns true if the settings changed
+    bool Update(double cpuMs, double gpuMs);
+
+    const QualitySettings& Settings() const { return m_settings; }
+    float Quality() const { return m_quality; }
+    double SmoothedMs() const { return m_smoothedMs; }
+
+private:
+    void Apply();
+
+    QualitySettings m_full;
+    QualitySettings m_lowest;
+    QualitySettings m_settings;
+
+    double m_targetMs;
+    double m_smoothedMs;
+    float m_quality;
+    int m_overFrames;
+    int m_underFrames;
+    int m_settleFrames;
+};
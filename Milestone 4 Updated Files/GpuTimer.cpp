@@ -0,0 +1,70 @@
+/***********************************************************
+ *
+ *  GpuTimer.cpp
+ *	============
+ *  GPU time of a span of commands, read back without stalling
+ *
+ ***********************************************************/
+
+#include "GpuTimer.h"
+
+
+GpuTimer::GpuTimer() : m_created(false), m_write(0), m_pending(0), m_timing(false), m_lastMs(0.0) {
+}
+
+GpuTimer::~GpuTimer() {
+    Destroy();
+}
+
+
+void GpuTimer::Begin() {
+    if (!m_created) {
+        glGenQueries(LATENCY * 2, &m_queries[0][0]);
+        m_created = true;
+    }
+
+    // every query is still in flight: skip this span instead of stalling
+    Poll();
+    m_timing = m_pending < LATENCY;
+    if (m_timing)
+        glQueryCounter(m_queries[m_write][0], GL_TIMESTAMP);
+}
+
+
+void GpuTimer::End() {
+    if (!m_timing) return;
+    m_timing = false;
+
+    glQueryCounter(m_queries[m_write][1], GL_TIMESTAMP);
+    m_write = (m_write + 1) % LATENCY;
+    ++m_pending;
+}
+
+
+// --- Enhancement: Read the finished spans, oldest first ---
+bool GpuTimer::Poll() {
+    bool finished = false;
+    while (m_pending > 0) {
+        int read = (m_write - m_pending + LATENCY) % LATENCY;
+        GLint available = 0;
+        glGetQueryObjectiv(m_queries[read][1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) break;
+
+        GLuint64 start = 0, end = 0;
+        glGetQueryObjectui64v(m_queries[read][0], GL_QUERY_RESULT, &start);
+        glGetQueryObjectui64v(m_queries[read][1], GL_QUERY_RESULT, &end);
+        m_lastMs = (end - start) / 1.0e6;
+        --m_pending;
+        finished = true;
+    }
+    return finished;
+}
+
+
+void GpuTimer::Destroy() {
+    if (!m_created) return;
+    glDeleteQueries(LATENCY * 2, &m_queries[0][0]);
+    m_created = false;
+    m_write = m_pending = 0;
+    m_timing = false;
+}
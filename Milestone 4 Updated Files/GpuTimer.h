@@ -0,0 +1,51 @@
+/***********************************************************
+ *
+ *  GpuTimer.h
+ *	============
+ *  GPU time of a span of commands, read back without stalling
+ *
+ ***********************************************************/
+
+#pragma once
+#include <GL/glew.h>
+
+
+/***********************************************************
+ *  GpuTimer
+ *
+ *  Brackets a span of GL commands with timestamp queries.
+ *  The GPU runs a few frames behind the CPU, so the queries
+ *  of the last LATENCY spans are kept in flight and a result
+ *  is only read once the GPU has written it. LastMs() is
+ *  therefore the time of a span from a few frames ago. If
+ *  every query is still in flight, a span is not timed rather
+ *  than waiting for the GPU.
+ ***********************************************************/
+class GpuTimer {
+public:
+    static const int LATENCY = 4;
+
+    GpuTimer();
+    ~GpuTimer();
+
+    // Mark the start and end of the span to time
+    void Begin();
+    void End();
+
+    // Reads every finished span; true if at least one finished since the last call
+    bool Poll();
+
+    // GPU time of the most recent finished span, in milliseconds (0 = none yet)
+    double LastMs() const { return m_lastMs; }
+
+    // Deletes the queries
+    void Destroy();
+
+private:
+    GLuint m_queries[LATENCY][2];   // start and end timestamp of each span
+    bool m_created;
+    int m_write;                    // next span to record
+    int m_pending;                  // spans recorded but not read yet
+    bool m_timing;                  // Begin() recorded a start this span
+    double m_lastMs;
+};
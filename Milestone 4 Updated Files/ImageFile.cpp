@@ -0,0 +1,248 @@
+/***********************************************************
+ *
+ *  ImageFile.cpp
+ *	============
+ *  PNG files for frame dumps and reference image comparison
+ *
+ ***********************************************************/
+
+#include "ImageFile.h"
+#include "stb_image.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+
+namespace
+{
+    // --- Enhancement: Checksums of the PNG container and the zlib stream ---
+    uint32_t Crc32(const unsigned char* data, size_t size, uint32_t crc = 0) {
+        static uint32_t table[256];
+        static bool tableReady = false;
+        if (!tableReady) {
+            for (uint32_t n = 0; n < 256; ++n) {
+                uint32_t c = n;
+                for (int k = 0; k < 8; ++k)
+                    c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                table[n] = c;
+            }
+            tableReady = true;
+        }
+        crc = ~crc;
+        for (size_t i = 0; i < size; ++i)
+            crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        return ~crc;
+    }
+
+    uint32_t Adler32(const std::vector<unsigned char>& data) {
+        uint32_t a = 1, b = 0;
+        for (unsigned char byte : data) {
+            a = (a + byte) % 65521;
+            b = (b + a) % 65521;
+        }
+        return (b << 16) | a;
+    }
+
+    // Writes deflate's bit stream, least significant bit first
+    class BitWriter {
+    public:
+        explicit BitWriter(std::vector<unsigned char>& out) : m_out(out), m_bits(0), m_count(0) {}
+
+        void Write(uint32_t value, int count) {
+            m_bits |= value << m_count;
+            m_count += count;
+            while (m_count >= 8) {
+                m_out.push_back(static_cast<unsigned char>(m_bits));
+                m_bits >>= 8;
+                m_count -= 8;
+            }
+        }
+
+        // Huffman codes are defined most significant bit first
+        void WriteCode(uint32_t code, int length) {
+            uint32_t reversed = 0;
+            for (int i = 0; i < length; ++i)
+                reversed |= ((code >> i) & 1) << (length - 1 - i);
+            Write(reversed, length);
+        }
+
+        void Flush() {
+            if (m_count > 0) m_out.push_back(static_cast<unsigned char>(m_bits));
+            m_bits = 0;
+            m_count = 0;
+        }
+
+    private:
+        std::vector<unsigned char>& m_out;
+        uint32_t m_bits;
+        int m_count;
+    };
+
+    const int LENGTH_BASE[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                  35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+    const int LENGTH_EXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                   3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+    const int DISTANCE_BASE[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+                                    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+                                    8193, 12289, 16385, 24577 };
+    const int DISTANCE_EXTRA[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+                                     7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+    // Literal/length symbol in the fixed Huffman code
+    void WriteSymbol(BitWriter& bits, int symbol) {
+        if (symbol < 144) bits.WriteCode(0x30 + symbol, 8);
+        else if (symbol < 256) bits.WriteCode(0x190 + symbol - 144, 9);
+        else if (symbol < 280) bits.WriteCode(symbol - 256, 7);
+        else bits.WriteCode(0xC0 + symbol - 280, 8);
+    }
+
+    void WriteMatch(BitWriter& bits, int length, int distance) {
+        int code = 28;
+        while (LENGTH_BASE[code] > length) --code;
+        WriteSymbol(bits, 257 + code);
+        bits.Write(length - LENGTH_BASE[code], LENGTH_EXTRA[code]);
+
+        code = 29;
+        while (DISTANCE_BASE[code] > distance) --code;
+        bits.WriteCode(code, 5);
+        bits.Write(distance - DISTANCE_BASE[code], DISTANCE_EXTRA[code]);
+    }
+
+    // --- Enhancement: zlib stream of one fixed-Huffman block, greedy LZ77 ---
+    // Only the most recent position of each 3-byte hash is remembered,
+    // which finds the long runs of a flat-colored frame cheaply.
+    std::vector<unsigned char> Deflate(const std::vector<unsigned char>& data) {
+        const int WINDOW = 32768;
+        const int MIN_MATCH = 3;
+        const int MAX_MATCH = 258;
+        const int HASH_BITS = 15;
+
+        std::vector<unsigned char> out = { 0x78, 0x01 };
+        BitWriter bits(out);
+        bits.Write(1, 1);   // final block
+        bits.Write(1, 2);   // fixed Huffman codes
+
+        std::vector<int> head(1 << HASH_BITS, -1);
+        const size_t size = data.size();
+        size_t pos = 0;
+        while (pos < size) {
+            int bestLength = 0;
+            int bestDistance = 0;
+            if (pos + MIN_MATCH <= size) {
+                uint32_t hash = ((data[pos] << 10) ^ (data[pos + 1] << 5) ^ data[pos + 2]) & ((1 << HASH_BITS) - 1);
+                int candidate = head[hash];
+                head[hash] = static_cast<int>(pos);
+                if (candidate >= 0 && pos - candidate <= WINDOW) {
+                    int limit = static_cast<int>(std::min<size_t>(MAX_MATCH, size - pos));
+                    int length = 0;
+                    while (length < limit && data[candidate + length] == data[pos + length]) ++length;
+                    if (length >= MIN_MATCH) {
+                        bestLength = length;
+                        bestDistance = static_cast<int>(pos - candidate);
+                    }
+                }
+            }
+
+            if (bestLength > 0) {
+                WriteMatch(bits, bestLength, bestDistance);
+                pos += bestLength;
+            }
+            else {
+                WriteSymbol(bits, data[pos]);
+                ++pos;
+            }
+        }
+        WriteSymbol(bits, 256);  // end of block
+        bits.Flush();
+
+        uint32_t adler = Adler32(data);
+        for (int shift = 24; shift >= 0; shift -= 8)
+            out.push_back(static_cast<unsigned char>(adler >> shift));
+        return out;
+    }
+
+    void AppendBigEndian(std::vector<unsigned char>& out, uint32_t value) {
+        for (int shift = 24; shift >= 0; shift -= 8)
+            out.push_back(static_cast<unsigned char>(value >> shift));
+    }
+
+    void WriteChunk(std::ofstream& file, const char* type, const std::vector<unsigned char>& data) {
+        std::vector<unsigned char> chunk;
+        AppendBigEndian(chunk, static_cast<uint32_t>(data.size()));
+        chunk.insert(chunk.end(), type, type + 4);
+        chunk.insert(chunk.end(), data.begin(), data.end());
+        AppendBigEndian(chunk, Crc32(chunk.data() + 4, chunk.size() - 4));
+        file.write(reinterpret_cast<const char*>(chunk.data()), chunk.size());
+    }
+}
+
+
+// --- Enhancement: 8-bit RGBA PNG, every row Up-filtered ---
+bool ImageFile::WritePng(const std::string& filename, int width, int height,
+                         const std::vector<unsigned char>& rgba) {
+    const size_t stride = static_cast<size_t>(width) * 4;
+    if (width <= 0 || height <= 0 || rgba.size() < stride * height) return false;
+
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) return false;
+
+    // Up filter: each byte minus the one above it, so identical rows become zeros
+    std::vector<unsigned char> filtered;
+    filtered.reserve((stride + 1) * height);
+    for (int y = 0; y < height; ++y) {
+        const unsigned char* row = &rgba[y * stride];
+        filtered.push_back(2);
+        for (size_t x = 0; x < stride; ++x) {
+            unsigned char above = y > 0 ? rgba[(y - 1) * stride + x] : 0;
+            filtered.push_back(static_cast<unsigned char>(row[x] - above));
+        }
+    }
+
+    const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    file.write(reinterpret_cast<const char*>(signature), sizeof(signature));
+
+    std::vector<unsigned char> header;
+    AppendBigEndian(header, static_cast<uint32_t>(width));
+    AppendBigEndian(header, static_cast<uint32_t>(height));
+    header.push_back(8);    // bits per channel
+    header.push_back(6);    // RGBA
+    header.push_back(0);    // deflate
+    header.push_back(0);    // adaptive filtering
+    header.push_back(0);    // not interlaced
+    WriteChunk(file, "IHDR", header);
+    WriteChunk(file, "IDAT", Deflate(filtered));
+    WriteChunk(file, "IEND", std::vector<unsigned char>());
+    return file.good();
+}
+
+
+bool ImageFile::ReadPng(const std::string& filename, int& width, int& height,
+                        std::vector<unsigned char>& rgba) {
+    // the texture loader flips images for OpenGL; frames are kept top row first
+    stbi_set_flip_vertically_on_load(false);
+    int channels = 0;
+    unsigned char* image = stbi_load(filename.c_str(), &width, &height, &channels, 4);
+    if (!image) return false;
+
+    rgba.assign(image, image + static_cast<size_t>(width) * height * 4);
+    stbi_image_free(image);
+    return true;
+}
+
+
+ImageDiff ImageFile::Compare(const std::vector<unsigned char>& a,
+                             const std::vector<unsigned char>& b,
+                             int channelThreshold) {
+    ImageDiff diff;
+    size_t pixels = std::min(a.size(), b.size()) / 4;
+    diff.pixelCount = static_cast<uint32_t>(pixels);
+    for (size_t p = 0; p < pixels; ++p) {
+        int pixelError = 0;
+        for (int c = 0; c < 4; ++c)
+            pixelError = std::max(pixelError, std::abs(a[p * 4 + c] - b[p * 4 + c]));
+        diff.maxChannelError = std::max(diff.maxChannelError, pixelError);
+        if (pixelError > channelThreshold) ++diff.differingPixels;
+    }
+    return diff;
+}
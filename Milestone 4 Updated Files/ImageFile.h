@@ -0,0 +1,50 @@
+/***********************************************************
+ *
+ *  ImageFile.h
+ *	============
+ *  PNG files for frame dumps and reference image comparison
+ *
+ ***********************************************************/
+
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+// --- Enhancement: How far two images of the same size are apart ---
+struct ImageDiff {
+    uint32_t pixelCount = 0;
+    uint32_t differingPixels = 0;   // pixels with a channel off by more than the threshold
+    int maxChannelError = 0;        // largest difference of any channel, 0..255
+
+    double DifferingFraction() const {
+        return pixelCount ? static_cast<double>(differingPixels) / pixelCount : 0.0;
+    }
+};
+
+
+/***********************************************************
+ *  ImageFile
+ *
+ *  Reads and writes 8-bit RGBA images, rows top to bottom.
+ *  PNGs are written with the Up filter and a small LZ77
+ *  encoder using deflate's fixed Huffman codes: nowhere near
+ *  zlib's ratio, but rendered frames are mostly flat color
+ *  and shrink well, without adding a compression library.
+ *  Reading goes through stb_image, which the textures
+ *  already use.
+ ***********************************************************/
+class ImageFile {
+public:
+    static bool WritePng(const std::string& filename, int width, int height,
+                         const std::vector<unsigned char>& rgba);
+    static bool ReadPng(const std::string& filename, int& width, int& height,
+                        std::vector<unsigned char>& rgba);
+
+    // Compares two RGBA images of the same size; a pixel differs when
+    // any channel is off by more than channelThreshold
+    static ImageDiff Compare(const std::vector<unsigned char>& a,
+                             const std::vector<unsigned char>& b,
+                             int channelThreshold);
+};
@@ -1,8 +1,17 @@
 #include "JsonDatabase.h"
+#include <cstdio>
+#include <filesystem>
 #include <fstream>
 #include <vector>
 #include <glm/glm.hpp>
 
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 /***********************************************************
  *					*** ENHANCEMENT ***
  *                  *** MILESTONE 4 ***
@@ -29,12 +38,30 @@ static void to_json(json& j, const SceneObject& obj) {
         {"boundingRadius", obj.boundingRadius},
         {"tag", obj.tag}
     };
+    // Enhancement: only child objects store a parent, so flat scenes
+    // are saved exactly as before
+    if (obj.parentIndex >= 0) j["parent"] = obj.parentIndex;
+    if (obj.isStatic) j["static"] = true;
+    if (obj.id != 0) j["id"] = obj.id;
+    if (obj.rotation != glm::vec3(0.0f)) j["rotation"] = { obj.rotation.x, obj.rotation.y, obj.rotation.z };
+    if (obj.scale != glm::vec3(1.0f)) j["scale"] = { obj.scale.x, obj.scale.y, obj.scale.z };
 }
 static void from_json(const json& j, SceneObject& obj) {
     auto pos = j.at("position");
     obj.position = glm::vec3(pos[0], pos[1], pos[2]);
     obj.boundingRadius = j.at("boundingRadius").get<float>();
     obj.tag = j.at("tag").get<std::string>();
+    obj.parentIndex = j.value("parent", -1);
+    obj.isStatic = j.value("static", false);
+    obj.id = j.value("id", 0u);
+    if (j.contains("rotation")) {
+        auto rotation = j.at("rotation");
+        obj.rotation = glm::vec3(rotation[0], rotation[1], rotation[2]);
+    }
+    if (j.contains("scale")) {
+        auto scale = j.at("scale");
+        obj.scale = glm::vec3(scale[0], scale[1], scale[2]);
+    }
 }
 
 // --- CameraState serialization ---
@@ -59,16 +86,63 @@ static void from_json(const json& j, CameraState& cam) {
     cam.zoom = j.at("zoom").get<float>();
 }
 
+// --- Atomic file replacement ---
+// Enhancement: saves go to a temporary file next to the target, which is
+// renamed over it only once fully written, so a crash or a failed write
+// never leaves a truncated save behind.
+
+// Pushes a written file's contents to the disk; without this, the rename
+// can reach the disk first and a power loss leaves an empty file behind
+static bool SyncFile(std::FILE* file) {
+    if (std::fflush(file) != 0) return false;
+#if defined(_WIN32)
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+// The rename is a change to the directory, which POSIX only makes
+// durable when the directory itself is synced
+static void SyncDirectory(const std::string& filename) {
+#if !defined(_WIN32)
+    std::string directory = std::filesystem::path(filename).parent_path().string();
+    int descriptor = open(directory.empty() ? "." : directory.c_str(), O_RDONLY);
+    if (descriptor < 0) return;
+    fsync(descriptor);
+    close(descriptor);
+#endif
+}
+
+static bool WriteFileAtomically(const std::string& filename, const std::string& contents) {
+    std::string tempName = filename + ".tmp";
+    std::FILE* file = std::fopen(tempName.c_str(), "wb");
+    if (!file) return false;
+    bool written = std::fwrite(contents.data(), 1, contents.size(), file) == contents.size() && SyncFile(file);
+    written = std::fclose(file) == 0 && written;
+    if (!written) {
+        std::remove(tempName.c_str());
+        return false;
+    }
+
+    // replaces an existing file on every platform, unlike std::rename
+    std::error_code error;
+    std::filesystem::rename(tempName, filename, error);
+    if (error) {
+        std::remove(tempName.c_str());
+        return false;
+    }
+    SyncDirectory(filename);
+    return true;
+}
+
 // --- Save/load scene objects only ---
 // Enhancement: Implements saving/loading
 // of scene objects to/from JSON.
 
 bool JsonDatabase::SaveSceneObjects(const std::vector<SceneObject>& objects, const std::string& filename) {
     json j = objects;
-    std::ofstream file(filename);
-    if (!file.is_open()) return false;
-    file << j.dump(4);
-    return true;
+    return WriteFileAtomically(filename, j.dump(4));
 }
 
 bool JsonDatabase::LoadSceneObjects(std::vector<SceneObject>& objects, const std::string& filename) {
@@ -93,10 +167,7 @@ bool JsonDatabase::SaveSceneAndCamera(const std::vector<SceneObject>& objects, c
     json j;
     j["objects"] = objects;
     j["camera"] = camera;
-    std::ofstream file(filename);
-    if (!file.is_open()) return false;
-    file << j.dump(4);
-    return true;
+    return WriteFileAtomically(filename, j.dump(4));
 }
 
 bool JsonDatabase::LoadSceneAndCamera(std::vector<SceneObject>& objects, CameraState& camera, const std::string& filename) {
@@ -113,3 +184,27 @@ bool JsonDatabase::LoadSceneAndCamera(std::vector<SceneObject>& objects, CameraS
     }
     return true;
 }
+
+// --- Load a camera path ---
+// Enhancement: { "keys": [ { "frame": 0, "camera": { ... } }, ... ] },
+// each camera in the same format as the saved scene camera.
+
+bool JsonDatabase::LoadCameraPath(std::vector<CameraKey>& keys, const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) return false;
+    json j;
+    try {
+        file >> j;
+        keys.clear();
+        for (const json& key : j.at("keys")) {
+            CameraKey cameraKey;
+            cameraKey.frame = key.at("frame").get<int>();
+            cameraKey.camera = key.at("camera").get<CameraState>();
+            keys.push_back(cameraKey);
+        }
+    }
+    catch (...) {
+        return false;
+    }
+    return !keys.empty();
+}
@@ -28,6 +28,14 @@ struct CameraState {
     float zoom;
 };
 
+// --- Camera path keyframe ---
+// Enhancement: a scripted camera path for headless runs is a list of
+// camera states, each pinned to the frame it is reached on.
+struct CameraKey {
+    int frame;
+    CameraState camera;
+};
+
 
 class JsonDatabase {
 public:
@@ -37,4 +45,7 @@ public:
     // --- Save/load scene + camera ---
     static bool SaveSceneAndCamera(const std::vector<SceneObject>& objects, const CameraState& camera, const std::string& filename);
     static bool LoadSceneAndCamera(std::vector<SceneObject>& objects, CameraState& camera, const std::string& filename);
+
+    // --- Load a camera path ---
+    static bool LoadCameraPath(std::vector<CameraKey>& keys, const std::string& filename);
 };
@@ -0,0 +1,131 @@
+/***********************************************************
+ *  LightManager Implementation
+ *
+ *  Implements the light storage and the dirty-range upload
+ *  of lights into the LightBlock uniform buffer.
+ ***********************************************************/
+
+#include "LightManager.h"
+#include <algorithm>
+#include <iostream>
+
+
+namespace
+{
+    // LightBlock starts with an ivec4 holding the light count,
+    // followed by the array of lights
+    const GLsizeiptr LIGHT_HEADER_SIZE = 4 * sizeof(GLint);
+}
+
+
+LightManager::LightManager()
+    : m_dirtyBegin(MAX_LIGHTS), m_dirtyEnd(0), m_countDirty(true), m_lightBuffer(0) {
+}
+
+LightManager::~LightManager() {
+    DestroyLightBuffer(); // Ensure the uniform buffer is cleaned up
+}
+
+int LightManager::AddLight(const LightSource& light) {
+    // Adds a light at the end of the list and marks its slot dirty
+    if (static_cast<int>(m_lights.size()) >= MAX_LIGHTS) {
+        std::cout << "Too many lights, max is " << MAX_LIGHTS << std::endl;
+        return -1;
+    }
+    m_lights.push_back(light);
+    int index = static_cast<int>(m_lights.size()) - 1;
+    MarkDirty(index);
+    m_countDirty = true;
+    return index;
+}
+
+bool LightManager::RemoveLight(int index) {
+    // Removes a light; every light after it shifts down, so the whole tail is dirty
+    if (index < 0 || index >= static_cast<int>(m_lights.size())) return false;
+    m_lights.erase(m_lights.begin() + index);
+    for (int i = index; i < static_cast<int>(m_lights.size()); ++i) {
+        MarkDirty(i);
+    }
+    m_countDirty = true;
+    return true;
+}
+
+void LightManager::SetLight(int index, const LightSource& light) {
+    // Replaces one light and marks only its slot dirty
+    if (index < 0 || index >= static_cast<int>(m_lights.size())) return;
+    m_lights[index] = light;
+    MarkDirty(index);
+}
+
+void LightManager::SetLightPosition(int index, const glm::vec3& position) {
+    // Moves one light and marks only its slot dirty
+    if (index < 0 || index >= static_cast<int>(m_lights.size())) return;
+    m_lights[index].position = position;
+    MarkDirty(index);
+}
+
+const LightSource* LightManager::GetLight(int index) const {
+    // Returns the light at the given index without copying it
+    if (index < 0 || index >= static_cast<int>(m_lights.size())) return nullptr;
+    return &m_lights[index];
+}
+
+void LightManager::Clear() {
+    // Removes all lights; only the count needs to reach the shader
+    m_lights.clear();
+    m_dirtyBegin = MAX_LIGHTS;
+    m_dirtyEnd = 0;
+    m_countDirty = true;
+}
+
+void LightManager::MarkDirty(int index) {
+    // Packs the light into its std140 slot right away, so the upload is a plain copy
+    const LightSource& light = m_lights[index];
+    m_packed[index].positionFocal = glm::vec4(light.position, light.focalStrength);
+    m_packed[index].ambientColorRange = glm::vec4(light.ambientColor, light.range);
+    m_packed[index].diffuseColorIntensity = glm::vec4(light.diffuseColor, light.specularIntensity);
+    m_packed[index].specularColor = glm::vec4(light.specularColor, 0.0f);
+
+    m_dirtyBegin = std::min(m_dirtyBegin, index);
+    m_dirtyEnd = std::max(m_dirtyEnd, index + 1);
+}
+
+void LightManager::UploadLightBuffer() {
+    // Uploads only what changed since the last call; nothing at all when clean
+    if (m_lightBuffer == 0) {
+        glGenBuffers(1, &m_lightBuffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, m_lightBuffer);
+        glBufferData(GL_UNIFORM_BUFFER, LIGHT_HEADER_SIZE + sizeof(m_packed), NULL, GL_DYNAMIC_DRAW);
+        glBindBufferBase(GL_UNIFORM_BUFFER, LIGHT_BLOCK_BINDING, m_lightBuffer);
+        m_countDirty = true;
+    }
+    else if (!m_countDirty && m_dirtyBegin >= m_dirtyEnd) {
+        return;
+    }
+    else {
+        glBindBuffer(GL_UNIFORM_BUFFER, m_lightBuffer);
+    }
+
+    if (m_countDirty) {
+        GLint header[4] = { static_cast<GLint>(m_lights.size()), 0, 0, 0 };
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, LIGHT_HEADER_SIZE, header);
+        m_countDirty = false;
+    }
+
+    if (m_dirtyBegin < m_dirtyEnd) {
+        glBufferSubData(GL_UNIFORM_BUFFER,
+            LIGHT_HEADER_SIZE + m_dirtyBegin * sizeof(LightStd140),
+            (m_dirtyEnd - m_dirtyBegin) * sizeof(LightStd140),
+            &m_packed[m_dirtyBegin]);
+        m_dirtyBegin = MAX_LIGHTS;
+        m_dirtyEnd = 0;
+    }
+
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void LightManager::DestroyLightBuffer() {
+    // Deletes the light uniform buffer from OpenGL
+    if (m_lightBuffer) glDeleteBuffers(1, &m_lightBuffer);
+    m_lightBuffer = 0;
+}
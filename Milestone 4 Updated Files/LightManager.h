@@ -0,0 +1,89 @@
+/***********************************************************
+ *  LightManager
+ *
+ *  This new class was added to centralize the scene's light
+ *  sources, following the same pattern as TextureManager
+ *  and MaterialManager. Lights are kept in a CPU-side array
+ *  that is mirrored into a uniform buffer; changing a light
+ *  only writes memory and marks it dirty, and only the dirty
+ *  range of lights is uploaded before the next frame.
+ ***********************************************************/
+
+#pragma once
+#include <vector>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+
+struct LightSource {
+    glm::vec3 position = glm::vec3(0.0f);
+    glm::vec3 ambientColor = glm::vec3(0.0f);
+    glm::vec3 diffuseColor = glm::vec3(0.0f);
+    glm::vec3 specularColor = glm::vec3(0.0f);
+    float focalStrength = 1.0f;
+    float specularIntensity = 0.0f;
+    // Enhancement: distance at which the light has faded out; 0 = lights
+    // the whole scene. Only lights with a range can be culled per pixel.
+    float range = 0.0f;
+};
+
+// Light as laid out in the shader's std140 LightBlock
+// (four vec4s, the scalar fields packed into the w components)
+struct LightStd140 {
+    glm::vec4 positionFocal;            // xyz = position, w = focalStrength
+    glm::vec4 ambientColorRange;        // xyz = ambientColor, w = range
+    glm::vec4 diffuseColorIntensity;    // xyz = diffuseColor, w = specularIntensity
+    glm::vec4 specularColor;            // xyz = specularColor
+};
+
+class LightManager {
+public:
+    // Must match MAX_LIGHTS and the binding in fragmentShader.glsl
+    static const int MAX_LIGHTS = 128;
+    static const GLuint LIGHT_BLOCK_BINDING = 1;
+
+    LightManager();   // Constructor
+    ~LightManager();  // Destructor
+
+    // Adds a light and returns its index, or -1 if the buffer is full
+    int AddLight(const LightSource& light);
+
+    // Removes a light; lights after it move down one index
+    bool RemoveLight(int index);
+
+    // Replaces all fields of a light
+    void SetLight(int index, const LightSource& light);
+
+    // Moves a light, for animated lights
+    void SetLightPosition(int index, const glm::vec3& position);
+
+    // Returns the light at the given index, or nullptr if out of range
+    const LightSource* GetLight(int index) const;
+
+    int LightCount() const { return static_cast<int>(m_lights.size()); }
+
+    // Removes all lights
+    void Clear();
+
+    // Uploads the dirty range of lights (and the light count, if it changed)
+    void UploadLightBuffer();
+
+    // Deletes the uniform buffer
+    void DestroyLightBuffer();
+
+private:
+    // Packs one light into its std140 slot and grows the dirty range
+    void MarkDirty(int index);
+
+    // Stores all lights, plus their packed copies mirrored into the buffer
+    std::vector<LightSource> m_lights;
+    LightStd140 m_packed[MAX_LIGHTS];
+
+    // Dirty range [m_dirtyBegin, m_dirtyEnd) of packed lights
+    int m_dirtyBegin;
+    int m_dirtyEnd;
+    bool m_countDirty;
+
+    // Uniform buffer holding the lights, bound to LIGHT_BLOCK_BINDING
+    GLuint m_lightBuffer;
+};
@@ -9,6 +9,12 @@
 #include <iostream>         // error handling and output
 #include <cstdlib>          // EXIT_FAILURE
 #include <fstream>			// file input/output
+#include <string>			// command line options
+#include <vector>			// headless frame timings and images
+#include <chrono>			// headless frame timings
+#include <algorithm>		// headless timing summary
+#include <cstdio>			// headless file names
+#include <filesystem>		// headless dump directory
 
 #include <GL/glew.h>        // GLEW library
 #include "GLFW/glfw3.h"     // GLFW library
@@ -25,6 +31,25 @@
 #include "ShapeMeshes.h"
 #include "ShaderManager.h"
 
+// Enhancement: Offscreen, ImageFile and CameraPath are included so the
+// renderer can run without a window, along a scripted camera path, and
+// compare its frames against reference images.
+#include "../Offscreen.h"
+#include "../ImageFile.h"
+#include "../CameraPath.h"
+
+// Enhancement: Profiler is included to time each frame's stages and
+// export them as a Chrome trace (debug builds only)
+#include "../Profiler.h"
+
+// Enhancement: CommandReplay is included to play a captured command
+// stream back without the scene (--replay)
+#include "../CommandReplay.h"
+
+// Enhancement: ProcessMemory is included to report the memory a headless
+// run peaked at, next to its frame times.
+#include "../ProcessMemory.h"
+
 
 
 // Namespace for declaring global variables
@@ -42,12 +67,77 @@ namespace
 	ShaderManager* g_ShaderManager = nullptr;
 	// view manager object for managing the 3D view setup and projection to 2D
 	ViewManager* g_ViewManager = nullptr;
+
+	// Enhancement: exit status of a headless run whose frames differ
+	// from the reference images (setup failures exit with EXIT_FAILURE)
+	const int EXIT_IMAGE_DIFF = 2;
+
+	// Enhancement: oldest OpenGL the renderer runs on: #version 440
+	// shaders, persistently mapped buffers (4.4), SSBOs and multi-draw
+	// indirect (4.3), and base-instance draws (4.2)
+	const int REQUIRED_GL_MAJOR = 4;
+	const int REQUIRED_GL_MINOR = 4;
+
+	// Enhancement: per-channel difference tolerated as rasterizer noise
+	// before a pixel counts as different from the reference
+	const int IMAGE_CHANNEL_THRESHOLD = 8;
+
+	// Enhancement: options of a headless run (--headless)
+	struct HeadlessOptions
+	{
+		std::string scene = "scene_save.json";
+		std::string cameraPath;			// empty = hold the scene's camera
+		int frames = 120;
+		int width = 1000;
+		int height = 800;
+		std::string timingsFile = "headless_timings.csv";
+		std::string dumpDir;			// empty = no PNG dumps
+		std::string referenceDir;		// empty = no comparison
+		double tolerance = 0.001;		// fraction of pixels allowed to differ
+		std::string traceFile;			// empty = no Chrome trace
+		double frameBudgetMs = 0.0;		// 0 = full quality, for repeatable frames
+		unsigned threads = 0;			// 0 = keep the default
+		std::string captureFile;		// empty = no command capture
+		bool deferred = false;			// deferred instead of forward lighting
+		bool shadows = true;			// shadow maps for the first two lights
+		size_t stressRooms = 0;			// 0 = render the scene file
+		uint32_t seed = 1;				// layout of the generated rooms
+	};
+
+	// Enhancement: lighting pass of the deferred shading path (F7)
+	const char* const DEFERRED_VERTEX_SHADER = "../../Utilities/shaders/deferredLightVertex.glsl";
+	const char* const DEFERRED_FRAGMENT_SHADER = "../../Utilities/shaders/deferredLightFragment.glsl";
+
+	// Enhancement: depth pass of the shadow maps (F8)
+	const char* const SHADOW_VERTEX_SHADER = "../../Utilities/shaders/shadowDepthVertex.glsl";
+	const char* const SHADOW_FRAGMENT_SHADER = "../../Utilities/shaders/shadowDepthFragment.glsl";
+
+	// Enhancement: frames recorded by F6 for --replay
+	const int CAPTURE_FRAMES = 60;
+	const char* const CAPTURE_FILE = "frame_capture.rcap";
+
+	// Enhancement: options of a command stream replay (--replay)
+	struct ReplayOptions
+	{
+		std::string captureFile;
+		int repeat = 10;				// passes over the captured frames
+		int width = 0;					// 0 = the captured viewport
+		int height = 0;
+		std::string timingsFile = "replay_timings.csv";
+		std::string imageFile;			// empty = no PNG of the last frame
+	};
 }
 
 // Function declarations - all functions that are called manually
 // need to be pre-declared at the beginning of the source code.
 bool InitializeGLFW();
 bool InitializeGLEW();
+bool ParseHeadlessOptions(int argc, char* argv[], HeadlessOptions& options);
+int RunHeadless(const HeadlessOptions& options);
+void PrintFrameTimes(const std::string& label, const std::vector<double>& frameTimes,
+	const std::string& timingsFile);
+bool ParseReplayOptions(int argc, char* argv[], ReplayOptions& options);
+int RunReplay(const ReplayOptions& options);
 
 
 /***********************************************************
@@ -58,6 +148,32 @@ bool InitializeGLEW();
  ***********************************************************/
 int main(int argc, char* argv[])
 {
+	PROFILE_THREAD_NAME("Main");
+
+	// Enhancement: --headless renders offscreen without GLFW and exits
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::string(argv[i]) == "--headless")
+		{
+			HeadlessOptions options;
+			if (!ParseHeadlessOptions(argc, argv, options))
+			{
+				return(EXIT_FAILURE);
+			}
+			return RunHeadless(options);
+		}
+		// Enhancement: --replay FILE re-issues a command capture offscreen and exits
+		if (std::string(argv[i]) == "--replay")
+		{
+			ReplayOptions options;
+			if (!ParseReplayOptions(argc, argv, options))
+			{
+				return(EXIT_FAILURE);
+			}
+			return RunReplay(options);
+		}
+	}
+
 	// if GLFW fails initialization, then terminate the application
 	if (InitializeGLFW() == false)
 	{
@@ -87,7 +203,9 @@ int main(int argc, char* argv[])
 
 	// try to create a new scene manager object and prepare the 3D scene
 	// The SceneManager now uses the new TextureManager and MaterialManager
-	TextureManager* g_TextureManager = new TextureManager();
+	// Enhancement: textures are packed into texture arrays, so the scene is
+	// not limited by the number of texture units and draws only switch layers
+	TextureManager* g_TextureManager = new TextureManager(TextureManager::BACKEND_TEXTURE_ARRAY);
 	MaterialManager* g_MaterialManager = new MaterialManager();
 	g_SceneManager = new SceneManager(g_ShaderManager, g_TextureManager, g_MaterialManager);
 
@@ -103,10 +221,24 @@ int main(int argc, char* argv[])
 
 	g_SceneManager->PrepareScene(); 
 
+	// Enhancement: --stress-rooms N [--seed S] replaces the scene with N
+	// generated rooms of toys, for watching how the frame time scales
+	size_t stressRooms = 0;
+	uint32_t stressSeed = 1;
+	for (int i = 1; i + 1 < argc; ++i) {
+		if (std::string(argv[i]) == "--stress-rooms")
+			stressRooms = std::strtoull(argv[i + 1], NULL, 10);
+		if (std::string(argv[i]) == "--seed")
+			stressSeed = static_cast<uint32_t>(std::strtoul(argv[i + 1], NULL, 10));
+	}
+
 	// Enhancement: Always initialize the scene, 
 	// then optionally load from JSON if a save file exists.
 	std::ifstream infile("scene_save.json");
-	if (infile.good()) {
+	if (stressRooms > 0) {
+		g_SceneManager->GenerateStressScene(stressRooms, stressSeed);
+	}
+	else if (infile.good()) {
 		g_SceneManager->LoadSceneAndCameraFromJson("scene_save.json");
 		std::cout << "Loaded scene and camera from scene_save.json" << std::endl;
 	}
@@ -118,27 +250,229 @@ int main(int argc, char* argv[])
 		std::cout << "No save found, loaded default scene." << std::endl;
 	}
 
+	// Enhancement: the deferred path stays off until F7, but is loaded now
+	g_SceneManager->LoadDeferredShaders(DEFERRED_VERTEX_SHADER, DEFERRED_FRAGMENT_SHADER);
+
+	// Enhancement: edits of the save file show up in the running scene
+	g_SceneManager->WatchSceneFile("scene_save.json");
+
+	// Enhancement: shadows are on from the first frame
+	g_SceneManager->LoadShadowShaders(SHADOW_VERTEX_SHADER, SHADOW_FRAGMENT_SHADER);
+
+	// Enhancement: --bench-uniforms [frames] times name-based uniform
+	// setters against cached uniform handles before the main loop
+	for (int i = 1; i < argc; ++i) {
+		if (std::string(argv[i]) == "--bench-uniforms") {
+			int frames = (i + 1 < argc) ? std::atoi(argv[i + 1]) : 0;
+			g_SceneManager->BenchmarkUniformPaths(frames > 0 ? frames : 200, 1000);
+		}
+		// Enhancement: --bench-draw-modes [frames] compares the CPU submit
+		// time of per-object, instanced and multi-draw-indirect drawing
+		if (std::string(argv[i]) == "--bench-draw-modes") {
+			int frames = (i + 1 < argc) ? std::atoi(argv[i + 1]) : 0;
+			g_ViewManager->PrepareSceneView();
+			g_SceneManager->SetFrameConstants(g_ViewManager->GetViewMatrix(),
+				g_ViewManager->GetProjectionMatrix(), g_ViewManager->GetViewPosition());
+			g_SceneManager->BenchmarkDrawModes(frames > 0 ? frames : 200);
+		}
+		// Enhancement: --bench-threads [frames] measures how culling and
+		// command generation scale with the worker thread count
+		if (std::string(argv[i]) == "--bench-threads") {
+			int frames = (i + 1 < argc) ? std::atoi(argv[i + 1]) : 0;
+			g_ViewManager->PrepareSceneView();
+			g_SceneManager->SetFrameConstants(g_ViewManager->GetViewMatrix(),
+				g_ViewManager->GetProjectionMatrix(), g_ViewManager->GetViewPosition());
+			g_SceneManager->BenchmarkWorkerThreads(frames > 0 ? frames : 200);
+		}
+		// Enhancement: --bench-overdraw [frames] compares the samples shaded
+		// per pixel with state-sorted, front-to-back and depth pre-pass order
+		if (std::string(argv[i]) == "--bench-overdraw") {
+			int frames = (i + 1 < argc) ? std::atoi(argv[i + 1]) : 0;
+			g_ViewManager->PrepareSceneView();
+			g_SceneManager->SetFrameConstants(g_ViewManager->GetViewMatrix(),
+				g_ViewManager->GetProjectionMatrix(), g_ViewManager->GetViewPosition());
+			g_SceneManager->BenchmarkOverdraw(frames > 0 ? frames : 100);
+		}
+		// Enhancement: --bench-lighting [frames] compares forward and deferred
+		// lighting GPU time over light count and resolution
+		if (std::string(argv[i]) == "--bench-lighting") {
+			int frames = (i + 1 < argc) ? std::atoi(argv[i + 1]) : 0;
+			g_ViewManager->PrepareSceneView();
+			g_SceneManager->SetFrameConstants(g_ViewManager->GetViewMatrix(),
+				g_ViewManager->GetProjectionMatrix(), g_ViewManager->GetViewPosition());
+			g_SceneManager->BenchmarkLighting(frames > 0 ? frames : 50);
+		}
+		// Enhancement: --threads N sets how many threads build render commands
+		if (std::string(argv[i]) == "--threads" && i + 1 < argc) {
+			g_SceneManager->SetWorkerThreadCount(static_cast<unsigned>(std::atoi(argv[i + 1])));
+		}
+		// Enhancement: --frame-budget MS sets the frame time the quality
+		// controller holds (default 16.7); 0 keeps full quality
+		if (std::string(argv[i]) == "--frame-budget" && i + 1 < argc) {
+			g_SceneManager->GetFrameBudget().SetTarget(std::atof(argv[i + 1]));
+		}
+	}
+
 	// loop will keep running until the application is closed 
 	// or until an error has occurred
 
 	while (!glfwWindowShouldClose(g_Window))
 	{
+		PROFILE_SCOPE("Frame");
 		glEnable(GL_DEPTH_TEST);
 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-		g_ViewManager->PrepareSceneView();
+		// Enhancement: a scene loaded in the background (F9) replaces the
+		// current one here, between two frames, camera included
+		{
+			PROFILE_SCOPE("FinishSceneLoad");
+			g_SceneManager->FinishSceneLoad();
+			// Enhancement: and edits of the watched file are applied here
+			g_SceneManager->ApplySceneFileChanges();
+		}
+
+		{
+			PROFILE_SCOPE("PrepareSceneView");
+			g_ViewManager->PrepareSceneView();
+		}
+		// Enhancement: view state goes into SceneManager's per-frame ring buffer
+		g_SceneManager->SetFrameConstants(g_ViewManager->GetViewMatrix(),
+			g_ViewManager->GetProjectionMatrix(), g_ViewManager->GetViewPosition());
 		g_SceneManager->RenderScene();
 
 		// --- Enhancement: This block for save/load functionality ---
-		if (glfwGetKey(g_Window, GLFW_KEY_F5) == GLFW_PRESS) {
-			g_SceneManager->SaveSceneAndCameraToJson("scene_save.json");
-			std::cout << "Scene and camera saved to scene_save.json" << std::endl;
+		// Enhancement: F5 saves once per press; the scene is copied here and
+		// written by a background thread, which reports back when done
+		static bool saveKeyWasDown = false;
+		bool saveKeyDown = glfwGetKey(g_Window, GLFW_KEY_F5) == GLFW_PRESS;
+		if (saveKeyDown && !saveKeyWasDown) {
+			g_SceneManager->SaveSceneAndCameraAsync("scene_save.json");
+		}
+		saveKeyWasDown = saveKeyDown;
+		g_SceneManager->FinishSceneSaves();
+		// Enhancement: F9 starts a background load once per press; the
+		// current scene is drawn, and the progress printed, until it is done
+		static bool loadKeyWasDown = false;
+		bool loadKeyDown = glfwGetKey(g_Window, GLFW_KEY_F9) == GLFW_PRESS;
+		if (loadKeyDown && !loadKeyWasDown) {
+			if (g_SceneManager->LoadSceneAndCameraAsync("scene_save.json"))
+				std::cout << "Loading scene and camera from scene_save.json" << std::endl;
+			else
+				std::cout << "A scene is still loading" << std::endl;
+		}
+		loadKeyWasDown = loadKeyDown;
+
+		static int loadProgressStep = -1;
+		if (g_SceneManager->IsLoadingScene()) {
+			int step = static_cast<int>(g_SceneManager->SceneLoadProgress() * 10.0f);
+			if (step != loadProgressStep)
+				std::cout << "Loading scene: " << step * 10 << "%" << std::endl;
+			loadProgressStep = step;
+		}
+		else {
+			loadProgressStep = -1;
+		}
+		// --- Enhancement: F1 prints the render queue state change counters ---
+		static bool statsKeyWasDown = false;
+		bool statsKeyDown = glfwGetKey(g_Window, GLFW_KEY_F1) == GLFW_PRESS;
+		if (statsKeyDown && !statsKeyWasDown) {
+			const RenderStats& stats = g_SceneManager->GetRenderStats();
+			std::cout << "Draws: " << stats.drawCount
+				<< " (" << stats.drawCalls << " draw calls)"
+				<< " | state changes unsorted: " << stats.unsortedStateChanges
+				<< " sorted: " << stats.sortedStateChanges
+				<< " (mesh " << stats.meshChanges
+				<< ", texture " << stats.textureChanges
+				<< ", layer " << stats.layerChanges
+				<< ", material " << stats.materialChanges << ")"
+				<< " | " << SceneManager::DrawModeName(g_SceneManager->GetDrawMode())
+				<< " generate: " << stats.generateCpuMs << " ms"
+				<< " (" << stats.workerThreads << " threads)"
+				<< " submit: " << stats.submitCpuMs << " ms"
+				<< " | fence waits: " << stats.fenceWaits
+				<< " (total " << stats.totalFenceWaits << ")"
+				<< " | transforms updated: " << stats.transformUpdates
+				<< " | state calls issued: " << stats.stateCallsIssued
+				<< " skipped: " << stats.stateCallsSkipped
+				<< " | static batches: " << stats.staticBatches
+				<< " (rebuilt " << stats.staticBatchRebuilds << ")"
+				<< " | gpu: " << stats.gpuMs << " ms"
+				<< " quality: " << g_SceneManager->GetFrameBudget().Quality()
+				<< " view range: " << g_SceneManager->GetFrameBudget().Settings().viewRange
+				<< " reduced LOD: " << stats.reducedLodDraws
+				<< " small culled: " << stats.smallObjectsCulled
+				<< " | " << SceneManager::OpaqueOrderName(g_SceneManager->GetOpaqueOrder())
+				<< " overdraw: " << stats.overdraw
+				<< " (" << stats.shadedSamples << " samples shaded"
+				<< ", pre-pass " << stats.prePassDraws << " draws / "
+				<< stats.prePassSamples << " samples)"
+				<< " | " << SceneManager::ShadingPathName(g_SceneManager->GetShadingPath())
+				<< " light volumes: " << stats.lightVolumes
+				<< " | shadows " << (g_SceneManager->GetShadowsEnabled() ? "on" : "off")
+				<< ", static maps rendered: " << stats.shadowStaticRenders
+				<< " moving casters: " << stats.shadowCasters << std::endl;
+		}
+		statsKeyWasDown = statsKeyDown;
+
+		// --- Enhancement: F2 cycles the draw modes for comparison ---
+		static bool drawModeKeyWasDown = false;
+		bool drawModeKeyDown = glfwGetKey(g_Window, GLFW_KEY_F2) == GLFW_PRESS;
+		if (drawModeKeyDown && !drawModeKeyWasDown) {
+			int nextMode = (g_SceneManager->GetDrawMode() + 1) % SceneManager::DRAW_MODE_COUNT;
+			g_SceneManager->SetDrawMode(static_cast<SceneManager::DrawMode>(nextMode));
+			std::cout << "Draw mode: " << SceneManager::DrawModeName(g_SceneManager->GetDrawMode()) << std::endl;
 		}
-		if (glfwGetKey(g_Window, GLFW_KEY_F9) == GLFW_PRESS) {
-			g_SceneManager->LoadSceneAndCameraFromJson("scene_save.json");
-			std::cout << "Scene and camera loaded from scene_save.json" << std::endl;
+		drawModeKeyWasDown = drawModeKeyDown;
+
+		// --- Enhancement: F3 cycles the opaque draw orders for comparison ---
+		static bool opaqueOrderKeyWasDown = false;
+		bool opaqueOrderKeyDown = glfwGetKey(g_Window, GLFW_KEY_F3) == GLFW_PRESS;
+		if (opaqueOrderKeyDown && !opaqueOrderKeyWasDown) {
+			int nextOrder = (g_SceneManager->GetOpaqueOrder() + 1) % SceneManager::OPAQUE_ORDER_COUNT;
+			g_SceneManager->SetOpaqueOrder(static_cast<SceneManager::OpaqueOrder>(nextOrder));
+			std::cout << "Opaque order: " << SceneManager::OpaqueOrderName(g_SceneManager->GetOpaqueOrder()) << std::endl;
+		}
+		opaqueOrderKeyWasDown = opaqueOrderKeyDown;
+
+		// --- Enhancement: F4 writes the profiler's events as a Chrome trace ---
+		static bool traceKeyWasDown = false;
+		bool traceKeyDown = glfwGetKey(g_Window, GLFW_KEY_F4) == GLFW_PRESS;
+		if (traceKeyDown && !traceKeyWasDown) {
+			if (PROFILE_WRITE_TRACE("frame_trace.json"))
+				std::cout << "Profile written to frame_trace.json (open in chrome://tracing)" << std::endl;
+			else
+				std::cout << "No profile written (release build, or the file cannot be opened)" << std::endl;
+		}
+		traceKeyWasDown = traceKeyDown;
+
+		// --- Enhancement: F6 captures the next frames' command stream for --replay ---
+		static bool captureKeyWasDown = false;
+		bool captureKeyDown = glfwGetKey(g_Window, GLFW_KEY_F6) == GLFW_PRESS;
+		if (captureKeyDown && !captureKeyWasDown && !g_SceneManager->IsCapturing()) {
+			g_SceneManager->StartCapture(CAPTURE_FILE, CAPTURE_FRAMES);
+		}
+		captureKeyWasDown = captureKeyDown;
+
+		// --- Enhancement: F7 switches between forward and deferred lighting ---
+		static bool shadingKeyWasDown = false;
+		bool shadingKeyDown = glfwGetKey(g_Window, GLFW_KEY_F7) == GLFW_PRESS;
+		if (shadingKeyDown && !shadingKeyWasDown) {
+			int nextPath = (g_SceneManager->GetShadingPath() + 1) % SceneManager::SHADING_PATH_COUNT;
+			g_SceneManager->SetShadingPath(static_cast<SceneManager::ShadingPath>(nextPath));
+			std::cout << "Shading path: " << SceneManager::ShadingPathName(g_SceneManager->GetShadingPath()) << std::endl;
 		}
+		shadingKeyWasDown = shadingKeyDown;
+
+		// --- Enhancement: F8 turns the shadow maps off and on ---
+		static bool shadowKeyWasDown = false;
+		bool shadowKeyDown = glfwGetKey(g_Window, GLFW_KEY_F8) == GLFW_PRESS;
+		if (shadowKeyDown && !shadowKeyWasDown) {
+			g_SceneManager->SetShadowsEnabled(!g_SceneManager->GetShadowsEnabled());
+			std::cout << "Shadows: " << (g_SceneManager->GetShadowsEnabled() ? "on" : "off") << std::endl;
+		}
+		shadowKeyWasDown = shadowKeyDown;
+
 		// --------------------------------------------------
 		//					Enhancement
 		// Press F5 to save the scene and camera to JSON,
@@ -146,8 +480,12 @@ int main(int argc, char* argv[])
 		// 
 		// -------------   End of Enhancement	-------------
 
-		glfwSwapBuffers(g_Window);
-		glfwPollEvents();
+		{
+			PROFILE_SCOPE("SwapBuffers");
+			glfwSwapBuffers(g_Window);
+			glfwPollEvents();
+		}
+		PROFILE_END_FRAME();
 	}
 
 
@@ -183,17 +521,12 @@ bool InitializeGLFW()
 	// --------------------------------------
 	glfwInit();
 
-#ifdef __APPLE__
-	// set the version of OpenGL and profile to use
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
-#else
 	// set the version of OpenGL and profile to use
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
+	// Enhancement: the oldest version the renderer runs on; there is no
+	// macOS branch, as macOS's OpenGL stops at 4.1
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, REQUIRED_GL_MAJOR);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, REQUIRED_GL_MINOR);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-#endif
 	// GLFW: end -------------------------------
 
 	return(true);
@@ -212,6 +545,14 @@ bool InitializeGLEW()
 
 	// try to initialize the GLEW library
 	GLEWInitResult = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+	// Enhancement: a surfaceless EGL context has no X display, but the
+	// OpenGL entry points are loaded before GLEW looks for one
+	if (GLEW_ERROR_NO_GLX_DISPLAY == GLEWInitResult)
+	{
+		GLEWInitResult = GLEW_OK;
+	}
+#endif
 	if (GLEW_OK != GLEWInitResult)
 	{
 		std::cerr << glewGetErrorString(GLEWInitResult) << std::endl;
@@ -219,9 +560,491 @@ bool InitializeGLEW()
 	}
 	// GLEW: end -------------------------------
 
+	// Enhancement: stop here, with the reason, on a context too old for
+	// the draw paths and shaders, instead of failing at the first of them
+	GLint major = 0, minor = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &major);
+	glGetIntegerv(GL_MINOR_VERSION, &minor);
+	if (major < REQUIRED_GL_MAJOR || (major == REQUIRED_GL_MAJOR && minor < REQUIRED_GL_MINOR))
+	{
+		std::cerr << "ERROR: OpenGL " << REQUIRED_GL_MAJOR << "." << REQUIRED_GL_MINOR
+			<< " or newer is required (persistent mapping, SSBOs, multi-draw indirect, #version 440 shaders); "
+			<< "this context is " << glGetString(GL_VERSION) << std::endl;
+		return false;
+	}
+
 	// Displays a successful OpenGL initialization message
 	std::cout << "INFO: OpenGL Successfully Initialized\n";
 	std::cout << "INFO: OpenGL Version: " << glGetString(GL_VERSION) << "\n" << std::endl;
 
 	return(true);
 }
+
+/***********************************************************
+ *						*** ENHANCEMENT ***
+ *
+ *	ParseHeadlessOptions()
+ *
+ *  This function is used to read the options of a headless
+ *  run from the command line:
+ *
+ *    --headless              render offscreen, then exit
+ *    --scene FILE            scene and camera to load
+ *    --camera-path FILE      scripted camera keyframes
+ *    --frames N              frames to render
+ *    --size WxH              size of the offscreen target
+ *    --timings FILE          per-frame timings (CSV)
+ *    --dump-dir DIR          write every frame as DIR/frame_NNNN.png
+ *    --reference-dir DIR     compare every frame with DIR/frame_NNNN.png
+ *    --tolerance F           fraction of pixels that may differ
+ *    --frame-budget MS       frame time controller target (0 = off)
+ *    --threads N             threads building render commands
+ *    --trace FILE            Chrome trace of the run (debug builds)
+ *    --capture FILE          command stream of every frame, for --replay
+ *    --deferred              deferred instead of forward lighting
+ *    --no-shadows            draw without shadow maps
+ *    --stress-rooms N        N generated rooms instead of the scene file
+ *    --seed S                layout of the generated rooms
+ ***********************************************************/
+bool ParseHeadlessOptions(int argc, char* argv[], HeadlessOptions& options)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string option = argv[i];
+		if (option == "--headless")
+		{
+			continue;
+		}
+		if (option == "--deferred")
+		{
+			options.deferred = true;
+			continue;
+		}
+		if (option == "--no-shadows")
+		{
+			options.shadows = false;
+			continue;
+		}
+		if (i + 1 >= argc)
+		{
+			break;
+		}
+
+		std::string value = argv[i + 1];
+		if (option == "--scene") options.scene = value;
+		else if (option == "--camera-path") options.cameraPath = value;
+		else if (option == "--frames") options.frames = std::atoi(value.c_str());
+		else if (option == "--size")
+		{
+			if (std::sscanf(value.c_str(), "%dx%d", &options.width, &options.height) != 2)
+			{
+				std::cout << "--size expects WIDTHxHEIGHT, e.g. 640x480" << std::endl;
+				return false;
+			}
+		}
+		else if (option == "--timings") options.timingsFile = value;
+		else if (option == "--dump-dir") options.dumpDir = value;
+		else if (option == "--reference-dir") options.referenceDir = value;
+		else if (option == "--tolerance") options.tolerance = std::atof(value.c_str());
+		else if (option == "--frame-budget") options.frameBudgetMs = std::atof(value.c_str());
+		else if (option == "--threads") options.threads = static_cast<unsigned>(std::atoi(value.c_str()));
+		else if (option == "--trace") options.traceFile = value;
+		else if (option == "--capture") options.captureFile = value;
+		else if (option == "--stress-rooms") options.stressRooms = std::strtoull(value.c_str(), NULL, 10);
+		else if (option == "--seed") options.seed = static_cast<uint32_t>(std::strtoul(value.c_str(), NULL, 10));
+		else continue;
+		++i;
+	}
+
+	if (options.frames <= 0 || options.width <= 0 || options.height <= 0)
+	{
+		std::cout << "Headless run needs a positive frame count and size" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+/***********************************************************
+ *						*** ENHANCEMENT ***
+ *
+ *	RunHeadless()
+ *
+ *  This function is used to render a scene without a window,
+ *  for benchmarks and image regression tests in automation.
+ *  A surfaceless EGL context (e.g. Mesa llvmpipe) renders the
+ *  frames into a framebuffer object while the camera follows
+ *  the scripted path. Every frame is finished before the next
+ *  one starts, so its wall time is the real frame time. It
+ *  returns EXIT_IMAGE_DIFF if any frame differs from its
+ *  reference image by more than the tolerance.
+ ***********************************************************/
+int RunHeadless(const HeadlessOptions& options)
+{
+	OffscreenContext context;
+	if (!context.Create(4, 6) && !context.Create(4, 5))
+	{
+		std::cout << "Failed to create an offscreen OpenGL context" << std::endl;
+		return(EXIT_FAILURE);
+	}
+	if (InitializeGLEW() == false)
+	{
+		return(EXIT_FAILURE);
+	}
+
+	g_ShaderManager = new ShaderManager();
+	g_ViewManager = new ViewManager(g_ShaderManager);
+	g_ShaderManager->LoadShaders(
+		"../../Utilities/shaders/vertexShader.glsl",
+		"../../Utilities/shaders/fragmentShader.glsl");
+	g_ShaderManager->use();
+
+	TextureManager* g_TextureManager = new TextureManager(TextureManager::BACKEND_TEXTURE_ARRAY);
+	MaterialManager* g_MaterialManager = new MaterialManager();
+	g_SceneManager = new SceneManager(g_ShaderManager, g_TextureManager, g_MaterialManager);
+	g_SceneManager->PrepareScene();
+
+	// the scene manager only borrows the texture and material managers;
+	// everything here frees GL objects, so it goes before the context
+	auto destroyManagers = [&]()
+	{
+		delete g_SceneManager;
+		g_SceneManager = NULL;
+		delete g_MaterialManager;
+		delete g_TextureManager;
+		delete g_ViewManager;
+		g_ViewManager = NULL;
+		delete g_ShaderManager;
+		g_ShaderManager = NULL;
+	};
+
+	std::ifstream sceneFile(options.scene);
+	if (options.stressRooms > 0)
+	{
+		g_SceneManager->GenerateStressScene(options.stressRooms, options.seed);
+	}
+	else if (sceneFile.good())
+	{
+		g_SceneManager->LoadSceneAndCameraFromJson(options.scene);
+		std::cout << "Loaded scene and camera from " << options.scene << std::endl;
+	}
+	else
+	{
+		std::cout << "No scene file " << options.scene << ", rendering the default scene" << std::endl;
+	}
+
+	// full quality unless a budget is asked for, so frames are repeatable
+	g_SceneManager->GetFrameBudget().SetTarget(options.frameBudgetMs);
+	if (options.threads > 0)
+	{
+		g_SceneManager->SetWorkerThreadCount(options.threads);
+	}
+	if (options.deferred &&
+		g_SceneManager->LoadDeferredShaders(DEFERRED_VERTEX_SHADER, DEFERRED_FRAGMENT_SHADER))
+	{
+		g_SceneManager->SetShadingPath(SceneManager::SHADING_DEFERRED);
+	}
+	if (options.shadows)
+	{
+		g_SceneManager->LoadShadowShaders(SHADOW_VERTEX_SHADER, SHADOW_FRAGMENT_SHADER);
+	}
+
+	CameraPath path;
+	if (!options.cameraPath.empty() && !path.Load(options.cameraPath))
+	{
+		std::cout << "Failed to load camera path " << options.cameraPath << std::endl;
+		destroyManagers();
+		context.Destroy();
+		return(EXIT_FAILURE);
+	}
+	if (path.Empty())
+	{
+		const Camera* camera = g_ViewManager->GetCamera();
+		path.Hold(CameraState{ camera->Position, camera->Front, camera->Up, camera->Zoom });
+	}
+
+	OffscreenTarget target;
+	if (!target.Create(options.width, options.height))
+	{
+		destroyManagers();
+		context.Destroy();
+		return(EXIT_FAILURE);
+	}
+	if (!options.dumpDir.empty())
+	{
+		std::error_code error;
+		std::filesystem::create_directories(options.dumpDir, error);
+	}
+
+	std::ofstream timings(options.timingsFile);
+	timings << "frame,frame_ms,generate_ms,submit_ms,gpu_ms,draw_calls,overdraw" << std::endl;
+
+	if (!options.captureFile.empty())
+	{
+		g_SceneManager->StartCapture(options.captureFile, options.frames);
+	}
+
+	std::vector<double> frameTimes;
+	std::vector<unsigned char> pixels;
+	std::vector<unsigned char> reference;
+	int failedFrames = 0;
+	for (int frame = 0; frame < options.frames; ++frame)
+	{
+		CameraState camera = path.Sample(frame);
+		g_ViewManager->SetCamera(camera.position, camera.front, camera.up, camera.zoom);
+		g_ViewManager->PrepareOffscreenView(options.width, options.height);
+		g_SceneManager->SetFrameConstants(g_ViewManager->GetViewMatrix(),
+			g_ViewManager->GetProjectionMatrix(), g_ViewManager->GetViewPosition());
+
+		auto frameStart = std::chrono::steady_clock::now();
+		PROFILE_SCOPE("Frame");
+		target.Bind();
+		glEnable(GL_DEPTH_TEST);
+		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		g_SceneManager->RenderScene();
+		glFinish();
+		double frameMs = std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - frameStart).count();
+		frameTimes.push_back(frameMs);
+		PROFILE_END_FRAME();
+
+		const RenderStats& stats = g_SceneManager->GetRenderStats();
+		timings << frame << "," << frameMs << "," << stats.generateCpuMs << ","
+			<< stats.submitCpuMs << "," << stats.gpuMs << "," << stats.drawCalls << ","
+			<< stats.overdraw << std::endl;
+
+		if (options.dumpDir.empty() && options.referenceDir.empty())
+		{
+			continue;
+		}
+
+		char imageName[32];
+		std::snprintf(imageName, sizeof(imageName), "frame_%04d.png", frame);
+		target.ReadPixels(pixels);
+		if (!options.dumpDir.empty() &&
+			!ImageFile::WritePng(options.dumpDir + "/" + imageName, options.width, options.height, pixels))
+		{
+			std::cout << "Failed to write " << options.dumpDir << "/" << imageName << std::endl;
+		}
+
+		if (!options.referenceDir.empty())
+		{
+			int width = 0, height = 0;
+			std::string referenceName = options.referenceDir + "/" + imageName;
+			if (!ImageFile::ReadPng(referenceName, width, height, reference) ||
+				width != options.width || height != options.height)
+			{
+				std::cout << "Frame " << frame << ": no " << options.width << "x" << options.height
+					<< " reference image " << referenceName << std::endl;
+				failedFrames++;
+				continue;
+			}
+
+			ImageDiff diff = ImageFile::Compare(pixels, reference, IMAGE_CHANNEL_THRESHOLD);
+			if (diff.DifferingFraction() > options.tolerance)
+			{
+				std::cout << "Frame " << frame << ": " << diff.differingPixels << " pixels differ ("
+					<< diff.DifferingFraction() * 100.0 << "%, max channel error "
+					<< diff.maxChannelError << ")" << std::endl;
+				failedFrames++;
+			}
+		}
+	}
+
+	PrintFrameTimes("Headless: " + std::to_string(options.frames) + " frames at " +
+		std::to_string(options.width) + "x" + std::to_string(options.height), frameTimes, options.timingsFile);
+	std::cout << "Scene: " << g_SceneManager->GetEntities().Count() << " objects, peak resident memory "
+		<< ProcessMemory::Megabytes(ProcessMemory::Query().peakResidentBytes) << " MB" << std::endl;
+	if (!options.traceFile.empty())
+	{
+		PROFILE_END_FRAME();
+		if (PROFILE_WRITE_TRACE(options.traceFile))
+			std::cout << "Profile written to " << options.traceFile << std::endl;
+		else
+			std::cout << "No profile written to " << options.traceFile
+				<< " (release build, or the file cannot be opened)" << std::endl;
+	}
+	if (!options.referenceDir.empty())
+	{
+		std::cout << "Image comparison: " << failedFrames << " of " << options.frames
+			<< " frames differ beyond the tolerance" << std::endl;
+	}
+
+	target.Destroy();
+	destroyManagers();
+	context.Destroy();
+
+	return failedFrames > 0 ? EXIT_IMAGE_DIFF : EXIT_SUCCESS;
+}
+
+/***********************************************************
+ *						*** ENHANCEMENT ***
+ *
+ *	PrintFrameTimes()
+ *
+ *  This function is used to print the average, minimum,
+ *  95th percentile and maximum of a run's frame times after
+ *  `label`. The callers' option checks guarantee at least
+ *  one timed frame.
+ ***********************************************************/
+void PrintFrameTimes(const std::string& label, const std::vector<double>& frameTimes,
+	const std::string& timingsFile)
+{
+	std::vector<double> sorted = frameTimes;
+	std::sort(sorted.begin(), sorted.end());
+	double total = 0.0;
+	for (double ms : frameTimes) total += ms;
+	std::cout << label
+		<< ", frame time avg " << total / frameTimes.size() << " ms"
+		<< ", min " << sorted.front() << " ms"
+		<< ", p95 " << sorted[sorted.size() * 95 / 100] << " ms"
+		<< ", max " << sorted.back() << " ms"
+		<< " (timings in " << timingsFile << ")" << std::endl;
+}
+
+/***********************************************************
+ *						*** ENHANCEMENT ***
+ *
+ *	ParseReplayOptions()
+ *
+ *  This function is used to read the options of a command
+ *  stream replay from the command line:
+ *
+ *    --replay FILE           capture to replay, then exit
+ *    --repeat N              timed passes over the frames
+ *    --size WxH              size of the offscreen target
+ *    --timings FILE          per-frame timings (CSV)
+ *    --image FILE            PNG of the last replayed frame
+ ***********************************************************/
+bool ParseReplayOptions(int argc, char* argv[], ReplayOptions& options)
+{
+	for (int i = 1; i + 1 < argc; ++i)
+	{
+		std::string option = argv[i];
+		std::string value = argv[i + 1];
+		if (option == "--replay") options.captureFile = value;
+		else if (option == "--repeat") options.repeat = std::atoi(value.c_str());
+		else if (option == "--size")
+		{
+			if (std::sscanf(value.c_str(), "%dx%d", &options.width, &options.height) != 2)
+			{
+				std::cout << "--size expects WIDTHxHEIGHT, e.g. 640x480" << std::endl;
+				return false;
+			}
+		}
+		else if (option == "--timings") options.timingsFile = value;
+		else if (option == "--image") options.imageFile = value;
+		else continue;
+		++i;
+	}
+
+	if (options.captureFile.empty() || options.repeat <= 0 || options.width < 0 || options.height < 0)
+	{
+		std::cout << "Replay needs a capture file and a positive repeat count" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+/***********************************************************
+ *						*** ENHANCEMENT ***
+ *
+ *	RunReplay()
+ *
+ *  This function is used to time the draw path alone: the
+ *  frames of a command capture (F6, or --capture in a headless
+ *  run) are re-issued on an offscreen context with nothing
+ *  else of the application running, so a regression between
+ *  two builds shows up in the replay times of one capture.
+ *  One untimed pass warms the driver up; every frame of the
+ *  timed passes is finished before the next one starts.
+ ***********************************************************/
+int RunReplay(const ReplayOptions& options)
+{
+	OffscreenContext context;
+	if (!context.Create(4, 6) && !context.Create(4, 5))
+	{
+		std::cout << "Failed to create an offscreen OpenGL context" << std::endl;
+		return(EXIT_FAILURE);
+	}
+	if (InitializeGLEW() == false)
+	{
+		return(EXIT_FAILURE);
+	}
+
+	g_ShaderManager = new ShaderManager();
+	g_ShaderManager->LoadShaders(
+		"../../Utilities/shaders/vertexShader.glsl",
+		"../../Utilities/shaders/fragmentShader.glsl");
+	g_ShaderManager->use();
+	GLint program = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+
+	CommandReplay replay;
+	if (!replay.Load(options.captureFile) || !replay.Prepare(static_cast<GLuint>(program)))
+	{
+		std::cout << "Failed to load capture " << options.captureFile << std::endl;
+		return(EXIT_FAILURE);
+	}
+
+	int width = options.width > 0 ? options.width : replay.Width();
+	int height = options.height > 0 ? options.height : replay.Height();
+	OffscreenTarget target;
+	if (!target.Create(width, height))
+	{
+		return(EXIT_FAILURE);
+	}
+	target.Bind();
+
+	std::ofstream timings(options.timingsFile);
+	timings << "pass,frame,frame_ms,draw_calls" << std::endl;
+
+	std::vector<double> frameTimes;
+	for (int pass = 0; pass <= options.repeat; ++pass)
+	{
+		replay.Rewind();
+		for (int frame = 0; ; ++frame)
+		{
+			auto frameStart = std::chrono::steady_clock::now();
+			if (!replay.ReplayFrame())
+			{
+				break;
+			}
+			glFinish();
+			double frameMs = std::chrono::duration<double, std::milli>(
+				std::chrono::steady_clock::now() - frameStart).count();
+
+			// pass 0 warms the driver up and is not timed
+			if (pass == 0)
+			{
+				continue;
+			}
+			frameTimes.push_back(frameMs);
+			timings << pass << "," << frame << "," << frameMs << "," << replay.DrawCalls() << std::endl;
+		}
+	}
+
+	// Load() refuses a capture without frames and --repeat is at least 1,
+	// so every pass timed at least one frame
+	PrintFrameTimes("Replay: " + std::to_string(replay.FrameCount()) + " frames x " +
+		std::to_string(options.repeat) + " passes at " + std::to_string(width) + "x" + std::to_string(height),
+		frameTimes, options.timingsFile);
+
+	if (!options.imageFile.empty())
+	{
+		std::vector<unsigned char> pixels;
+		target.ReadPixels(pixels);
+		if (!ImageFile::WritePng(options.imageFile, width, height, pixels))
+		{
+			std::cout << "Failed to write " << options.imageFile << std::endl;
+		}
+	}
+
+	replay.Destroy();
+	target.Destroy();
+	delete g_ShaderManager;
+	g_ShaderManager = NULL;
+	context.Destroy();
+
+	return EXIT_SUCCESS;
+}
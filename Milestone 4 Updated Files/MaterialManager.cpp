@@ -0,0 +1,100 @@
+/***********************************************************
+ *  MaterialManager Implementation
+ *
+ *  Implements all material management logic, moved out of
+ *  SceneManager for better modularity and code reuse.
+ ***********************************************************/
+
+#include "MaterialManager.h"
+#include <cstddef>
+#include <iostream>
+
+// three vec4s per array element, as std140 lays out MaterialData
+static_assert(sizeof(MaterialStd140) == 3 * 16, "MaterialStd140 must match the std140 MaterialData");
+static_assert(offsetof(MaterialStd140, diffuseColor) == 16 &&
+              offsetof(MaterialStd140, specularColorShininess) == 32,
+              "MaterialStd140 members must sit at the std140 MaterialData offsets");
+
+
+MaterialManager::MaterialManager() : m_materialBuffer(0), m_bufferDirty(true) {}
+
+MaterialManager::~MaterialManager() {
+    DestroyMaterialBuffer(); // Ensure the uniform buffer is cleaned up
+}
+
+void MaterialManager::AddMaterial(const ObjectMaterial& material) {
+    // Adds a new material to the internal list
+    m_materials.push_back(material);
+    m_bufferDirty = true;
+}
+
+bool MaterialManager::FindMaterial(const std::string& tag, ObjectMaterial& material) const {
+    // Searches for a material by tag and copies it to the output parameter if found
+    for (const auto& mat : m_materials) {
+        if (mat.tag == tag) {
+            material = mat;
+            return true;
+        }
+    }
+    return false;
+}
+
+int MaterialManager::FindMaterialIndex(const std::string& tag) const {
+    // Returns the position of the material in the internal list, or -1 if not found.
+    // Resolving the index once lets the render loop switch materials without string compares.
+    for (size_t i = 0; i < m_materials.size(); ++i) {
+        if (m_materials[i].tag == tag) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+const ObjectMaterial* MaterialManager::GetMaterial(int index) const {
+    // Returns the material at the given index without copying it
+    if (index < 0 || index >= static_cast<int>(m_materials.size())) return nullptr;
+    return &m_materials[index];
+}
+
+void MaterialManager::Clear() {
+    // Removes all materials from the manager
+    m_materials.clear();
+    m_bufferDirty = true;
+}
+
+void MaterialManager::UploadMaterialBuffer() {
+    // Packs all materials into one std140 uniform buffer so a draw only
+    // has to pass a material index. Skipped when nothing has changed.
+    if (!m_bufferDirty) return;
+
+    if (m_materials.size() > static_cast<size_t>(MAX_MATERIALS)) {
+        std::cout << "Too many materials for the material buffer: " << m_materials.size()
+            << " (max " << MAX_MATERIALS << ")" << std::endl;
+    }
+
+    std::vector<MaterialStd140> packed(MAX_MATERIALS);
+    for (size_t i = 0; i < m_materials.size() && i < packed.size(); ++i) {
+        const ObjectMaterial& mat = m_materials[i];
+        packed[i].ambientColorStrength = glm::vec4(mat.ambientColor, mat.ambientStrength);
+        packed[i].diffuseColor = glm::vec4(mat.diffuseColor, 0.0f);
+        packed[i].specularColorShininess = glm::vec4(mat.specularColor, mat.shininess);
+    }
+
+    if (m_materialBuffer == 0) {
+        glGenBuffers(1, &m_materialBuffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, m_materialBuffer);
+        glBufferData(GL_UNIFORM_BUFFER, packed.size() * sizeof(MaterialStd140), packed.data(), GL_STATIC_DRAW);
+        glBindBufferBase(GL_UNIFORM_BUFFER, MATERIAL_BLOCK_BINDING, m_materialBuffer);
+    }
+    else {
+        glBindBuffer(GL_UNIFORM_BUFFER, m_materialBuffer);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, packed.size() * sizeof(MaterialStd140), packed.data());
+    }
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    m_bufferDirty = false;
+}
+
+void MaterialManager::DestroyMaterialBuffer() {
+    // Deletes the material uniform buffer from OpenGL
+    if (m_materialBuffer) glDeleteBuffers(1, &m_materialBuffer);
+    m_materialBuffer = 0;
+    m_bufferDirty = true;
+}
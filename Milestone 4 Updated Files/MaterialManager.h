@@ -0,0 +1,73 @@
+/***********************************************************
+ *  MaterialManager
+ *
+ *  This new class was added to modularize and centralize
+ *  all material definition and lookup operations.
+ *  This replaces the previous approach where SceneManager
+ *  handled materials directly, improving modularity and
+ *  maintainability.
+ ***********************************************************/
+
+#pragma once
+#include <string>
+#include <vector>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+
+struct ObjectMaterial {
+    float ambientStrength = 0.0f;
+    glm::vec3 ambientColor = glm::vec3(0.0f);
+    glm::vec3 diffuseColor = glm::vec3(0.0f);
+    glm::vec3 specularColor = glm::vec3(0.0f);
+    float shininess = 0.0f;
+    std::string tag;
+};
+
+// Material as laid out in the shader's std140 MaterialBlock
+// (three vec4s, the scalar fields packed into the w components)
+struct MaterialStd140 {
+    glm::vec4 ambientColorStrength;     // xyz = ambientColor, w = ambientStrength
+    glm::vec4 diffuseColor;             // xyz = diffuseColor
+    glm::vec4 specularColorShininess;   // xyz = specularColor, w = shininess
+};
+
+class MaterialManager {
+public:
+    // Must match MAX_MATERIALS and the binding in fragmentShader.glsl
+    static const int MAX_MATERIALS = 64;
+    static const GLuint MATERIAL_BLOCK_BINDING = 0;
+
+    MaterialManager();   // Constructor
+    ~MaterialManager();  // Destructor
+
+    // Adds a new material to the manager
+    void AddMaterial(const ObjectMaterial& material);
+
+    // Finds a material by tag and returns it via reference
+    bool FindMaterial(const std::string& tag, ObjectMaterial& material) const;
+
+    // Finds the index of a material by tag, or -1 if not found
+    int FindMaterialIndex(const std::string& tag) const;
+
+    // Returns the material stored at the given index, or nullptr if out of range
+    const ObjectMaterial* GetMaterial(int index) const;
+
+    // Clears all stored materials
+    void Clear();
+
+    // Packs every material into the uniform buffer, only if a material
+    // was added or cleared since the last upload
+    void UploadMaterialBuffer();
+
+    // Deletes the uniform buffer
+    void DestroyMaterialBuffer();
+
+private:
+    // Stores all defined materials
+    std::vector<ObjectMaterial> m_materials;
+
+    // Uniform buffer holding all materials, bound to MATERIAL_BLOCK_BINDING
+    GLuint m_materialBuffer;
+    bool m_bufferDirty;
+};
@@ -0,0 +1,454 @@
+/***********************************************************
+ *
+ *  MeshLibrary.cpp
+ *	============
+ *  shared indexed geometry for instanced drawing
+ *
+ ***********************************************************/
+
+#include "MeshLibrary.h"
+#include "BindingCache.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+
+namespace
+{
+    const float PI = 3.14159265f;
+
+    // Vertex attribute locations shared with vertexShader.glsl
+    const GLuint ATTRIB_POSITION = 0;
+    const GLuint ATTRIB_NORMAL = 1;
+    const GLuint ATTRIB_UV = 2;
+    const GLuint ATTRIB_INSTANCE_MODEL = 3;   // uses 3, 4, 5, 6
+    const GLuint ATTRIB_INSTANCE_COLOR = 7;
+    const GLuint ATTRIB_INSTANCE_NORMAL = 8;  // uses 8, 9, 10
+    const GLuint ATTRIB_INSTANCE_MATERIAL = 11;
+    const GLuint ATTRIB_INSTANCE_LAYER = 12;
+    const GLuint ATTRIB_DRAW_INDEX = 13;
+
+    // Vertex buffer binding point of the instance attributes; above every
+    // attribute location, since glVertexAttribPointer uses binding == location
+    const GLuint INSTANCE_BINDING = 15;
+}
+
+
+MeshLibrary::MeshLibrary() {}
+
+MeshLibrary::~MeshLibrary() {
+    DestroyMeshes();
+}
+
+
+// --- Enhancement: Build all basic shapes and upload them into shared buffers ---
+void MeshLibrary::LoadMeshes() {
+    DestroyMeshes();
+    m_vertices.clear();
+    m_indices.clear();
+
+    AddBox();
+    AddPlane();
+    for (int lod = 0; lod < LOD_COUNT; ++lod) {
+        AddCylinder(36 >> lod, lod);
+        AddCone(36 >> lod, lod);
+        AddSphere(24 >> lod, 36 >> lod, lod);
+    }
+    for (int lod = 1; lod < LOD_COUNT; ++lod) {
+        m_ranges[MESH_BOX][lod] = m_ranges[MESH_BOX][0];
+        m_ranges[MESH_PLANE][lod] = m_ranges[MESH_PLANE][0];
+    }
+
+    glGenVertexArrays(1, &m_vao);
+    glBindVertexArray(m_vao);
+
+    glGenBuffers(1, &m_vertexBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, m_vertices.size() * sizeof(MeshVertex), m_vertices.data(), GL_STATIC_DRAW);
+
+    glEnableVertexAttribArray(ATTRIB_POSITION);
+    glVertexAttribPointer(ATTRIB_POSITION, 3, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (void*)offsetof(MeshVertex, position));
+    glEnableVertexAttribArray(ATTRIB_NORMAL);
+    glVertexAttribPointer(ATTRIB_NORMAL, 3, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (void*)offsetof(MeshVertex, normal));
+    glEnableVertexAttribArray(ATTRIB_UV);
+    glVertexAttribPointer(ATTRIB_UV, 2, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (void*)offsetof(MeshVertex, uv));
+
+    glGenBuffers(1, &m_indexBuffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_indices.size() * sizeof(GLuint), m_indices.data(), GL_STATIC_DRAW);
+
+    // instance attributes read from a separate binding point, so the buffer
+    // and offset they come from can change with a single glBindVertexBuffer
+    // (the instance buffer below, or a section of a ring buffer)
+    for (GLuint column = 0; column < 4; ++column) {
+        glEnableVertexAttribArray(ATTRIB_INSTANCE_MODEL + column);
+        glVertexAttribFormat(ATTRIB_INSTANCE_MODEL + column, 4, GL_FLOAT, GL_FALSE,
+            static_cast<GLuint>(offsetof(InstanceData, model) + column * sizeof(glm::vec4)));
+        glVertexAttribBinding(ATTRIB_INSTANCE_MODEL + column, INSTANCE_BINDING);
+    }
+    glEnableVertexAttribArray(ATTRIB_INSTANCE_COLOR);
+    glVertexAttribFormat(ATTRIB_INSTANCE_COLOR, 4, GL_FLOAT, GL_FALSE, offsetof(InstanceData, color));
+    glVertexAttribBinding(ATTRIB_INSTANCE_COLOR, INSTANCE_BINDING);
+    for (GLuint column = 0; column < 3; ++column) {
+        glEnableVertexAttribArray(ATTRIB_INSTANCE_NORMAL + column);
+        glVertexAttribFormat(ATTRIB_INSTANCE_NORMAL + column, 3, GL_FLOAT, GL_FALSE,
+            static_cast<GLuint>(offsetof(InstanceData, normalMatrix) + column * sizeof(glm::vec3)));
+        glVertexAttribBinding(ATTRIB_INSTANCE_NORMAL + column, INSTANCE_BINDING);
+    }
+    glEnableVertexAttribArray(ATTRIB_INSTANCE_MATERIAL);
+    glVertexAttribIFormat(ATTRIB_INSTANCE_MATERIAL, 1, GL_INT, offsetof(InstanceData, materialIndex));
+    glVertexAttribBinding(ATTRIB_INSTANCE_MATERIAL, INSTANCE_BINDING);
+    glEnableVertexAttribArray(ATTRIB_INSTANCE_LAYER);
+    glVertexAttribIFormat(ATTRIB_INSTANCE_LAYER, 1, GL_INT, offsetof(InstanceData, textureLayer));
+    glVertexAttribBinding(ATTRIB_INSTANCE_LAYER, INSTANCE_BINDING);
+    glVertexBindingDivisor(INSTANCE_BINDING, 1);
+
+    // instance buffer starts empty and grows in UploadInstances()
+    glGenBuffers(1, &m_instanceBuffer);
+    m_instanceSource = m_instanceBuffer;
+    m_instanceSourceOffset = 0;
+
+    // indirect VAO: same geometry, plus a draw index that grows in UploadDrawCommands()
+    glGenVertexArrays(1, &m_indirectVao);
+    glBindVertexArray(m_indirectVao);
+    glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+    glEnableVertexAttribArray(ATTRIB_POSITION);
+    glVertexAttribPointer(ATTRIB_POSITION, 3, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (void*)offsetof(MeshVertex, position));
+    glEnableVertexAttribArray(ATTRIB_NORMAL);
+    glVertexAttribPointer(ATTRIB_NORMAL, 3, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (void*)offsetof(MeshVertex, normal));
+    glEnableVertexAttribArray(ATTRIB_UV);
+    glVertexAttribPointer(ATTRIB_UV, 2, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (void*)offsetof(MeshVertex, uv));
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+
+    glGenBuffers(1, &m_drawIndexBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, m_drawIndexBuffer);
+    glEnableVertexAttribArray(ATTRIB_DRAW_INDEX);
+    glVertexAttribIPointer(ATTRIB_DRAW_INDEX, 1, GL_INT, sizeof(GLint), (void*)0);
+    glVertexAttribDivisor(ATTRIB_DRAW_INDEX, 1);
+
+    glGenBuffers(1, &m_commandBuffer);
+    glGenBuffers(1, &m_drawDataBuffer);
+    SetDrawCommandSource(m_commandBuffer, 0, m_drawDataBuffer, 0, 0);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    // the VAOs above were bound directly
+    if (m_bindings) m_bindings->Invalidate();
+}
+
+
+void MeshLibrary::DestroyMeshes() {
+    if (m_drawDataBuffer) glDeleteBuffers(1, &m_drawDataBuffer);
+    if (m_commandBuffer) glDeleteBuffers(1, &m_commandBuffer);
+    if (m_drawIndexBuffer) glDeleteBuffers(1, &m_drawIndexBuffer);
+    if (m_indirectVao) glDeleteVertexArrays(1, &m_indirectVao);
+    m_drawDataBuffer = m_commandBuffer = m_drawIndexBuffer = m_indirectVao = 0;
+    m_drawCapacity = 0;
+
+    if (m_instanceBuffer) glDeleteBuffers(1, &m_instanceBuffer);
+    if (m_indexBuffer) glDeleteBuffers(1, &m_indexBuffer);
+    if (m_vertexBuffer) glDeleteBuffers(1, &m_vertexBuffer);
+    if (m_vao) glDeleteVertexArrays(1, &m_vao);
+    m_instanceBuffer = m_indexBuffer = m_vertexBuffer = m_vao = 0;
+    m_instanceCapacity = 0;
+    SetInstanceSource(0, 0);
+    SetDrawCommandSource(0, 0, 0, 0, 0);
+    // deleted names can be handed out again, so no binding of them may stay shadowed
+    if (m_bindings) m_bindings->Invalidate();
+}
+
+
+// --- Enhancement: Stream this frame's instance data to the GPU ---
+// The buffer is orphaned before each upload so the driver does not
+// have to wait for last frame's instanced draws to finish.
+void MeshLibrary::UploadInstances(const std::vector<InstanceData>& instances) {
+    if (instances.empty()) return;
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+    if (instances.size() > m_instanceCapacity) {
+        m_instanceCapacity = instances.size() * 2;
+    }
+    glBufferData(GL_ARRAY_BUFFER, m_instanceCapacity * sizeof(InstanceData), NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, instances.size() * sizeof(InstanceData), instances.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    SetInstanceSource(m_instanceBuffer, 0);
+}
+
+
+// --- Enhancement: Read instance data from memory the caller already wrote ---
+void MeshLibrary::SetInstanceSource(GLuint buffer, GLintptr offset) {
+    m_instanceSource = buffer;
+    m_instanceSourceOffset = offset;
+}
+
+
+void MeshLibrary::Bind() const {
+    BindVertexArray(m_vao);
+    if (m_bindings)
+        m_bindings->BindVertexBuffer(INSTANCE_BINDING, m_instanceSource, m_instanceSourceOffset, sizeof(InstanceData));
+    else
+        glBindVertexBuffer(INSTANCE_BINDING, m_instanceSource, m_instanceSourceOffset, sizeof(InstanceData));
+}
+
+
+void MeshLibrary::BindVertexArray(GLuint vao) const {
+    if (m_bindings) m_bindings->BindVertexArray(vao);
+    else glBindVertexArray(vao);
+}
+
+void MeshLibrary::BindBuffer(GLenum target, GLuint buffer) const {
+    if (m_bindings) m_bindings->BindBuffer(target, buffer);
+    else glBindBuffer(target, buffer);
+}
+
+
+// --- Enhancement: One draw call for every instance of a mesh in a group ---
+void MeshLibrary::DrawInstanced(MeshType mesh, GLuint baseInstance, GLsizei count, int lod) const {
+    const MeshRange& range = m_ranges[mesh][lod];
+    glDrawElementsInstancedBaseVertexBaseInstance(
+        GL_TRIANGLES,
+        range.indexCount,
+        GL_UNSIGNED_INT,
+        (void*)(range.firstIndex * sizeof(GLuint)),
+        count,
+        range.baseVertex,
+        baseInstance);
+}
+
+
+void MeshLibrary::Draw(MeshType mesh, int lod) const {
+    const MeshRange& range = m_ranges[mesh][lod];
+    glDrawElementsBaseVertex(
+        GL_TRIANGLES,
+        range.indexCount,
+        GL_UNSIGNED_INT,
+        (void*)(range.firstIndex * sizeof(GLuint)),
+        range.baseVertex);
+}
+
+
+void MeshLibrary::BeginMesh(MeshType mesh, int lod) {
+    m_ranges[mesh][lod].firstIndex = static_cast<GLuint>(m_indices.size());
+    m_ranges[mesh][lod].baseVertex = static_cast<GLint>(m_vertices.size());
+}
+
+void MeshLibrary::EndMesh(MeshType mesh, int lod) {
+    m_ranges[mesh][lod].indexCount = static_cast<GLsizei>(m_indices.size() - m_ranges[mesh][lod].firstIndex);
+    m_ranges[mesh][lod].vertexCount = static_cast<GLsizei>(m_vertices.size() - m_ranges[mesh][lod].baseVertex);
+}
+
+
+// --- Enhancement: Unit cube centered on the origin (-0.5 to 0.5) ---
+void MeshLibrary::AddBox() {
+    BeginMesh(MESH_BOX);
+
+    // normal, then two edge directions whose cross product is the normal
+    const glm::vec3 faces[6][3] = {
+        { glm::vec3(1, 0, 0),  glm::vec3(0, 0, -1), glm::vec3(0, 1, 0) },
+        { glm::vec3(-1, 0, 0), glm::vec3(0, 0, 1),  glm::vec3(0, 1, 0) },
+        { glm::vec3(0, 1, 0),  glm::vec3(1, 0, 0),  glm::vec3(0, 0, -1) },
+        { glm::vec3(0, -1, 0), glm::vec3(1, 0, 0),  glm::vec3(0, 0, 1) },
+        { glm::vec3(0, 0, 1),  glm::vec3(1, 0, 0),  glm::vec3(0, 1, 0) },
+        { glm::vec3(0, 0, -1), glm::vec3(-1, 0, 0), glm::vec3(0, 1, 0) }
+    };
+
+    for (int f = 0; f < 6; ++f) {
+        glm::vec3 n = faces[f][0];
+        glm::vec3 u = faces[f][1] * 0.5f;
+        glm::vec3 v = faces[f][2] * 0.5f;
+        glm::vec3 c = n * 0.5f;
+        GLuint start = static_cast<GLuint>(m_vertices.size() - m_ranges[MESH_BOX][0].baseVertex);
+
+        m_vertices.push_back({ c - u - v, n, glm::vec2(0.0f, 0.0f) });
+        m_vertices.push_back({ c + u - v, n, glm::vec2(1.0f, 0.0f) });
+        m_vertices.push_back({ c + u + v, n, glm::vec2(1.0f, 1.0f) });
+        m_vertices.push_back({ c - u + v, n, glm::vec2(0.0f, 1.0f) });
+
+        m_indices.insert(m_indices.end(), { start, start + 1, start + 2, start, start + 2, start + 3 });
+    }
+
+    EndMesh(MESH_BOX);
+}
+
+
+// --- Enhancement: Flat plane on XZ (-1 to 1), facing +Y ---
+void MeshLibrary::AddPlane() {
+    BeginMesh(MESH_PLANE);
+
+    glm::vec3 n(0.0f, 1.0f, 0.0f);
+    m_vertices.push_back({ glm::vec3(-1.0f, 0.0f, 1.0f), n, glm::vec2(0.0f, 0.0f) });
+    m_vertices.push_back({ glm::vec3(1.0f, 0.0f, 1.0f), n, glm::vec2(1.0f, 0.0f) });
+    m_vertices.push_back({ glm::vec3(1.0f, 0.0f, -1.0f), n, glm::vec2(1.0f, 1.0f) });
+    m_vertices.push_back({ glm::vec3(-1.0f, 0.0f, -1.0f), n, glm::vec2(0.0f, 1.0f) });
+    m_indices.insert(m_indices.end(), { 0, 1, 2, 0, 2, 3 });
+
+    EndMesh(MESH_PLANE);
+}
+
+
+// --- Enhancement: Closed cylinder, radius 1, from y = 0 to y = 1 ---
+void MeshLibrary::AddCylinder(int segments, int lod) {
+    BeginMesh(MESH_CYLINDER, lod);
+
+    // sides: a bottom/top vertex pair per segment edge
+    for (int i = 0; i <= segments; ++i) {
+        float angle = 2.0f * PI * i / segments;
+        glm::vec3 n(cos(angle), 0.0f, sin(angle));
+        float u = static_cast<float>(i) / segments;
+        m_vertices.push_back({ glm::vec3(n.x, 0.0f, n.z), n, glm::vec2(u, 0.0f) });
+        m_vertices.push_back({ glm::vec3(n.x, 1.0f, n.z), n, glm::vec2(u, 1.0f) });
+    }
+    for (int i = 0; i < segments; ++i) {
+        GLuint b0 = i * 2, t0 = b0 + 1, b1 = b0 + 2, t1 = b0 + 3;
+        m_indices.insert(m_indices.end(), { b0, t0, t1, b0, t1, b1 });
+    }
+
+    // caps: center vertex plus a ring, top faces +Y and bottom faces -Y
+    for (int cap = 0; cap < 2; ++cap) {
+        float y = (cap == 0) ? 1.0f : 0.0f;
+        glm::vec3 n(0.0f, (cap == 0) ? 1.0f : -1.0f, 0.0f);
+        GLuint center = static_cast<GLuint>(m_vertices.size() - m_ranges[MESH_CYLINDER][lod].baseVertex);
+        m_vertices.push_back({ glm::vec3(0.0f, y, 0.0f), n, glm::vec2(0.5f, 0.5f) });
+        for (int i = 0; i <= segments; ++i) {
+            float angle = 2.0f * PI * i / segments;
+            float x = cos(angle), z = sin(angle);
+            m_vertices.push_back({ glm::vec3(x, y, z), n, glm::vec2(0.5f + 0.5f * x, 0.5f + 0.5f * z) });
+        }
+        for (int i = 0; i < segments; ++i) {
+            GLuint r0 = center + 1 + i, r1 = r0 + 1;
+            if (cap == 0) m_indices.insert(m_indices.end(), { center, r1, r0 });
+            else m_indices.insert(m_indices.end(), { center, r0, r1 });
+        }
+    }
+
+    EndMesh(MESH_CYLINDER, lod);
+}
+
+
+// --- Enhancement: Cone with base radius 1 at y = 0 and apex at y = 1 ---
+void MeshLibrary::AddCone(int segments, int lod) {
+    BeginMesh(MESH_CONE, lod);
+
+    // sides: each segment gets its own apex vertex so the normals stay smooth
+    for (int i = 0; i <= segments; ++i) {
+        float angle = 2.0f * PI * i / segments;
+        float x = cos(angle), z = sin(angle);
+        glm::vec3 n = glm::normalize(glm::vec3(x, 1.0f, z));
+        float u = static_cast<float>(i) / segments;
+        m_vertices.push_back({ glm::vec3(x, 0.0f, z), n, glm::vec2(u, 0.0f) });
+        m_vertices.push_back({ glm::vec3(0.0f, 1.0f, 0.0f), n, glm::vec2(u, 1.0f) });
+    }
+    for (int i = 0; i < segments; ++i) {
+        GLuint b0 = i * 2, apex = b0 + 1, b1 = b0 + 2;
+        m_indices.insert(m_indices.end(), { b0, apex, b1 });
+    }
+
+    // base cap facing -Y
+    glm::vec3 n(0.0f, -1.0f, 0.0f);
+    GLuint center = static_cast<GLuint>(m_vertices.size() - m_ranges[MESH_CONE][lod].baseVertex);
+    m_vertices.push_back({ glm::vec3(0.0f), n, glm::vec2(0.5f, 0.5f) });
+    for (int i = 0; i <= segments; ++i) {
+        float angle = 2.0f * PI * i / segments;
+        float x = cos(angle), z = sin(angle);
+        m_vertices.push_back({ glm::vec3(x, 0.0f, z), n, glm::vec2(0.5f + 0.5f * x, 0.5f + 0.5f * z) });
+    }
+    for (int i = 0; i < segments; ++i) {
+        GLuint r0 = center + 1 + i, r1 = r0 + 1;
+        m_indices.insert(m_indices.end(), { center, r0, r1 });
+    }
+
+    EndMesh(MESH_CONE, lod);
+}
+
+
+// --- Enhancement: UV sphere of radius 1 centered on the origin ---
+void MeshLibrary::AddSphere(int stacks, int sectors, int lod) {
+    BeginMesh(MESH_SPHERE, lod);
+
+    for (int i = 0; i <= stacks; ++i) {
+        float phi = PI / 2.0f - PI * i / stacks;
+        float y = sin(phi);
+        float ring = cos(phi);
+        for (int j = 0; j <= sectors; ++j) {
+            float theta = 2.0f * PI * j / sectors;
+            glm::vec3 p(ring * cos(theta), y, ring * sin(theta));
+            m_vertices.push_back({ p, p, glm::vec2(static_cast<float>(j) / sectors, 1.0f - static_cast<float>(i) / stacks) });
+        }
+    }
+    for (int i = 0; i < stacks; ++i) {
+        for (int j = 0; j < sectors; ++j) {
+            GLuint k1 = i * (sectors + 1) + j;
+            GLuint k2 = k1 + sectors + 1;
+            if (i != 0) m_indices.insert(m_indices.end(), { k1, k1 + 1, k2 });
+            if (i != stacks - 1) m_indices.insert(m_indices.end(), { k1 + 1, k2 + 1, k2 });
+        }
+    }
+
+    EndMesh(MESH_SPHERE, lod);
+}
+
+
+// --- Enhancement: Stream this frame's indirect commands and per-draw data ---
+// The draw index buffer only holds 0..capacity-1 and is rewritten when
+// the capacity grows; the other two buffers are orphaned every frame
+// like the instance buffer.
+void MeshLibrary::UploadDrawCommands(const std::vector<DrawElementsIndirectCommand>& commands,
+                                     const std::vector<DrawData>& drawData) {
+    if (commands.empty()) return;
+
+    if (drawData.size() > m_drawCapacity || commands.size() > m_drawCapacity) {
+        m_drawCapacity = std::max(drawData.size(), commands.size()) * 2;
+
+        std::vector<GLint> drawIndices(m_drawCapacity);
+        for (size_t i = 0; i < drawIndices.size(); ++i) drawIndices[i] = static_cast<GLint>(i);
+        glBindBuffer(GL_ARRAY_BUFFER, m_drawIndexBuffer);
+        glBufferData(GL_ARRAY_BUFFER, drawIndices.size() * sizeof(GLint), drawIndices.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    BindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, m_drawCapacity * sizeof(DrawElementsIndirectCommand), NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, commands.size() * sizeof(DrawElementsIndirectCommand), commands.data());
+    BindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_drawDataBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, m_drawCapacity * sizeof(DrawData), NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, drawData.size() * sizeof(DrawData), drawData.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    SetDrawCommandSource(m_commandBuffer, 0, m_drawDataBuffer, 0, drawData.size() * sizeof(DrawData));
+}
+
+
+// --- Enhancement: Read indirect commands and per-draw data from memory the caller already wrote ---
+void MeshLibrary::SetDrawCommandSource(GLuint commandBuffer, GLintptr commandOffset,
+                                       GLuint dataBuffer, GLintptr dataOffset, GLsizeiptr dataSize) {
+    m_commandSource = commandBuffer;
+    m_commandSourceOffset = commandOffset;
+    m_drawDataSource = dataBuffer;
+    m_drawDataSourceOffset = dataOffset;
+    m_drawDataSourceSize = dataSize;
+}
+
+
+void MeshLibrary::BindIndirect() const {
+    BindVertexArray(m_indirectVao);
+    BindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandSource);
+    if (m_bindings)
+        m_bindings->BindBufferRange(GL_SHADER_STORAGE_BUFFER, DRAW_DATA_BINDING, m_drawDataSource,
+            m_drawDataSourceOffset, m_drawDataSourceSize);
+    else
+        glBindBufferRange(GL_SHADER_STORAGE_BUFFER, DRAW_DATA_BINDING, m_drawDataSource,
+            m_drawDataSourceOffset, m_drawDataSourceSize);
+}
+
+
+// --- Enhancement: Many objects, any mix of meshes, in one draw call ---
+void MeshLibrary::MultiDrawIndirect(size_t firstCommand, GLsizei count) const {
+    glMultiDrawElementsIndirect(
+        GL_TRIANGLES,
+        GL_UNSIGNED_INT,
+        (void*)(m_commandSourceOffset + firstCommand * sizeof(DrawElementsIndirectCommand)),
+        count,
+        0);
+}
@@ -0,0 +1,200 @@
+/***********************************************************
+ *
+ *  MeshLibrary.h
+ *	============
+ *  shared indexed geometry for instanced drawing
+ *
+ ***********************************************************/
+
+#pragma once
+#include <vector>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+class BindingCache;
+
+
+// --- Enhancement: Basic mesh shapes that a scene object can be drawn with ---
+enum MeshType {
+    MESH_BOX = 0,
+    MESH_PLANE,
+    MESH_CYLINDER,
+    MESH_CONE,
+    MESH_SPHERE,
+    MESH_COUNT
+};
+
+
+// --- Enhancement: Interleaved vertex, same layout as ShapeMeshes ---
+// location 0 = position, 1 = normal, 2 = texture coordinate
+struct MeshVertex {
+    glm::vec3 position;
+    glm::vec3 normal;
+    glm::vec2 uv;
+};
+
+
+// --- Enhancement: Where one mesh lives inside the shared buffers ---
+struct MeshRange {
+    GLuint firstIndex = 0;
+    GLsizei indexCount = 0;
+    GLint baseVertex = 0;
+    GLsizei vertexCount = 0;
+};
+
+
+// --- Enhancement: Per-instance data read by the vertex shader ---
+// location 3..6 = model matrix columns, 7 = color, 8..10 = normal matrix columns,
+// 11 = material index into the material uniform buffer,
+// 12 = texture layer when TextureManager uses texture arrays
+struct InstanceData {
+    glm::mat4 model;
+    glm::vec4 color;
+    glm::mat3 normalMatrix;
+    GLint materialIndex;
+    GLint textureLayer;
+};
+
+
+// --- Enhancement: Per-draw data for multi-draw-indirect, std430 layout ---
+// Read by the vertex shader from the DrawDataBlock storage buffer;
+// entry i belongs to the indirect command whose baseInstance is i.
+struct DrawData {
+    glm::mat4 model;
+    glm::mat4 normalMatrix;     // upper 3x3 is used
+    glm::vec4 color;
+    glm::vec2 uvScale;
+    GLint materialIndex;
+    GLint textureLayer;         // -1 = untextured, draw with color
+};
+
+
+// --- Enhancement: One command of a glMultiDrawElementsIndirect call ---
+struct DrawElementsIndirectCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+
+/***********************************************************
+ *  MeshLibrary
+ *
+ *  Builds the basic shapes as indexed triangle lists packed
+ *  into one vertex buffer and one index buffer, behind one
+ *  VAO. Unlike ShapeMeshes, the VAO and index ranges are
+ *  exposed so that many copies of a mesh can be drawn with
+ *  a single instanced draw call. The shapes match the size
+ *  and orientation of the ShapeMeshes versions so the same
+ *  scene transforms apply.
+ ***********************************************************/
+class MeshLibrary {
+public:
+    // Must match the DrawDataBlock binding in vertexShader.glsl
+    static const GLuint DRAW_DATA_BINDING = 2;
+
+    // Enhancement: detail levels of each mesh; every level halves the
+    // segment counts of the one before it. Boxes and planes have
+    // nothing to reduce, so all of their levels are the same range.
+    static const int LOD_COUNT = 3;
+
+    MeshLibrary();
+    ~MeshLibrary();
+
+    // Builds every mesh and uploads it to the GPU
+    void LoadMeshes();
+
+    // Deletes the GPU buffers
+    void DestroyMeshes();
+
+    // Enhancement: routes the draw-time binds through `bindings` so that
+    // redundant ones are dropped; nullptr binds directly
+    void SetBindingCache(BindingCache* bindings) { m_bindings = bindings; }
+
+    // Copies per-instance data into the instance buffer, growing it if needed
+    void UploadInstances(const std::vector<InstanceData>& instances);
+
+    // Makes instanced draws read instance data from `buffer` at `offset`;
+    // UploadInstances() points this back at the library's own buffer
+    void SetInstanceSource(GLuint buffer, GLintptr offset);
+
+    // Binds the shared VAO (vertex, index and instance buffers)
+    void Bind() const;
+
+    // Draws `count` instances of a mesh, reading instance data from `baseInstance` onward
+    void DrawInstanced(MeshType mesh, GLuint baseInstance, GLsizei count, int lod = 0) const;
+
+    // Draws one copy of a mesh with the shader's model uniform (no per-instance data)
+    void Draw(MeshType mesh, int lod = 0) const;
+
+    // Copies indirect commands and their per-draw data to the GPU, growing the buffers if needed
+    void UploadDrawCommands(const std::vector<DrawElementsIndirectCommand>& commands,
+                            const std::vector<DrawData>& drawData);
+
+    // Makes indirect draws read their commands and per-draw data from the given
+    // buffer ranges; UploadDrawCommands() points these back at the library's own buffers
+    void SetDrawCommandSource(GLuint commandBuffer, GLintptr commandOffset,
+                              GLuint dataBuffer, GLintptr dataOffset, GLsizeiptr dataSize);
+
+    // Binds the indirect VAO (vertex, index and draw index buffers),
+    // the indirect command buffer and the per-draw storage buffer
+    void BindIndirect() const;
+
+    // Draws `count` uploaded commands starting at `firstCommand` with one call
+    void MultiDrawIndirect(size_t firstCommand, GLsizei count) const;
+
+    const MeshRange& GetRange(MeshType mesh, int lod = 0) const { return m_ranges[mesh][lod]; }
+
+    // Enhancement: CPU copy of the shared buffers, kept after upload so
+    // that static geometry can be baked from it
+    const std::vector<MeshVertex>& GetVertices() const { return m_vertices; }
+    const std::vector<GLuint>& GetIndices() const { return m_indices; }
+
+private:
+    void AddBox();
+    void AddPlane();
+    void AddCylinder(int segments, int lod);
+    void AddCone(int segments, int lod);
+    void AddSphere(int stacks, int sectors, int lod);
+
+    // Starts a new mesh range at the current end of the vertex/index lists
+    void BeginMesh(MeshType mesh, int lod = 0);
+    void EndMesh(MeshType mesh, int lod = 0);
+
+    // Bind through the binding cache when one is set
+    void BindVertexArray(GLuint vao) const;
+    void BindBuffer(GLenum target, GLuint buffer) const;
+
+    std::vector<MeshVertex> m_vertices;
+    std::vector<GLuint> m_indices;
+    MeshRange m_ranges[MESH_COUNT][LOD_COUNT];
+
+    GLuint m_vao = 0;
+    GLuint m_vertexBuffer = 0;
+    GLuint m_indexBuffer = 0;
+    GLuint m_instanceBuffer = 0;
+    size_t m_instanceCapacity = 0;
+
+    // Enhancement: multi-draw-indirect. The indirect VAO shares the vertex
+    // and index buffers but reads only a draw index per instance, so that
+    // baseInstance selects the per-draw data of each command.
+    GLuint m_indirectVao = 0;
+    GLuint m_drawIndexBuffer = 0;
+    GLuint m_commandBuffer = 0;
+    GLuint m_drawDataBuffer = 0;
+    size_t m_drawCapacity = 0;
+
+    // Enhancement: where instance data, indirect commands and per-draw
+    // data are currently read from
+    GLuint m_instanceSource = 0;
+    GLintptr m_instanceSourceOffset = 0;
+    GLuint m_commandSource = 0;
+    GLintptr m_commandSourceOffset = 0;
+    GLuint m_drawDataSource = 0;
+    GLintptr m_drawDataSourceOffset = 0;
+    GLsizeiptr m_drawDataSourceSize = 0;
+
+    BindingCache* m_bindings = nullptr;
+};
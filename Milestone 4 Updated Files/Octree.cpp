@@ -7,6 +7,7 @@
  ***********************************************************/
 
 #include "Octree.h"
+#include <algorithm>
 
 
 // --- Enhancement: Octree constructor implementation ---
@@ -23,24 +24,24 @@ OctreeNode::~OctreeNode() {
 
 
 // --- Enhancement: Insert object into Octree for spatial partitioning ---
-void OctreeNode::insert(SceneObject* obj) {
+void OctreeNode::insert(EntityHandle entity, const glm::vec3& position) {
     if (depth == MAX_DEPTH) {
-        objects.push_back(obj);
+        objects.push_back({ entity, position });
         return;
     }
     if (objects.size() < MAX_OBJECTS) {
-        objects.push_back(obj);
+        objects.push_back({ entity, position });
         return;
     }
     if (!children[0]) subdivide();
     for (int i = 0; i < 8; ++i) {
-        if (children[i]->bounds.contains(obj->position)) {
-            children[i]->insert(obj);
+        if (children[i]->bounds.contains(position)) {
+            children[i]->insert(entity, position);
             return;
         }
     }
     // If object doesn't fit in any child, keep it here
-    objects.push_back(obj);
+    objects.push_back({ entity, position });
 }
 
 
@@ -61,10 +62,10 @@ void OctreeNode::subdivide() {
         children[i] = new OctreeNode(childBounds, depth + 1);
     }
     // Move existing objects into children
-    for (auto obj : objects) {
+    for (const auto& entry : objects) {
         for (int i = 0; i < 8; ++i) {
-            if (children[i]->bounds.contains(obj->position)) {
-                children[i]->insert(obj);
+            if (children[i]->bounds.contains(entry.position)) {
+                children[i]->insert(entry.entity, entry.position);
                 break;
             }
         }
@@ -74,13 +75,32 @@ void OctreeNode::subdivide() {
 
 
 // --- Enhancement: Query Octree for objects within a region (e.g., camera frustum) ---
-void OctreeNode::query(const AABB& range, std::vector<SceneObject*>& found) {
+void OctreeNode::query(const AABB& range, std::vector<EntityHandle>& found) {
     if (!bounds.intersects(range)) return;
-    for (auto obj : objects) {
-        if (range.contains(obj->position))
-            found.push_back(obj);
+    for (const auto& entry : objects) {
+        if (range.contains(entry.position))
+            found.push_back(entry.entity);
     }
     if (!children[0]) return;
     for (int i = 0; i < 8; ++i)
         children[i]->query(range, found);
 }
+
+
+// --- Enhancement: Remove an object before it is re-inserted at a new position ---
+// Only the children containing the old position can hold it; an object
+// outside every child stays in the node it was inserted into.
+bool OctreeNode::remove(EntityHandle entity, const glm::vec3& position) {
+    auto it = std::find_if(objects.begin(), objects.end(),
+        [&](const OctreeEntry& entry) { return entry.entity == entity; });
+    if (it != objects.end()) {
+        objects.erase(it);
+        return true;
+    }
+    if (!children[0]) return false;
+    for (int i = 0; i < 8; ++i) {
+        if (children[i]->bounds.contains(position) && children[i]->remove(entity, position))
+            return true;
+    }
+    return false;
+}
@@ -10,6 +10,7 @@
 #include <vector>
 #include <glm/glm.hpp>
 #include <string>
+#include "EntityStore.h"
 
 // Axis-aligned bounding box 
 // --- Enhancement: Axis-aligned bounding box for spatial partitioning (Octree) ---
@@ -32,12 +33,33 @@ struct AABB {
 
 
 // --- Enhancement: Minimal scene object for Octree spatial partitioning ---
+// Now only the saved form of an object (see JsonDatabase); at run time
+// objects live in SceneManager's EntityStore and the octree keeps handles.
 struct SceneObject {
-    glm::vec3 position;
+    glm::vec3 position;         // relative to the parent, if there is one
     float boundingRadius;
     std::string tag;
-    // Add a pointer or reference to your mesh/object data as needed
-    // e.g., int meshID; or ShapeMeshes* mesh;
+    // --- Enhancement: Node rotation (degrees about X, Y, Z) and scale ---
+    // Relative to the parent like the position, so children turn and scale
+    // with it; the tag's own mesh shape comes on top of this.
+    glm::vec3 rotation = glm::vec3(0.0f);
+    glm::vec3 scale = glm::vec3(1.0f);
+    // --- Enhancement: Optional parent object (SceneManager's scene graph) ---
+    // Index of the parent in the saved object list, or -1.
+    int parentIndex = -1;
+    // --- Enhancement: Object never moves and may be batched with others ---
+    bool isStatic = false;
+    // --- Enhancement: Persistent ID, kept across saves and loads ---
+    // 0 = none (saves from before IDs); one is handed out on load.
+    uint32_t id = 0;
+};
+
+
+// --- Enhancement: One object in an octree node ---
+// The position is copied in, so a query never touches the entity store.
+struct OctreeEntry {
+    EntityHandle entity;
+    glm::vec3 position;
 };
 
 
@@ -45,7 +67,7 @@ struct SceneObject {
 class OctreeNode {
 public:
     AABB bounds;
-    std::vector<SceneObject*> objects;
+    std::vector<OctreeEntry> objects;
     OctreeNode* children[8] = { nullptr };
     int depth;
     static const int MAX_OBJECTS = 8;
@@ -57,11 +79,14 @@ public:
     ~OctreeNode();
 
     // --- Enhancement: Insert object into Octree for spatial partitioning ---
-    void insert(SceneObject* obj);
+    void insert(EntityHandle entity, const glm::vec3& position);
 
     // --- Enhancement: Subdivide Octree node for finer partitioning ---
     void subdivide();
 
     // --- Enhancement: Query Octree for objects within a region (e.g., camera frustum) ---
-    void query(const AABB& range, std::vector<SceneObject*>& found);
+    void query(const AABB& range, std::vector<EntityHandle>& found);
+
+    // --- Enhancement: Remove an object that was inserted at `position` ---
+    bool remove(EntityHandle entity, const glm::vec3& position);
 };
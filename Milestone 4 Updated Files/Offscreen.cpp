@@ -0,0 +1,143 @@
+/***********************************************************
+ *
+ *  Offscreen.cpp
+ *	============
+ *  OpenGL without a window: EGL context and framebuffer target
+ *
+ ***********************************************************/
+
+#include "Offscreen.h"
+#include <EGL/eglext.h>
+#include <cstring>
+#include <iostream>
+
+
+OffscreenContext::OffscreenContext() : m_display(EGL_NO_DISPLAY), m_context(EGL_NO_CONTEXT) {
+}
+
+OffscreenContext::~OffscreenContext() {
+    Destroy();
+}
+
+
+// --- Enhancement: Surfaceless EGL display, no config, no surface ---
+bool OffscreenContext::Create(int majorVersion, int minorVersion) {
+    Destroy();
+
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (getPlatformDisplay == NULL) {
+        std::cout << "EGL: eglGetPlatformDisplayEXT is not available" << std::endl;
+        return false;
+    }
+
+    m_display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    EGLint major = 0, minor = 0;
+    if (m_display == EGL_NO_DISPLAY || !eglInitialize(m_display, &major, &minor)) {
+        std::cout << "EGL: no surfaceless display" << std::endl;
+        m_display = EGL_NO_DISPLAY;
+        return false;
+    }
+
+    // without a surface the context needs no config
+    const char* extensions = eglQueryString(m_display, EGL_EXTENSIONS);
+    if (extensions == NULL || strstr(extensions, "EGL_KHR_surfaceless_context") == NULL ||
+        strstr(extensions, "EGL_KHR_no_config_context") == NULL) {
+        std::cout << "EGL: surfaceless or config-less contexts are not supported" << std::endl;
+        Destroy();
+        return false;
+    }
+
+    const EGLint contextAttributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, majorVersion,
+        EGL_CONTEXT_MINOR_VERSION, minorVersion,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    eglBindAPI(EGL_OPENGL_API);
+    m_context = eglCreateContext(m_display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, contextAttributes);
+    if (m_context == EGL_NO_CONTEXT ||
+        !eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, m_context)) {
+        Destroy();
+        return false;
+    }
+    return true;
+}
+
+
+void OffscreenContext::Destroy() {
+    if (m_display == EGL_NO_DISPLAY) return;
+    eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (m_context != EGL_NO_CONTEXT)
+        eglDestroyContext(m_display, m_context);
+    eglTerminate(m_display);
+    m_context = EGL_NO_CONTEXT;
+    m_display = EGL_NO_DISPLAY;
+}
+
+
+OffscreenTarget::OffscreenTarget()
+    : m_framebuffer(0), m_colorBuffer(0), m_depthBuffer(0), m_width(0), m_height(0) {
+}
+
+OffscreenTarget::~OffscreenTarget() {
+    Destroy();
+}
+
+
+bool OffscreenTarget::Create(int width, int height) {
+    Destroy();
+    m_width = width;
+    m_height = height;
+
+    glGenFramebuffers(1, &m_framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+
+    glGenRenderbuffers(1, &m_colorBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_colorBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_colorBuffer);
+
+    glGenRenderbuffers(1, &m_depthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_depthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cout << "Offscreen framebuffer is incomplete" << std::endl;
+        Destroy();
+        return false;
+    }
+    return true;
+}
+
+
+void OffscreenTarget::Destroy() {
+    if (!m_framebuffer) return;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteRenderbuffers(1, &m_depthBuffer);
+    glDeleteRenderbuffers(1, &m_colorBuffer);
+    glDeleteFramebuffers(1, &m_framebuffer);
+    m_framebuffer = m_colorBuffer = m_depthBuffer = 0;
+}
+
+
+void OffscreenTarget::Bind() const {
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    glViewport(0, 0, m_width, m_height);
+}
+
+
+// --- Enhancement: OpenGL's rows are bottom up, image files top down ---
+void OffscreenTarget::ReadPixels(std::vector<unsigned char>& rgba) const {
+    const size_t stride = static_cast<size_t>(m_width) * 4;
+    std::vector<unsigned char> bottomUp(stride * m_height);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_framebuffer);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, bottomUp.data());
+
+    rgba.resize(bottomUp.size());
+    for (int y = 0; y < m_height; ++y)
+        memcpy(&rgba[y * stride], &bottomUp[(m_height - 1 - y) * stride], stride);
+}
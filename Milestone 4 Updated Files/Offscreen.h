@@ -0,0 +1,68 @@
+/***********************************************************
+ *
+ *  Offscreen.h
+ *	============
+ *  OpenGL without a window: EGL context and framebuffer target
+ *
+ ***********************************************************/
+
+#pragma once
+#include <GL/glew.h>
+#include <EGL/egl.h>
+#include <vector>
+
+
+/***********************************************************
+ *  OffscreenContext
+ *
+ *  A core profile OpenGL context on an EGL display with no
+ *  window system (EGL_MESA_platform_surfaceless), so the
+ *  renderer runs on a headless machine, e.g. Mesa llvmpipe
+ *  in automation. The context has no default framebuffer;
+ *  everything is drawn into an OffscreenTarget.
+ ***********************************************************/
+class OffscreenContext {
+public:
+    OffscreenContext();
+    ~OffscreenContext();
+
+    // Creates the context and makes it current
+    bool Create(int majorVersion, int minorVersion);
+    void Destroy();
+
+private:
+    EGLDisplay m_display;
+    EGLContext m_context;
+};
+
+
+/***********************************************************
+ *  OffscreenTarget
+ *
+ *  Framebuffer object with an RGBA8 color and a 24-bit
+ *  depth renderbuffer that stands in for the window.
+ ***********************************************************/
+class OffscreenTarget {
+public:
+    OffscreenTarget();
+    ~OffscreenTarget();
+
+    bool Create(int width, int height);
+    void Destroy();
+
+    // Binds the framebuffer and sets the viewport to cover it
+    void Bind() const;
+
+    // Reads the color buffer as RGBA, top row first like an image file
+    void ReadPixels(std::vector<unsigned char>& rgba) const;
+
+    int Width() const { return m_width; }
+    int Height() const { return m_height; }
+
+private:
+    GLuint m_framebuffer;
+    GLuint m_colorBuffer;
+    GLuint m_depthBuffer;
+    int m_width;
+    int m_height;
+};
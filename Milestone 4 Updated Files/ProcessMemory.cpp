@@ -0,0 +1,41 @@
+/***********************************************************
+ *
+ *  ProcessMemory.cpp
+ *	============
+ *  resident memory of the running process
+ *
+ ***********************************************************/
+
+#include "ProcessMemory.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__linux__)
+#include <cstdio>
+#endif
+
+
+ProcessMemory ProcessMemory::Query() {
+    ProcessMemory memory;
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        memory.residentBytes = counters.WorkingSetSize;
+        memory.peakResidentBytes = counters.PeakWorkingSetSize;
+    }
+#elif defined(__linux__)
+    FILE* status = std::fopen("/proc/self/status", "r");
+    if (!status) return memory;
+    char line[256];
+    unsigned long kilobytes;
+    while (std::fgets(line, sizeof(line), status)) {
+        if (std::sscanf(line, "VmRSS: %lu kB", &kilobytes) == 1)
+            memory.residentBytes = static_cast<size_t>(kilobytes) * 1024;
+        else if (std::sscanf(line, "VmHWM: %lu kB", &kilobytes) == 1)
+            memory.peakResidentBytes = static_cast<size_t>(kilobytes) * 1024;
+    }
+    std::fclose(status);
+#endif
+    return memory;
+}
@@ -0,0 +1,30 @@
+/***********************************************************
+ *
+ *  ProcessMemory.h
+ *	============
+ *  resident memory of the running process
+ *
+ ***********************************************************/
+
+#pragma once
+#include <cstddef>
+
+
+/***********************************************************
+ *  ProcessMemory
+ *
+ *  What the operating system reports the process holds in
+ *  memory: VmRSS and VmHWM from /proc/self/status on Linux,
+ *  the working set and its peak on Windows. Both are zero
+ *  where neither is available. This is everything the
+ *  process maps, driver memory included, not only the
+ *  scene; it is meant for comparing runs with one another.
+ ***********************************************************/
+struct ProcessMemory {
+    size_t residentBytes = 0;
+    size_t peakResidentBytes = 0;
+
+    static ProcessMemory Query();
+
+    static double Megabytes(size_t bytes) { return bytes / (1024.0 * 1024.0); }
+};
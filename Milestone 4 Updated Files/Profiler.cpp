@@ -0,0 +1,258 @@
+/***********************************************************
+ *
+ *  Profiler.cpp
+ *	============
+ *  scoped CPU and GPU timing, exported as a Chrome trace
+ *
+ ***********************************************************/
+
+#include "Profiler.h"
+
+#if PROFILER_ENABLED
+
+#include <GL/glew.h>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+
+namespace
+{
+    struct TraceEvent {
+        const char* name;
+        int64_t startNs;
+        int64_t durationNs;
+    };
+
+    // --- Enhancement: One thread's events, written only by that thread ---
+    // The writer fills a slot, then publishes it by bumping `written`
+    // with release order; the reader loads `written` with acquire order.
+    struct ThreadBuffer {
+        TraceEvent events[Profiler::EVENTS_PER_THREAD];
+        std::atomic<uint64_t> written{ 0 };
+        int trackId = 0;
+        std::string name;
+        bool inUse = true;      // guarded by g_threadsMutex
+    };
+
+    // --- Enhancement: The events of a thread that has exited ---
+    struct RetiredTrack {
+        int trackId;
+        std::string name;
+        std::vector<TraceEvent> events;
+    };
+
+    std::mutex g_threadsMutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> g_threads;
+    std::deque<RetiredTrack> g_retiredTracks;   // guarded by g_threadsMutex
+    int g_nextTrackId = 1;                      // guarded by g_threadsMutex
+
+    // --- Enhancement: Hands a thread's buffer back when the thread exits ---
+    struct ThreadBufferOwner {
+        ThreadBuffer* buffer = nullptr;
+
+        ~ThreadBufferOwner() {
+            if (!buffer) return;
+            std::lock_guard<std::mutex> lock(g_threadsMutex);
+            buffer->inUse = false;
+        }
+    };
+    thread_local ThreadBufferOwner t_owner;
+
+    // every timestamp is relative to start-up, which keeps the trace short
+    const std::chrono::steady_clock::time_point g_startTime = std::chrono::steady_clock::now();
+
+    ThreadBuffer* CurrentThreadBuffer() {
+        if (t_owner.buffer == nullptr) {
+            std::lock_guard<std::mutex> lock(g_threadsMutex);
+            // a released buffer's events are moved to a retired track under
+            // the old thread's name; this thread starts empty on a new one
+            for (const std::unique_ptr<ThreadBuffer>& buffer : g_threads) {
+                if (buffer->inUse) continue;
+                uint64_t written = buffer->written.load(std::memory_order_acquire);
+                if (written > 0) {
+                    uint64_t oldest = written > Profiler::EVENTS_PER_THREAD ? written - Profiler::EVENTS_PER_THREAD : 0;
+                    RetiredTrack retired = { buffer->trackId, buffer->name, {} };
+                    retired.events.reserve(static_cast<size_t>(written - oldest));
+                    for (uint64_t i = oldest; i < written; ++i)
+                        retired.events.push_back(buffer->events[i % Profiler::EVENTS_PER_THREAD]);
+                    g_retiredTracks.push_back(std::move(retired));
+                    if (g_retiredTracks.size() > Profiler::RETIRED_TRACKS)
+                        g_retiredTracks.pop_front();
+                }
+                buffer->written.store(0, std::memory_order_relaxed);
+                buffer->trackId = g_nextTrackId++;
+                buffer->inUse = true;
+                buffer->name.clear();
+                t_owner.buffer = buffer.get();
+                return t_owner.buffer;
+            }
+            std::unique_ptr<ThreadBuffer> buffer(new ThreadBuffer());
+            buffer->trackId = g_nextTrackId++;
+            t_owner.buffer = buffer.get();
+            g_threads.push_back(std::move(buffer));
+        }
+        return t_owner.buffer;
+    }
+
+    // --- Enhancement: GPU spans of the last two frames (GL thread only) ---
+    struct GpuSpan {
+        const char* name;
+        GLuint queries[2];      // start and end timestamp
+    };
+
+    std::vector<GpuSpan> g_gpuFrames[2];
+    int g_gpuFrame = 0;
+    std::vector<GLuint> g_freeQueries;
+
+    TraceEvent g_gpuEvents[Profiler::GPU_EVENTS];
+    uint64_t g_gpuWritten = 0;
+    uint64_t g_gpuDropped = 0;
+
+    bool g_gpuCalibrated = false;
+    int64_t g_gpuOffsetNs = 0;      // CPU time = GPU time + offset
+
+    GLuint AcquireQuery() {
+        if (g_freeQueries.empty()) {
+            GLuint queries[16];
+            glGenQueries(16, queries);
+            g_freeQueries.insert(g_freeQueries.end(), queries, queries + 16);
+        }
+        GLuint query = g_freeQueries.back();
+        g_freeQueries.pop_back();
+        return query;
+    }
+
+    // Chrome expects microseconds
+    double Microseconds(int64_t ns) {
+        return ns / 1000.0;
+    }
+
+    void WriteEvent(std::ofstream& file, bool& first, const TraceEvent& event, int pid, int tid) {
+        file << (first ? "\n" : ",\n");
+        first = false;
+        file << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":" << pid << ",\"tid\":" << tid
+            << ",\"ts\":" << Microseconds(event.startNs) << ",\"dur\":" << Microseconds(event.durationNs) << "}";
+    }
+
+    void WriteName(std::ofstream& file, bool& first, const char* kind, const std::string& name, int pid, int tid) {
+        file << (first ? "\n" : ",\n");
+        first = false;
+        file << "{\"name\":\"" << kind << "\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << tid
+            << ",\"args\":{\"name\":\"" << name << "\"}}";
+    }
+}
+
+
+int64_t Profiler::NowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - g_startTime).count();
+}
+
+
+void Profiler::SetThreadName(const char* name) {
+    ThreadBuffer* buffer = CurrentThreadBuffer();
+    std::lock_guard<std::mutex> lock(g_threadsMutex);
+    buffer->name = name;
+}
+
+
+void Profiler::RecordCpu(const char* name, int64_t startNs, int64_t endNs) {
+    ThreadBuffer* buffer = CurrentThreadBuffer();
+    uint64_t index = buffer->written.load(std::memory_order_relaxed);
+    buffer->events[index % EVENTS_PER_THREAD] = TraceEvent{ name, startNs, endNs - startNs };
+    buffer->written.store(index + 1, std::memory_order_release);
+}
+
+
+int Profiler::BeginGpu(const char* name) {
+    if (!g_gpuCalibrated) {
+        GLint64 gpuNow = 0;
+        glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+        g_gpuOffsetNs = NowNs() - gpuNow;
+        g_gpuCalibrated = true;
+    }
+
+    GpuSpan span = { name, { AcquireQuery(), AcquireQuery() } };
+    glQueryCounter(span.queries[0], GL_TIMESTAMP);
+    g_gpuFrames[g_gpuFrame].push_back(span);
+    return static_cast<int>(g_gpuFrames[g_gpuFrame].size()) - 1;
+}
+
+
+void Profiler::EndGpu(int id) {
+    glQueryCounter(g_gpuFrames[g_gpuFrame][id].queries[1], GL_TIMESTAMP);
+}
+
+
+// --- Enhancement: Read back the frame before this one ---
+void Profiler::EndFrame() {
+    g_gpuFrame ^= 1;
+    std::vector<GpuSpan>& spans = g_gpuFrames[g_gpuFrame];
+    for (const GpuSpan& span : spans) {
+        GLint available = 0;
+        glGetQueryObjectiv(span.queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available) {
+            GLuint64 start = 0, end = 0;
+            glGetQueryObjectui64v(span.queries[0], GL_QUERY_RESULT, &start);
+            glGetQueryObjectui64v(span.queries[1], GL_QUERY_RESULT, &end);
+            g_gpuEvents[g_gpuWritten % GPU_EVENTS] = TraceEvent{ span.name,
+                static_cast<int64_t>(start) + g_gpuOffsetNs, static_cast<int64_t>(end - start) };
+            ++g_gpuWritten;
+        }
+        else {
+            ++g_gpuDropped;
+        }
+        g_freeQueries.push_back(span.queries[0]);
+        g_freeQueries.push_back(span.queries[1]);
+    }
+    spans.clear();
+}
+
+
+// --- Enhancement: Chrome trace_event JSON, pid 1 = CPU threads, pid 2 = GPU ---
+bool Profiler::WriteTrace(const std::string& filename) {
+    std::ofstream file(filename);
+    if (!file.is_open()) return false;
+
+    // microseconds since start-up, to the nanosecond
+    file << std::fixed << std::setprecision(3);
+    bool first = true;
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    WriteName(file, first, "process_name", "CPU", 1, 0);
+    WriteName(file, first, "process_name", "GPU", 2, 0);
+
+    {
+        std::lock_guard<std::mutex> lock(g_threadsMutex);
+        for (const std::unique_ptr<ThreadBuffer>& buffer : g_threads) {
+            std::string name = buffer->name.empty() ? "Thread" : buffer->name;
+            WriteName(file, first, "thread_name", name + " " + std::to_string(buffer->trackId), 1, buffer->trackId);
+
+            uint64_t written = buffer->written.load(std::memory_order_acquire);
+            uint64_t oldest = written > EVENTS_PER_THREAD ? written - EVENTS_PER_THREAD : 0;
+            for (uint64_t i = oldest; i < written; ++i)
+                WriteEvent(file, first, buffer->events[i % EVENTS_PER_THREAD], 1, buffer->trackId);
+        }
+        for (const RetiredTrack& track : g_retiredTracks) {
+            std::string name = track.name.empty() ? "Thread" : track.name;
+            WriteName(file, first, "thread_name", name + " " + std::to_string(track.trackId) + " (exited)", 1, track.trackId);
+            for (const TraceEvent& event : track.events)
+                WriteEvent(file, first, event, 1, track.trackId);
+        }
+    }
+
+    WriteName(file, first, "thread_name", "GPU (" + std::to_string(g_gpuDropped) + " spans dropped)", 2, 1);
+    uint64_t oldest = g_gpuWritten > GPU_EVENTS ? g_gpuWritten - GPU_EVENTS : 0;
+    for (uint64_t i = oldest; i < g_gpuWritten; ++i)
+        WriteEvent(file, first, g_gpuEvents[i % GPU_EVENTS], 2, 1);
+
+    file << "\n]}\n";
+    return file.good();
+}
+
+#endif
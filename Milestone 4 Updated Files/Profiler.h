@@ -0,0 +1,120 @@
+/***********************************************************
+ *
+ *  Profiler.h
+ *	============
+ *  scoped CPU and GPU timing, exported as a Chrome trace
+ *
+ ***********************************************************/
+
+#pragma once
+#include <string>
+
+
+// --- Enhancement: The profiler only exists in debug builds ---
+// Define PROFILER_ENABLED as 1 or 0 to override; with 0 every macro
+// below expands to nothing and Profiler.cpp compiles to an empty unit.
+#ifndef PROFILER_ENABLED
+#ifdef NDEBUG
+#define PROFILER_ENABLED 0
+#else
+#define PROFILER_ENABLED 1
+#endif
+#endif
+
+
+#if PROFILER_ENABLED
+
+#include <cstdint>
+
+/***********************************************************
+ *  Profiler
+ *
+ *  CPU scopes are timed with the monotonic steady_clock and
+ *  written into a ring buffer owned by the calling thread:
+ *  one writer per buffer, so recording takes no lock, and
+ *  each buffer keeps that thread's most recent events. A
+ *  thread takes a lock once, to register its buffer. When
+ *  the thread exits, the buffer is handed to the next thread
+ *  that records, so re-created worker pools do not add a
+ *  buffer per thread ever started. Its events are copied out
+ *  first and stay on the old thread's track (the last
+ *  RETIRED_TRACKS of them are kept); the new thread starts
+ *  an empty buffer on a track of its own.
+ *
+ *  GPU scopes are bracketed with GL_TIMESTAMP queries on the
+ *  GL thread and read back one frame later, at the next
+ *  EndFrame(); spans whose results are not back by then are
+ *  dropped rather than waited for. GPU times are moved onto
+ *  the CPU clock with an offset measured at the first scope.
+ *
+ *  WriteTrace() dumps every buffer as Chrome trace_event JSON
+ *  (chrome://tracing or ui.perfetto.dev), one track per CPU
+ *  thread plus one for the GPU. Call it from the GL thread
+ *  between frames, while the worker threads are idle.
+ ***********************************************************/
+class Profiler {
+public:
+    // Events kept per thread, and GPU events kept in total
+    static const size_t EVENTS_PER_THREAD = 1 << 14;
+    static const size_t GPU_EVENTS = 1 << 14;
+    // Tracks of exited threads kept for the trace
+    static const size_t RETIRED_TRACKS = 64;
+
+    // Name of the calling thread's track in the trace
+    static void SetThreadName(const char* name);
+
+    // Records a finished CPU span on the calling thread's buffer
+    static void RecordCpu(const char* name, int64_t startNs, int64_t endNs);
+    static int64_t NowNs();
+
+    // GPU spans on the GL thread; BeginGpu returns the id EndGpu takes
+    static int BeginGpu(const char* name);
+    static void EndGpu(int id);
+
+    // Reads back the previous frame's GPU spans; call once per frame
+    static void EndFrame();
+
+    // Writes everything recorded so far; false if the file cannot be written
+    static bool WriteTrace(const std::string& filename);
+};
+
+
+// --- Enhancement: RAII scopes behind the PROFILE_* macros ---
+class ProfileScope {
+public:
+    explicit ProfileScope(const char* name) : m_name(name), m_start(Profiler::NowNs()) {}
+    ~ProfileScope() { Profiler::RecordCpu(m_name, m_start, Profiler::NowNs()); }
+
+private:
+    const char* m_name;
+    int64_t m_start;
+};
+
+class GpuProfileScope {
+public:
+    explicit GpuProfileScope(const char* name) : m_id(Profiler::BeginGpu(name)) {}
+    ~GpuProfileScope() { Profiler::EndGpu(m_id); }
+
+private:
+    int m_id;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+// names must be string literals; only the pointer is stored
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_GPU_SCOPE(name) GpuProfileScope PROFILE_CONCAT(gpuProfileScope, __LINE__)(name)
+#define PROFILE_THREAD_NAME(name) Profiler::SetThreadName(name)
+#define PROFILE_END_FRAME() Profiler::EndFrame()
+#define PROFILE_WRITE_TRACE(filename) Profiler::WriteTrace(filename)
+
+#else
+
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_GPU_SCOPE(name) ((void)0)
+#define PROFILE_THREAD_NAME(name) ((void)0)
+#define PROFILE_END_FRAME() ((void)0)
+#define PROFILE_WRITE_TRACE(filename) false
+
+#endif
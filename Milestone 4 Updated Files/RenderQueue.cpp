@@ -0,0 +1,118 @@
+/***********************************************************
+ *
+ *  RenderQueue.cpp
+ *	============
+ *  sort visible objects by render state before drawing
+ *
+ ***********************************************************/
+
+#include "RenderQueue.h"
+#include <algorithm>
+
+
+// --- Enhancement: Pack mesh, texture, material and depth into one key ---
+// Texture and material are stored as (index + 1) so that -1 ("none") maps
+// to 0 and sorts ahead of every real texture or material.
+uint64_t RenderQueue::MakeKey(int mesh, int texture, int material, float depth01,
+                              bool frontToBack) {
+    const uint64_t bucketMask = (1ull << BUCKET_BITS) - 1;
+    const uint64_t meshMask = (1ull << MESH_BITS) - 1;
+    const uint64_t textureMask = (1ull << TEXTURE_BITS) - 1;
+    const uint64_t materialMask = (1ull << MATERIAL_BITS) - 1;
+    const uint64_t depthMask = (1ull << DEPTH_BITS) - 1;
+
+    depth01 = std::min(std::max(depth01, 0.0f), 1.0f);
+    uint64_t depth = static_cast<uint64_t>(depth01 * static_cast<float>(depthMask));
+    uint64_t bucket = frontToBack ? static_cast<uint64_t>(depth01 * static_cast<float>(bucketMask)) : 0;
+
+    return ((bucket & bucketMask) << (MESH_BITS + TEXTURE_BITS + MATERIAL_BITS + DEPTH_BITS)) |
+        ((static_cast<uint64_t>(mesh) & meshMask) << (TEXTURE_BITS + MATERIAL_BITS + DEPTH_BITS)) |
+        ((static_cast<uint64_t>(texture + 1) & textureMask) << (MATERIAL_BITS + DEPTH_BITS)) |
+        ((static_cast<uint64_t>(material + 1) & materialMask) << DEPTH_BITS) |
+        (depth & depthMask);
+}
+
+int RenderQueue::KeyMesh(uint64_t key) {
+    return static_cast<int>((key >> (TEXTURE_BITS + MATERIAL_BITS + DEPTH_BITS)) & ((1ull << MESH_BITS) - 1));
+}
+
+int RenderQueue::KeyTexture(uint64_t key) {
+    return static_cast<int>((key >> (MATERIAL_BITS + DEPTH_BITS)) & ((1ull << TEXTURE_BITS) - 1)) - 1;
+}
+
+int RenderQueue::KeyMaterial(uint64_t key) {
+    return static_cast<int>((key >> DEPTH_BITS) & ((1ull << MATERIAL_BITS) - 1)) - 1;
+}
+
+
+// --- Enhancement: Count how many state changes a given draw order needs ---
+uint32_t RenderQueue::CountStateChanges(const std::vector<RenderItem>& items) {
+    uint32_t changes = 0;
+    for (size_t i = 0; i < items.size(); ++i) {
+        if (i == 0) {
+            changes += 3;
+            continue;
+        }
+        uint64_t prev = items[i - 1].key;
+        uint64_t curr = items[i].key;
+        if (KeyMesh(prev) != KeyMesh(curr)) ++changes;
+        if (KeyTexture(prev) != KeyTexture(curr)) ++changes;
+        if (KeyMaterial(prev) != KeyMaterial(curr)) ++changes;
+    }
+    return changes;
+}
+
+
+void RenderQueue::Clear() {
+    m_items.clear();
+}
+
+void RenderQueue::Push(uint64_t key, uint32_t index) {
+    m_items.push_back({ key, index });
+}
+
+void RenderQueue::Append(const std::vector<RenderItem>& items) {
+    m_items.insert(m_items.end(), items.begin(), items.end());
+}
+
+void RenderQueue::Reserve(size_t count) {
+    m_items.reserve(count);
+}
+
+
+// --- Enhancement: LSD radix sort, 8 bits per pass ---
+// Passes where every key has the same digit are skipped, which is common
+// for the high mesh/texture bytes in small scenes.
+void RenderQueue::Sort() {
+    const size_t count = m_items.size();
+    if (count < 2) return;
+
+    m_scratch.resize(count);
+    RenderItem* src = m_items.data();
+    RenderItem* dst = m_scratch.data();
+
+    for (int shift = 0; shift < 64; shift += 8) {
+        size_t histogram[256] = { 0 };
+        for (size_t i = 0; i < count; ++i)
+            ++histogram[(src[i].key >> shift) & 0xFF];
+
+        // every key shares this digit, nothing to reorder
+        if (histogram[(src[0].key >> shift) & 0xFF] == count)
+            continue;
+
+        size_t offset = 0;
+        for (int b = 0; b < 256; ++b) {
+            size_t n = histogram[b];
+            histogram[b] = offset;
+            offset += n;
+        }
+        for (size_t i = 0; i < count; ++i)
+            dst[histogram[(src[i].key >> shift) & 0xFF]++] = src[i];
+
+        std::swap(src, dst);
+    }
+
+    // an odd number of real passes leaves the result in the scratch buffer
+    if (src != m_items.data())
+        m_items.swap(m_scratch);
+}
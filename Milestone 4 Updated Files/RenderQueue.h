@@ -0,0 +1,112 @@
+/***********************************************************
+ *
+ *  RenderQueue.h
+ *	============
+ *  sort visible objects by render state before drawing
+ *
+ ***********************************************************/
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+// --- Enhancement: One queued draw, identified by a packed sort key ---
+// The index refers back into the caller's list of visible objects
+// (SceneManager: its list of render commands).
+struct RenderItem {
+    uint64_t key;
+    uint32_t index;
+};
+
+
+// --- Enhancement: Per-frame counters for the state-sorted draw loop ---
+// "unsorted" and "sorted" count the mesh, texture and material changes
+// the queue needs before and after sorting, both with CountStateChanges;
+// the mesh/texture/material counters below are the changes the draw
+// loop actually issued.
+struct RenderStats {
+    uint32_t transformUpdates = 0;  // objects whose matrices were rebuilt
+    uint32_t drawCount = 0;
+    uint32_t drawCalls = 0;
+    uint32_t unsortedStateChanges = 0;
+    uint32_t sortedStateChanges = 0;
+    uint32_t meshChanges = 0;
+    uint32_t textureChanges = 0;
+    uint32_t layerChanges = 0;      // texture array layer selections
+    uint32_t materialChanges = 0;
+    double generateCpuMs = 0.0;     // CPU time spent culling and building commands
+    double submitCpuMs = 0.0;       // CPU time spent issuing the draws
+    uint32_t workerThreads = 0;     // threads that built the commands
+    uint32_t fenceWaits = 0;        // ring buffer fence waits this frame
+    uint32_t totalFenceWaits = 0;   // ... and since start-up
+    uint32_t stateCallsIssued = 0;  // uniform sets and binds sent to OpenGL
+    uint32_t stateCallsSkipped = 0; // ... and dropped because nothing changed
+    uint32_t staticBatches = 0;     // static batches drawn, one draw call each
+    uint32_t staticBatchRebuilds = 0;   // batches baked again this frame
+    double gpuMs = 0.0;             // GPU time of a recent frame (a few frames behind)
+    uint32_t smallObjectsCulled = 0;    // too small on screen to be drawn
+    uint32_t reducedLodDraws = 0;   // objects drawn with a coarser mesh
+    uint32_t prePassDraws = 0;      // occluder draws in the depth pre-pass
+    uint64_t prePassSamples = 0;    // samples written by the depth pre-pass
+    uint64_t shadedSamples = 0;     // samples that passed the depth test in the color pass
+    double overdraw = 0.0;          // shaded samples per pixel of the viewport
+    uint32_t lightVolumes = 0;      // deferred light volumes drawn
+    uint32_t shadowStaticRenders = 0;   // cached static shadow maps rendered again
+    uint32_t shadowCasters = 0;     // moving objects drawn into the shadow maps
+};
+
+
+// --- Enhancement: Render queue sorted with a 64-bit radix sort ---
+//
+// Key layout (most significant bits first):
+//   [63..60] bucket     (4 bits, coarse depth; 0 unless sorting front to back)
+//   [59..52] mesh       (8 bits)
+//   [51..36] texture    (16 bits, 0 = untextured)
+//   [35..20] material   (16 bits, 0 = no material)
+//   [19..0 ] depth      (20 bits, quantized distance from the camera)
+//
+// Sorting on this key groups draws that share a mesh, then texture, then
+// material, and orders each group front to back. With the depth bucket
+// filled in, the queue is ordered front to back first, in 16 slices, and
+// by state only within a slice, so near objects fill the depth buffer
+// before the ones behind them are shaded.
+class RenderQueue {
+public:
+    static const int BUCKET_BITS = 4;
+    static const int MESH_BITS = 8;
+    static const int TEXTURE_BITS = 16;
+    static const int MATERIAL_BITS = 16;
+    static const int DEPTH_BITS = 20;
+
+    // --- Enhancement: Pack the render state of one draw into a sort key ---
+    static uint64_t MakeKey(int mesh, int texture, int material, float depth01,
+                            bool frontToBack = false);
+
+    // --- Enhancement: Unpack the individual fields of a sort key ---
+    static int KeyMesh(uint64_t key);
+    static int KeyTexture(uint64_t key);
+    static int KeyMaterial(uint64_t key);
+
+    // --- Enhancement: Count mesh/texture/material changes in the current order ---
+    static uint32_t CountStateChanges(const std::vector<RenderItem>& items);
+
+    void Clear();
+    void Push(uint64_t key, uint32_t index);
+
+    // --- Enhancement: Append a list of items built by a worker thread ---
+    void Append(const std::vector<RenderItem>& items);
+    void Reserve(size_t count);
+
+    // --- Enhancement: LSD radix sort on the 64-bit keys (8 passes of 8 bits) ---
+    void Sort();
+
+    const std::vector<RenderItem>& Items() const { return m_items; }
+    size_t Size() const { return m_items.size(); }
+
+private:
+    std::vector<RenderItem> m_items;
+    // scratch buffer reused between frames to avoid reallocating
+    std::vector<RenderItem> m_scratch;
+};
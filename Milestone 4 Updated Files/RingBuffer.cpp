@@ -0,0 +1,141 @@
+/***********************************************************
+ *
+ *  RingBuffer.cpp
+ *	============
+ *  persistently mapped, fenced ring buffer for per-frame data
+ *
+ ***********************************************************/
+
+#include "RingBuffer.h"
+#include <chrono>
+#include <iostream>
+
+
+RingBuffer::RingBuffer()
+    : m_buffer(0), m_mapped(nullptr), m_sectionSize(0),
+      m_section(0), m_sectionUsed(0),
+      m_uniformAlignment(256), m_storageAlignment(256),
+      m_frameFenceWaits(0), m_totalFenceWaits(0), m_totalFenceWaitMs(0.0) {
+    for (int i = 0; i < FRAME_COUNT; ++i) m_fences[i] = 0;
+}
+
+RingBuffer::~RingBuffer() {
+    Destroy();
+}
+
+
+// --- Enhancement: One persistent, coherent mapping for all frames ---
+bool RingBuffer::Create(size_t sectionSize) {
+    Destroy();
+
+    // glBufferStorage is core in OpenGL 4.4, which start-up requires
+    GLint alignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    if (alignment > 0) m_uniformAlignment = alignment;
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    if (alignment > 0) m_storageAlignment = alignment;
+
+    // keep every section aligned for any kind of binding
+    size_t sectionAlignment = m_uniformAlignment > m_storageAlignment ? m_uniformAlignment : m_storageAlignment;
+    m_sectionSize = (sectionSize + sectionAlignment - 1) / sectionAlignment * sectionAlignment;
+
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glGenBuffers(1, &m_buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, m_buffer);
+    glBufferStorage(GL_COPY_WRITE_BUFFER, m_sectionSize * FRAME_COUNT, NULL, flags);
+    m_mapped = static_cast<unsigned char*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, m_sectionSize * FRAME_COUNT, flags));
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    if (!m_mapped) {
+        std::cout << "Could not map the ring buffer" << std::endl;
+        Destroy();
+        return false;
+    }
+
+    m_section = 0;
+    m_sectionUsed = 0;
+    return true;
+}
+
+
+void RingBuffer::Destroy() {
+    for (int i = 0; i < FRAME_COUNT; ++i) {
+        if (m_fences[i]) glDeleteSync(m_fences[i]);
+        m_fences[i] = 0;
+    }
+    if (m_buffer) {
+        if (m_mapped) {
+            glBindBuffer(GL_COPY_WRITE_BUFFER, m_buffer);
+            glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        }
+        glDeleteBuffers(1, &m_buffer);
+    }
+    m_buffer = 0;
+    m_mapped = nullptr;
+    m_sectionSize = 0;
+}
+
+
+void RingBuffer::WaitForSection(int section) {
+    GLsync fence = m_fences[section];
+    if (!fence) return;
+
+    // the usual case: the GPU finished with this section frames ago
+    GLenum result = glClientWaitSync(fence, 0, 0);
+    if (result == GL_TIMEOUT_EXPIRED) {
+        auto start = std::chrono::steady_clock::now();
+        do {
+            result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // 1 ms
+        } while (result == GL_TIMEOUT_EXPIRED);
+        m_frameFenceWaits++;
+        m_totalFenceWaits++;
+        m_totalFenceWaitMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    glDeleteSync(fence);
+    m_fences[section] = 0;
+}
+
+
+// --- Enhancement: Start writing the next frame's section ---
+bool RingBuffer::BeginFrame(size_t requiredBytes) {
+    m_frameFenceWaits = 0;
+    if (!IsValid()) return false;
+
+    // a frame that no longer fits: wait for every section, then re-create
+    // the buffer with room to spare so this does not happen every frame
+    if (requiredBytes > m_sectionSize) {
+        for (int i = 0; i < FRAME_COUNT; ++i) WaitForSection(i);
+        unsigned int frameWaits = m_frameFenceWaits;
+        // the old buffer is gone even if the new one fails
+        Create(requiredBytes * 2);
+        m_frameFenceWaits = frameWaits;
+        m_sectionUsed = 0;
+        return true;
+    }
+
+    m_section = (m_section + 1) % FRAME_COUNT;
+    WaitForSection(m_section);
+    m_sectionUsed = 0;
+    return false;
+}
+
+
+void* RingBuffer::Allocate(size_t size, size_t alignment, GLintptr& offset) {
+    if (!IsValid()) return nullptr;
+
+    size_t start = (m_sectionUsed + alignment - 1) / alignment * alignment;
+    if (start + size > m_sectionSize) return nullptr;
+
+    m_sectionUsed = start + size;
+    offset = static_cast<GLintptr>(m_section * m_sectionSize + start);
+    return m_mapped + offset;
+}
+
+
+void RingBuffer::EndFrame() {
+    if (!IsValid()) return;
+    if (m_fences[m_section]) glDeleteSync(m_fences[m_section]);
+    m_fences[m_section] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
@@ -0,0 +1,83 @@
+/***********************************************************
+ *
+ *  RingBuffer.h
+ *	============
+ *  persistently mapped, fenced ring buffer for per-frame data
+ *
+ ***********************************************************/
+
+#pragma once
+#include <cstddef>
+#include <GL/glew.h>
+
+
+/***********************************************************
+ *  RingBuffer
+ *
+ *  One buffer object, created with glBufferStorage and mapped
+ *  once for the lifetime of the buffer, split into
+ *  FRAME_COUNT sections. Each frame writes its dynamic data
+ *  (frame constants, instance data, indirect commands) straight
+ *  into the mapped memory of the next section and fences it
+ *  when the frame is submitted. A section is only reused once
+ *  its fence has signaled; with three sections the GPU is
+ *  normally done long before that, and every time the CPU
+ *  did have to wait is counted.
+ ***********************************************************/
+class RingBuffer {
+public:
+    static const int FRAME_COUNT = 3;
+
+    RingBuffer();
+    ~RingBuffer();
+
+    // Creates and maps the buffer (OpenGL 4.4); false if it cannot be mapped
+    bool Create(size_t sectionSize);
+
+    // Unmaps and deletes the buffer and its fences
+    void Destroy();
+
+    bool IsValid() const { return m_mapped != nullptr; }
+    GLuint Buffer() const { return m_buffer; }
+
+    // Moves to the next section, growing the buffer if a frame needs more
+    // than `requiredBytes`, and waits on the section's fence if it is still in use.
+    // True if the buffer was re-created: the new one may reuse the old name,
+    // so bindings cached by name are stale.
+    bool BeginFrame(size_t requiredBytes);
+
+    // Reserves `size` bytes of the current section. Returns the mapped
+    // address, and the buffer offset in `offset`, or nullptr when full.
+    void* Allocate(size_t size, size_t alignment, GLintptr& offset);
+
+    // Fences the current section once all of its draws are submitted
+    void EndFrame();
+
+    // Offset alignments required by glBindBufferRange
+    size_t UniformAlignment() const { return m_uniformAlignment; }
+    size_t StorageAlignment() const { return m_storageAlignment; }
+
+    // Fence waits, in the last frame and since creation
+    unsigned int FrameFenceWaits() const { return m_frameFenceWaits; }
+    unsigned int TotalFenceWaits() const { return m_totalFenceWaits; }
+    double TotalFenceWaitMs() const { return m_totalFenceWaitMs; }
+
+private:
+    // Blocks until the given section's fence has signaled, counting the wait
+    void WaitForSection(int section);
+
+    GLuint m_buffer;
+    unsigned char* m_mapped;
+    size_t m_sectionSize;
+    GLsync m_fences[FRAME_COUNT];
+
+    int m_section;          // section written by the current frame
+    size_t m_sectionUsed;   // bytes allocated in it so far
+
+    size_t m_uniformAlignment;
+    size_t m_storageAlignment;
+
+    unsigned int m_frameFenceWaits;
+    unsigned int m_totalFenceWaits;
+    double m_totalFenceWaitMs;
+};
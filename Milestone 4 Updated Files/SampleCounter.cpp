@@ -0,0 +1,69 @@
+/***********************************************************
+ *
+ *  SampleCounter.cpp
+ *	============
+ *  samples that pass the depth test, read back without stalling
+ *
+ ***********************************************************/
+
+#include "SampleCounter.h"
+
+
+SampleCounter::SampleCounter() : m_created(false), m_write(0), m_pending(0), m_counting(false), m_lastCount(0) {
+}
+
+SampleCounter::~SampleCounter() {
+    Destroy();
+}
+
+
+void SampleCounter::Begin() {
+    if (!m_created) {
+        glGenQueries(LATENCY, m_queries);
+        m_created = true;
+    }
+
+    // every query is still in flight: skip this span instead of stalling
+    Poll();
+    m_counting = m_pending < LATENCY;
+    if (m_counting)
+        glBeginQuery(GL_SAMPLES_PASSED, m_queries[m_write]);
+}
+
+
+void SampleCounter::End() {
+    if (!m_counting) return;
+    m_counting = false;
+
+    glEndQuery(GL_SAMPLES_PASSED);
+    m_write = (m_write + 1) % LATENCY;
+    ++m_pending;
+}
+
+
+// --- Enhancement: Read the finished spans, oldest first ---
+bool SampleCounter::Poll() {
+    bool finished = false;
+    while (m_pending > 0) {
+        int read = (m_write - m_pending + LATENCY) % LATENCY;
+        GLint available = 0;
+        glGetQueryObjectiv(m_queries[read], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) break;
+
+        GLuint64 count = 0;
+        glGetQueryObjectui64v(m_queries[read], GL_QUERY_RESULT, &count);
+        m_lastCount = count;
+        --m_pending;
+        finished = true;
+    }
+    return finished;
+}
+
+
+void SampleCounter::Destroy() {
+    if (!m_created) return;
+    glDeleteQueries(LATENCY, m_queries);
+    m_created = false;
+    m_write = m_pending = 0;
+    m_counting = false;
+}
@@ -0,0 +1,52 @@
+/***********************************************************
+ *
+ *  SampleCounter.h
+ *	============
+ *  samples that pass the depth test, read back without stalling
+ *
+ ***********************************************************/
+
+#pragma once
+#include <GL/glew.h>
+#include <cstdint>
+
+
+/***********************************************************
+ *  SampleCounter
+ *
+ *  Brackets a span of GL commands with a GL_SAMPLES_PASSED
+ *  query, which counts every sample that passes the depth
+ *  test, i.e. every sample the fragment shader's result is
+ *  written for. Like GpuTimer, the queries of the last
+ *  LATENCY spans are kept in flight and a result is read
+ *  only once the GPU has written it, so LastCount() is the
+ *  count of a span from a few frames ago.
+ ***********************************************************/
+class SampleCounter {
+public:
+    static const int LATENCY = 4;
+
+    SampleCounter();
+    ~SampleCounter();
+
+    // Mark the start and end of the span to count
+    void Begin();
+    void End();
+
+    // Reads every finished span; true if at least one finished since the last call
+    bool Poll();
+
+    // Samples passed in the most recent finished span (0 = none yet)
+    uint64_t LastCount() const { return m_lastCount; }
+
+    // Deletes the queries
+    void Destroy();
+
+private:
+    GLuint m_queries[LATENCY];
+    bool m_created;
+    int m_write;                    // next span to record
+    int m_pending;                  // spans recorded but not read yet
+    bool m_counting;                // Begin() started a query this span
+    uint64_t m_lastCount;
+};
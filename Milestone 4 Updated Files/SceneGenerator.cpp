@@ -0,0 +1,134 @@
+/***********************************************************
+ *
+ *  SceneGenerator.cpp
+ *	============
+ *  seeded rooms of toys for scaling tests
+ *
+ ***********************************************************/
+
+#include "SceneGenerator.h"
+#include <cmath>
+#include <utility>
+
+namespace {
+    // toy spots per room, on a SPOT_GRID x SPOT_GRID grid around the center
+    const int SPOT_GRID = 4;
+    const float SPOT_SPACING = 2.5f;
+    const float SPOT_JITTER = 0.5f;
+
+    const float TWO_PI = 6.2831853f;
+
+    // --- Enhancement: splitmix64, the same numbers on every platform ---
+    class RoomRandom {
+    public:
+        RoomRandom(uint32_t seed, size_t room)
+            : m_state((static_cast<uint64_t>(seed) << 32) ^ static_cast<uint64_t>(room)) {}
+
+        uint64_t Next() {
+            uint64_t z = (m_state += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        }
+
+        // lo..hi inclusive
+        int Range(int lo, int hi) {
+            return lo + static_cast<int>(Next() % static_cast<uint64_t>(hi - lo + 1));
+        }
+
+        // lo..hi, from the top 24 bits so every float is exact
+        float Range(float lo, float hi) {
+            return lo + (hi - lo) * static_cast<float>(Next() >> 40) / 16777216.0f;
+        }
+
+    private:
+        uint64_t m_state;
+    };
+
+    int Add(std::vector<SceneObject>& objects, const glm::vec3& position, float radius,
+            const char* tag, bool isStatic, int parentIndex = -1) {
+        SceneObject object = { position, radius, tag };
+        object.parentIndex = parentIndex;
+        object.isStatic = isStatic;
+        objects.push_back(object);
+        return static_cast<int>(objects.size()) - 1;
+    }
+}
+
+
+const float SceneGenerator::ROOM_PITCH = 32.0f;
+
+
+void SceneGenerator::GenerateRooms(size_t rooms, uint32_t seed, std::vector<SceneObject>& objects) {
+    size_t width = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(rooms))));
+    objects.reserve(objects.size() + rooms * (MAX_ROOM_OBJECTS / 2));
+    for (size_t room = 0; room < rooms; ++room) {
+        glm::vec3 center(static_cast<float>(room % width) * ROOM_PITCH, 0.0f,
+                         static_cast<float>(room / width) * ROOM_PITCH);
+        GenerateRoom(room, seed, center, objects);
+    }
+}
+
+
+// --- Enhancement: One room, laid out like the shipped scene ---
+void SceneGenerator::GenerateRoom(size_t room, uint32_t seed, const glm::vec3& center,
+                                  std::vector<SceneObject>& objects) {
+    RoomRandom random(seed, room);
+
+    Add(objects, center + glm::vec3(0.0f, 7.5f, -10.0f), 8.0f, "backwall", true);
+    Add(objects, center, 8.0f, "floor", true);
+    // draws are sequenced one per statement: the order arguments are
+    // evaluated in differs between compilers
+    float carpetX = random.Range(-3.0f, 3.0f);
+    float carpetZ = random.Range(-3.0f, 3.0f);
+    glm::vec3 carpet(carpetX, 0.05f, carpetZ);
+    Add(objects, center + carpet, 3.0f, random.Range(0, 1) ? "carpetblue" : "carpetbeige", true);
+
+    // shuffled spots, so no two toys share one
+    int spots[SPOT_GRID * SPOT_GRID];
+    for (int i = 0; i < SPOT_GRID * SPOT_GRID; ++i) spots[i] = i;
+    for (int i = SPOT_GRID * SPOT_GRID - 1; i > 0; --i) std::swap(spots[i], spots[random.Range(0, i)]);
+    int nextSpot = 0;
+    auto spot = [&](float y) {
+        int cell = spots[nextSpot++];
+        float offset = (SPOT_GRID - 1) * 0.5f;
+        float x = ((cell % SPOT_GRID) - offset) * SPOT_SPACING + random.Range(-SPOT_JITTER, SPOT_JITTER);
+        float z = ((cell / SPOT_GRID) - offset) * SPOT_SPACING + random.Range(-SPOT_JITTER, SPOT_JITTER);
+        return center + glm::vec3(x, y, z);
+    };
+
+    // stacks of 1 to 3 blocks
+    static const char* const blocks[] = { "yellowblock", "redblock", "greenblock" };
+    for (int stack = random.Range(1, 3); stack > 0; --stack) {
+        glm::vec3 base = spot(0.5f);
+        int height = random.Range(1, 3);
+        for (int level = 0; level < height; ++level)
+            Add(objects, base + glm::vec3(0.0f, static_cast<float>(level), 0.0f), 0.7f, blocks[random.Range(0, 2)], true);
+    }
+
+    // party hats, each with a pom-pom and 16 brim spheres
+    for (int hat = random.Range(0, 2); hat > 0; --hat) {
+        int hatIndex = Add(objects, spot(0.0f), 2.0f, "partyhat", true);
+        Add(objects, glm::vec3(0.0f, 2.0f, 0.0f), 0.3f, "hatpompom", true, hatIndex);
+        for (int i = 0; i < 16; i++) {
+            float angle = (float)i * (TWO_PI / 16.0f);
+            Add(objects, glm::vec3(std::cos(angle), 0.0f, std::sin(angle)), 0.2f, "hatbrimsphere", true, hatIndex);
+        }
+    }
+
+    // cars of either model, each with a roof and four wheels
+    for (int car = random.Range(1, 3); car > 0; --car) {
+        bool second = random.Range(0, 1) != 0;
+        float axle = second ? 0.45f : 0.4f;
+        int carIndex = Add(objects, spot(0.25f), 0.6f, second ? "car2body" : "car1body", false);
+        Add(objects, glm::vec3(-0.15f, 0.2f, 0.0f), 0.3f, second ? "car2roof" : "car1roof", false, carIndex);
+        for (int i = 0; i < 4; i++) {
+            float xOffset = (i % 2 * axle) - axle * 0.5f;
+            float zOffset = (i < 2 ? 0.12f : -0.12f);
+            Add(objects, glm::vec3(xOffset, -0.075f, zOffset), 0.15f, second ? "car2wheel" : "car1wheel", false, carIndex);
+        }
+    }
+
+    for (int ball = random.Range(1, 3); ball > 0; --ball)
+        Add(objects, spot(0.2f), 0.35f, "kickball", false);
+}
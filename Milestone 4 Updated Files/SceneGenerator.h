@@ -0,0 +1,51 @@
+/***********************************************************
+ *
+ *  SceneGenerator.h
+ *	============
+ *  seeded rooms of toys for scaling tests
+ *
+ ***********************************************************/
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Octree.h"
+
+
+/***********************************************************
+ *  SceneGenerator
+ *
+ *  The shipped scene is one room of about 40 objects. The
+ *  generator writes any number of rooms like it, in the
+ *  saved object form, so a scene of millions of objects goes
+ *  through the same build as a loaded one.
+ *
+ *  Rooms sit on a square grid ROOM_PITCH apart, room 0 at
+ *  the origin where the default camera looks. Each has a
+ *  back wall, a floor and a carpet, and a jittered 4x4 grid
+ *  of spots for its toys: block stacks, party hats with
+ *  their pom-pom and brim, cars with a roof and four wheels,
+ *  and kickballs. The room, the carpet, the blocks and the
+ *  hats are static, as in the shipped scene.
+ *
+ *  A room's contents come from its own random stream,
+ *  seeded from the seed and its index with a fixed integer
+ *  hash rather than the standard library's distributions,
+ *  so a seed gives the same rooms on every compiler, and
+ *  room k is the same whatever the room count. Only the grid
+ *  width (and so where a room sits) depends on the count.
+ ***********************************************************/
+class SceneGenerator {
+public:
+    static const float ROOM_PITCH;      // distance between room centers
+    static const size_t MAX_ROOM_OBJECTS = 70;
+
+    // Appends the objects of `rooms` rooms to `objects`; parent indices
+    // are relative to the whole list
+    static void GenerateRooms(size_t rooms, uint32_t seed, std::vector<SceneObject>& objects);
+
+private:
+    static void GenerateRoom(size_t room, uint32_t seed, const glm::vec3& center,
+                             std::vector<SceneObject>& objects);
+};
@@ -0,0 +1,129 @@
+/***********************************************************
+ *
+ *  SceneGraph.cpp
+ *	============
+ *  parent/child hierarchy of scene objects
+ *
+ ***********************************************************/
+
+#include "SceneGraph.h"
+#include <algorithm>
+
+
+// --- Enhancement: Depth-first order of the hierarchy ---
+bool SceneGraph::Build(const std::vector<int>& parents) {
+    const size_t count = parents.size();
+    bool valid = true;
+
+    m_parents.assign(parents.begin(), parents.end());
+    for (size_t i = 0; i < count; ++i) {
+        if (m_parents[i] < 0) continue;
+        if (static_cast<size_t>(m_parents[i]) >= count || m_parents[i] == static_cast<int>(i)) {
+            m_parents[i] = -1;
+            valid = false;
+        }
+    }
+
+    // children of every node as one flat list (counting sort by parent)
+    std::vector<uint32_t> firstChild(count + 1, 0);
+    for (size_t i = 0; i < count; ++i)
+        if (m_parents[i] >= 0) ++firstChild[m_parents[i] + 1];
+    for (size_t i = 0; i < count; ++i)
+        firstChild[i + 1] += firstChild[i];
+    std::vector<uint32_t> children(firstChild[count]);
+    std::vector<uint32_t> fill(firstChild.begin(), firstChild.end() - 1);
+    for (size_t i = 0; i < count; ++i)
+        if (m_parents[i] >= 0) children[fill[m_parents[i]]++] = static_cast<uint32_t>(i);
+
+    m_order.clear();
+    m_order.reserve(count);
+    m_orderPosition.assign(count, UINT32_MAX);
+    std::vector<uint32_t> stack;
+
+    auto visit = [&](uint32_t root) {
+        stack.push_back(root);
+        while (!stack.empty()) {
+            uint32_t node = stack.back();
+            stack.pop_back();
+            // the link that closed a cycle still lists the cut node as a child
+            if (m_orderPosition[node] != UINT32_MAX) continue;
+            m_orderPosition[node] = static_cast<uint32_t>(m_order.size());
+            m_order.push_back(node);
+            // pushed in reverse so children keep their original order
+            for (uint32_t c = firstChild[node + 1]; c > firstChild[node]; --c)
+                stack.push_back(children[c - 1]);
+        }
+    };
+
+    for (size_t i = 0; i < count; ++i)
+        if (m_parents[i] < 0) visit(static_cast<uint32_t>(i));
+
+    // anything not reached from a root is part of a cycle: cut the
+    // cycle at the first such node and walk it from there
+    for (size_t i = 0; i < count; ++i) {
+        if (m_orderPosition[i] != UINT32_MAX) continue;
+        m_parents[i] = -1;
+        valid = false;
+        visit(static_cast<uint32_t>(i));
+    }
+
+    // subtree sizes, accumulated children-first
+    m_subtreeSize.assign(count, 1);
+    for (size_t p = count; p-- > 0;) {
+        uint32_t node = m_order[p];
+        if (m_parents[node] >= 0) m_subtreeSize[m_parents[node]] += m_subtreeSize[node];
+    }
+
+    // nodes marked before the rebuild stay marked
+    m_dirty.resize(count, 0);
+    size_t kept = 0;
+    for (uint32_t node : m_dirtyNodes)
+        if (node < count) m_dirtyNodes[kept++] = node;
+    m_dirtyNodes.resize(kept);
+    return valid;
+}
+
+
+bool SceneGraph::IsAncestor(uint32_t ancestor, uint32_t node) const {
+    uint32_t position = m_orderPosition[node];
+    uint32_t begin = m_orderPosition[ancestor];
+    return position >= begin && position < begin + m_subtreeSize[ancestor];
+}
+
+
+void SceneGraph::MarkDirty(uint32_t node) {
+    // a node added since the last Build() is kept marked until the next one
+    if (node >= m_dirty.size()) m_dirty.resize(node + 1, 0);
+    if (m_dirty[node]) return;
+    m_dirty[node] = 1;
+    m_dirtyNodes.push_back(node);
+}
+
+void SceneGraph::MarkAllDirty() {
+    for (size_t i = 0; i < m_parents.size(); ++i)
+        if (m_parents[i] < 0) MarkDirty(static_cast<uint32_t>(i));
+}
+
+
+// --- Enhancement: Merge the dirty subtrees into ranges of the order ---
+// Two subtrees are either nested or disjoint, so after sorting by start
+// a range is skipped if it lies inside the previous one.
+size_t SceneGraph::CollectDirtyRanges(std::vector<Range>& ranges) {
+    ranges.clear();
+    for (uint32_t node : m_dirtyNodes) {
+        m_dirty[node] = 0;
+        ranges.push_back({ m_orderPosition[node], m_orderPosition[node] + m_subtreeSize[node] });
+    }
+    m_dirtyNodes.clear();
+
+    std::sort(ranges.begin(), ranges.end());
+    size_t kept = 0;
+    size_t covered = 0;
+    for (size_t i = 0; i < ranges.size(); ++i) {
+        if (kept > 0 && ranges[i].first < ranges[kept - 1].second) continue;
+        ranges[kept++] = ranges[i];
+        covered += ranges[i].second - ranges[i].first;
+    }
+    ranges.resize(kept);
+    return covered;
+}
@@ -0,0 +1,72 @@
+/***********************************************************
+ *
+ *  SceneGraph.h
+ *	============
+ *  parent/child hierarchy of scene objects
+ *
+ ***********************************************************/
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+
+/***********************************************************
+ *  SceneGraph
+ *
+ *  Keeps the nodes of a hierarchy in depth-first order:
+ *  every parent comes before its children and the subtree of
+ *  a node is the contiguous run of Order() that starts at the
+ *  node. Updating world transforms is then one forward pass
+ *  over that array, and a dirty node only costs its own
+ *  subtree. The graph only knows the shape of the hierarchy;
+ *  the transforms themselves live with the caller, indexed
+ *  by node.
+ ***********************************************************/
+class SceneGraph {
+public:
+    // [begin, end) positions in Order()
+    typedef std::pair<uint32_t, uint32_t> Range;
+
+    // Rebuilds the order from each node's parent index (-1 = root).
+    // A parent that is out of range, or that would close a cycle, is
+    // dropped and the node becomes a root; returns false if that happened.
+    // Dirty flags of existing nodes are kept.
+    bool Build(const std::vector<int>& parents);
+
+    size_t NodeCount() const { return m_parents.size(); }
+
+    // Parent of a node after Build(), or -1 for a root
+    int Parent(uint32_t node) const { return m_parents[node]; }
+
+    // Nodes, parents first, each subtree contiguous
+    const std::vector<uint32_t>& Order() const { return m_order; }
+
+    // Position of a node in Order(), and the size of its subtree
+    uint32_t OrderPosition(uint32_t node) const { return m_orderPosition[node]; }
+    uint32_t SubtreeSize(uint32_t node) const { return m_subtreeSize[node]; }
+
+    // True if `ancestor` is `node` or one of its parents
+    bool IsAncestor(uint32_t ancestor, uint32_t node) const;
+
+    // Flags a node whose local transform changed; its whole subtree is
+    // returned by the next CollectDirtyRanges(). A node that is not in
+    // the graph yet may be flagged; Build() must run before collecting.
+    void MarkDirty(uint32_t node);
+    void MarkAllDirty();
+
+    // Turns the flagged nodes into sorted, non-overlapping ranges of
+    // Order() and clears the flags. Returns the number of nodes covered.
+    size_t CollectDirtyRanges(std::vector<Range>& ranges);
+
+private:
+    std::vector<int> m_parents;
+    std::vector<uint32_t> m_order;
+    std::vector<uint32_t> m_orderPosition;
+    std::vector<uint32_t> m_subtreeSize;
+
+    std::vector<uint8_t> m_dirty;
+    std::vector<uint32_t> m_dirtyNodes;
+};
@@ -0,0 +1,231 @@
+/***********************************************************
+ *
+ *  SceneLoader.cpp
+ *	============
+ *  builds a loaded scene on a background thread
+ *
+ ***********************************************************/
+
+#include "SceneLoader.h"
+#include <algorithm>
+#include <iostream>
+#include <utility>
+
+namespace {
+    // share of the progress bar taken by reading and parsing the file
+    const float PARSE_SHARE = 0.5f;
+
+    // objects between two progress updates
+    const size_t PROGRESS_STEP = 256;
+
+    void SetProgress(std::atomic<float>* progress, float start, float share, size_t done, size_t total) {
+        if (progress && total > 0)
+            progress->store(start + share * static_cast<float>(done) / static_cast<float>(total));
+    }
+}
+
+
+SceneLoader::SceneLoader()
+    : m_state(LOAD_IDLE), m_progress(0.0f) {
+    m_octreeBounds.min = m_octreeBounds.max = glm::vec3(0.0f);
+}
+
+SceneLoader::~SceneLoader() {
+    Join();
+}
+
+
+bool SceneLoader::Start(const std::string& filename, const std::vector<uint32_t>& generations,
+                        const std::vector<SceneDescriptor>& descriptors, const BakeShapes& shapes,
+                        const AABB& octreeBounds) {
+    if (GetState() != LOAD_IDLE) return false;
+    Join();
+
+    m_filename = filename;
+    m_generations = generations;
+    m_descriptors = descriptors;
+    m_shapes = shapes;
+    m_octreeBounds = octreeBounds;
+    m_progress = 0.0f;
+    m_state = LOAD_RUNNING;
+    m_thread = std::thread(&SceneLoader::Run, this);
+    return true;
+}
+
+
+bool SceneLoader::Take(LoadedScene& scene) {
+    State state = GetState();
+    if (state != LOAD_READY && state != LOAD_FAILED) return false;
+    Join();
+
+    bool ready = state == LOAD_READY;
+    if (ready) {
+        std::swap(scene.entities, m_result.entities);
+        std::swap(scene.sceneGraph, m_result.sceneGraph);
+        std::swap(scene.octree, m_result.octree);
+        scene.worldMatrices.swap(m_result.worldMatrices);
+        scene.normalMatrices.swap(m_result.normalMatrices);
+        scene.nodeMatrices.swap(m_result.nodeMatrices);
+        scene.inOctree.swap(m_result.inOctree);
+        scene.staticBatches.Swap(m_result.staticBatches);
+        scene.camera = m_result.camera;
+        scene.hasCamera = m_result.hasCamera;
+    }
+    // whatever `scene` held before is dropped with the result
+    m_result.entities = EntityStore();
+    m_result.sceneGraph = SceneGraph();
+    delete m_result.octree;
+    m_result.octree = nullptr;
+    std::vector<glm::mat4>().swap(m_result.worldMatrices);
+    std::vector<glm::mat3>().swap(m_result.normalMatrices);
+    std::vector<glm::mat4>().swap(m_result.nodeMatrices);
+    std::vector<uint8_t>().swap(m_result.inOctree);
+    m_result.staticBatches.Destroy();
+    m_state = LOAD_IDLE;
+    return ready;
+}
+
+
+// --- Enhancement: Background thread: parse, then build the whole scene ---
+void SceneLoader::Run() {
+    std::vector<SceneObject> objects;
+    CameraState camera = {};
+    if (!JsonDatabase::LoadSceneAndCamera(objects, camera, m_filename)) {
+        m_state = LOAD_FAILED;
+        return;
+    }
+    m_progress = PARSE_SHARE;
+
+    m_result.entities.Clear(m_generations);
+    BuildScene(objects, m_descriptors, m_shapes, m_octreeBounds, m_result, &m_progress, PARSE_SHARE);
+    m_result.camera = camera;
+    m_result.hasCamera = true;
+    m_progress = 1.0f;
+    // publishes m_result to the thread that sees LOAD_READY
+    m_state = LOAD_READY;
+}
+
+
+void SceneLoader::BuildScene(const std::vector<SceneObject>& objects,
+                             const std::vector<SceneDescriptor>& descriptors, const BakeShapes& shapes,
+                             const AABB& octreeBounds, LoadedScene& scene,
+                             std::atomic<float>* progress, float progressStart) {
+    // creating the entities, linking them and computing their matrices,
+    // indexing them, and baking the static ones
+    const float share = 1.0f - progressStart;
+    const float createShare = share * 0.3f;
+    const float linkShare = share * 0.2f;
+    const float indexShare = share * 0.3f;
+    const float bakeShare = share * 0.2f;
+    const size_t count = objects.size();
+
+    // Clear() hands the slots out from 0 again, so object i is in slot i
+    EntityStore& entities = scene.entities;
+    entities.Clear();
+
+    // saved IDs are kept; objects without one, and the second of two with
+    // the same one, get new IDs above every saved one
+    uint32_t highestId = 0;
+    for (const SceneObject& object : objects)
+        highestId = std::max(highestId, object.id);
+    entities.ReserveObjectIds(highestId);
+
+    for (size_t i = 0; i < count; ++i) {
+        const SceneObject& object = objects[i];
+        EntityHandle entity = entities.Create(object.position, object.boundingRadius, object.tag);
+        entities.localRotation[entity.index] = object.rotation;
+        entities.localScale[entity.index] = object.scale;
+        entities.isStatic[entity.index] = object.isStatic ? 1 : 0;
+        if (object.id != 0)
+            entities.AssignObjectId(entity.index, object.id);
+        if (i % PROGRESS_STEP == 0) SetProgress(progress, progressStart, createShare, i, count);
+    }
+
+    std::vector<int> parents(entities.Capacity(), -1);
+    for (size_t i = 0; i < count; ++i) {
+        int parentIndex = objects[i].parentIndex;
+        if (parentIndex >= 0 && parentIndex < static_cast<int>(count))
+            parents[i] = parentIndex;
+    }
+    if (!scene.sceneGraph.Build(parents))
+        std::cout << "Scene graph: ignored invalid or cyclic parent links" << std::endl;
+    for (uint32_t slot = 0; slot < count; ++slot) {
+        int parent = scene.sceneGraph.Parent(slot);
+        entities.parent[slot] = parent >= 0 ? entities.HandleAt(parent) : EntityHandle();
+    }
+
+    // one lookup per distinct tag, not per object
+    std::vector<int> tagDescriptors(entities.TagCount(), -1);
+    for (uint32_t id = 0; id < tagDescriptors.size(); ++id) {
+        for (size_t i = 0; i < descriptors.size(); ++i) {
+            if (descriptors[i].tag == entities.TagName(id)) {
+                tagDescriptors[id] = static_cast<int>(i);
+                break;
+            }
+        }
+    }
+    for (uint32_t slot = 0; slot < count; ++slot)
+        entities.descriptorIndex[slot] = tagDescriptors[entities.tagId[slot]];
+
+    // the same matrices SceneManager's transform pass computes: a node
+    // carries its position, rotation and scale down to its children, the
+    // descriptor shapes the object's own mesh; parents come first in the
+    // graph's order
+    const size_t capacity = entities.Capacity();
+    scene.nodeMatrices.assign(capacity, glm::mat4(1.0f));
+    scene.worldMatrices.assign(capacity, glm::mat4(1.0f));
+    scene.normalMatrices.assign(capacity, glm::mat3(1.0f));
+    for (uint32_t slot : scene.sceneGraph.Order()) {
+        if (slot >= count) continue;
+        glm::mat4 local = entities.LocalMatrix(slot);
+        int parent = scene.sceneGraph.Parent(slot);
+        scene.nodeMatrices[slot] = parent >= 0 ? scene.nodeMatrices[parent] * local : local;
+        entities.worldPosition[slot] = glm::vec3(scene.nodeMatrices[slot][3]);
+
+        int descriptor = entities.descriptorIndex[slot];
+        if (descriptor >= 0) {
+            scene.worldMatrices[slot] = scene.nodeMatrices[slot] * descriptors[descriptor].shape;
+            scene.normalMatrices[slot] = glm::transpose(glm::inverse(glm::mat3(scene.worldMatrices[slot])));
+        }
+    }
+    SetProgress(progress, progressStart + createShare, linkShare, 1, 1);
+
+    // the bounds given are a minimum: objects outside the root would all
+    // stay in it, so a larger scene (a generated one) grows the root
+    AABB bounds = octreeBounds;
+    for (uint32_t slot = 0; slot < count; ++slot) {
+        bounds.min = glm::min(bounds.min, entities.worldPosition[slot]);
+        bounds.max = glm::max(bounds.max, entities.worldPosition[slot]);
+    }
+    delete scene.octree;
+    scene.octree = new OctreeNode(bounds);
+    scene.inOctree.assign(capacity, 0);
+    for (uint32_t slot = 0; slot < count; ++slot) {
+        scene.octree->insert(entities.HandleAt(slot), entities.worldPosition[slot]);
+        scene.inOctree[slot] = 1;
+        if (slot % PROGRESS_STEP == 0)
+            SetProgress(progress, progressStart + createShare + linkShare, indexShare, slot, count);
+    }
+
+    std::vector<StaticBatchMember> members;
+    for (uint32_t slot = 0; slot < count; ++slot) {
+        int descriptor = entities.descriptorIndex[slot];
+        if (!entities.isStatic[slot] || descriptor < 0) continue;
+        const SceneDescriptor& desc = descriptors[descriptor];
+        StaticBatchMember member;
+        member.slot = slot;
+        member.mesh = desc.mesh;
+        member.uvScale = desc.uvScale;
+        member.position = entities.worldPosition[slot];
+        member.key = desc.batchKey;
+        members.push_back(member);
+    }
+    scene.staticBatches.Assign(members, shapes);
+    scene.staticBatches.Bake(shapes, scene.worldMatrices, scene.normalMatrices);
+    SetProgress(progress, progressStart + createShare + linkShare + indexShare, bakeShare, 1, 1);
+}
+
+
+void SceneLoader::Join() {
+    if (m_thread.joinable()) m_thread.join();
+}
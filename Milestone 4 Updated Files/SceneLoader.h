@@ -0,0 +1,131 @@
+/***********************************************************
+ *
+ *  SceneLoader.h
+ *	============
+ *  builds a loaded scene on a background thread
+ *
+ ***********************************************************/
+
+#pragma once
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "EntityStore.h"
+#include "JsonDatabase.h"
+#include "Octree.h"
+#include "SceneGraph.h"
+#include "StaticBatcher.h"
+
+
+// --- Enhancement: What building a scene needs of one render descriptor ---
+// Copied out of SceneManager's table (after its textures and materials
+// are resolved), so the build never reads the table itself.
+struct SceneDescriptor {
+    std::string tag;
+    glm::mat4 shape;            // scale and rotation of the object's own mesh
+    MeshType mesh;
+    glm::vec2 uvScale;
+    StaticBatchKey batchKey;
+};
+
+
+// --- Enhancement: A complete scene, ready to be swapped in ---
+// Entities with their world positions and descriptor indices resolved,
+// the scene graph built from their parent links, an octree holding
+// every entity, the matrix cache filled for every slot and the static
+// batches baked but not uploaded. Owns the octree until it is taken.
+struct LoadedScene {
+    EntityStore entities;
+    SceneGraph sceneGraph;
+    OctreeNode* octree = nullptr;
+    std::vector<glm::mat4> worldMatrices;
+    std::vector<glm::mat3> normalMatrices;
+    std::vector<glm::mat4> nodeMatrices;
+    std::vector<uint8_t> inOctree;      // per slot: has an octree entry
+    StaticBatcher staticBatches;
+    CameraState camera = {};
+    bool hasCamera = false;
+
+    LoadedScene() {}
+    ~LoadedScene() { delete octree; }
+    LoadedScene(const LoadedScene&) = delete;
+    LoadedScene& operator=(const LoadedScene&) = delete;
+};
+
+
+/***********************************************************
+ *  SceneLoader
+ *
+ *  Reads a saved scene and builds everything SceneManager
+ *  needs from it on a thread of its own, so the frames keep
+ *  coming while the file is parsed and indexed. The thread
+ *  only touches the file and the LoadedScene it fills; the
+ *  slot generations, descriptors, shapes and octree bounds
+ *  are copied in when the load starts. Take() hands the
+ *  result to the render thread, which swaps it in between
+ *  two frames with no per-object work left to do.
+ *
+ *  BuildScene() is the same work without the thread, for
+ *  loads that block on purpose (start-up, headless runs).
+ ***********************************************************/
+class SceneLoader {
+public:
+    enum State {
+        LOAD_IDLE,          // nothing started, or the last result was taken
+        LOAD_RUNNING,
+        LOAD_READY,         // Take() returns the scene
+        LOAD_FAILED         // the file could not be read
+    };
+
+    SceneLoader();
+    ~SceneLoader();
+
+    // Starts loading `filename` (scene and camera). `generations` are
+    // those of the store being replaced; they carry over, so its handles
+    // stay stale. `descriptors` mirror SceneManager's descriptor table, in
+    // order. False if a load is still running or its result was not
+    // taken yet.
+    bool Start(const std::string& filename, const std::vector<uint32_t>& generations,
+               const std::vector<SceneDescriptor>& descriptors, const BakeShapes& shapes,
+               const AABB& octreeBounds);
+
+    State GetState() const { return static_cast<State>(m_state.load()); }
+    bool IsBusy() const { return GetState() == LOAD_RUNNING; }
+    const std::string& Filename() const { return m_filename; }
+
+    // Fraction of the running load done, 0 to 1
+    float Progress() const { return m_progress.load(); }
+
+    // Moves the finished scene into `scene` and returns to idle. False
+    // (and `scene` untouched) unless the state is LOAD_READY; a failed
+    // load is acknowledged, and returns to idle, the same way.
+    bool Take(LoadedScene& scene);
+
+    // Resolves, indexes and links `objects` into `scene`, replacing the
+    // entities it holds, and fills its matrices and static batches. The
+    // octree covers `octreeBounds` and every object. `progress`, if given,
+    // goes from `progressStart` to 1.
+    static void BuildScene(const std::vector<SceneObject>& objects,
+                           const std::vector<SceneDescriptor>& descriptors, const BakeShapes& shapes,
+                           const AABB& octreeBounds, LoadedScene& scene,
+                           std::atomic<float>* progress = nullptr, float progressStart = 0.0f);
+
+private:
+    void Run();
+    void Join();
+
+    std::thread m_thread;
+    std::atomic<int> m_state;
+    std::atomic<float> m_progress;
+
+    // set before the thread starts, read only by it afterwards
+    std::string m_filename;
+    std::vector<uint32_t> m_generations;
+    std::vector<SceneDescriptor> m_descriptors;
+    BakeShapes m_shapes;
+    AABB m_octreeBounds;
+
+    // written by the thread, read after LOAD_READY is seen
+    LoadedScene m_result;
+};
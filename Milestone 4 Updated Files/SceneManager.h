@@ -23,6 +23,74 @@
 // saving/loading the scene and camera state as JSON.
 #include "../JsonDatabase.h"
 
+// Enhancement: RenderQueue is included to sort visible objects by
+// mesh, texture and material before they are drawn.
+#include "../RenderQueue.h"
+
+// Enhancement: MeshLibrary is included to draw repeated objects
+// with one instanced draw call per mesh/texture/material group.
+#include "../MeshLibrary.h"
+
+// Enhancement: UniformCache is included so uniforms are set by
+// pre-resolved location instead of by name on every draw.
+#include "../UniformCache.h"
+
+// Enhancement: BindingCache is included so that binds which would not
+// change the current vertex array or buffer bindings are dropped.
+#include "../BindingCache.h"
+
+// Enhancement: LightManager is included to keep the scene lights in a
+// uniform buffer that is only updated where lights changed.
+#include "../LightManager.h"
+
+// Enhancement: RingBuffer is included to write per-frame data straight
+// into persistently mapped memory instead of through uniform calls.
+#include "../RingBuffer.h"
+
+// Enhancement: WorkerPool is included to cull and build the render
+// commands on several threads; only GL submission stays on this one.
+#include "../WorkerPool.h"
+
+// Enhancement: SceneGraph is included so objects can be grouped into
+// assemblies whose parts are positioned relative to a parent.
+#include "../SceneGraph.h"
+
+// Enhancement: StaticBatcher is included so objects that never move are
+// merged into shared buffers and drawn with one call per draw state.
+#include "../StaticBatcher.h"
+
+// Enhancement: GpuTimer and FrameBudget are included to measure the GPU
+// time of each frame and trade view range and detail for frame time.
+#include "../GpuTimer.h"
+#include "../FrameBudget.h"
+
+// Enhancement: SampleCounter is included to measure how many fragments
+// the depth pre-pass and the color pass write (overdraw).
+#include "../SampleCounter.h"
+
+// Enhancement: CommandCapture is included to record the draw command
+// stream of a few frames for replay without the rest of the application.
+#include "../CommandCapture.h"
+
+// Enhancement: DeferredRenderer is included to light scenes with many
+// small lights per pixel from a G-buffer instead of per fragment.
+#include "../DeferredRenderer.h"
+
+// Enhancement: ShadowMapper is included to shadow the first two lights
+// from depth maps whose static part is rendered once and cached.
+#include "../ShadowMapper.h"
+
+// Enhancement: SceneLoader is included to read and index a saved scene
+// on a background thread while the current one keeps rendering.
+#include "../SceneLoader.h"
+
+// Enhancement: SceneSaver is included to serialize and write saves on a
+// background thread from a snapshot taken between frames.
+#include "../SceneSaver.h"
+
+// Enhancement: SceneWatcher is included to pick up edits of the scene
+// file and apply them to the live scene without a full reload.
+#include "../SceneWatcher.h"
 
 
 /***********************************************************
@@ -42,24 +110,191 @@ public:
 	// destructor
 	~SceneManager();
 
+	// Enhancement: how RenderScene submits the sorted render queue
+	enum DrawMode
+	{
+		DRAW_PER_OBJECT = 0,	// one ShapeMeshes draw per object
+		DRAW_INSTANCED,			// one instanced draw per mesh/texture group
+		DRAW_INDIRECT,			// one multi-draw-indirect call per texture slot
+		DRAW_MODE_COUNT
+	};
+
+	// Enhancement: how RenderScene orders the opaque geometry
+	enum OpaqueOrder
+	{
+		OPAQUE_STATE_SORTED = 0,	// grouped by state, front to back within a group
+		OPAQUE_FRONT_TO_BACK,		// front to back in coarse depth slices, then by state
+		OPAQUE_DEPTH_PREPASS,		// front to back, after a depth-only pass of the large occluders
+		OPAQUE_ORDER_COUNT
+	};
+
+	// Enhancement: how RenderScene lights the opaque geometry
+	enum ShadingPath
+	{
+		SHADING_FORWARD = 0,	// every light evaluated while drawing
+		SHADING_DEFERRED,		// G-buffer first, then light volumes
+		SHADING_PATH_COUNT
+	};
+
+	// Enhancement: per-frame constants, std140 layout of the shaders' FrameBlock
+	struct FrameConstants
+	{
+		glm::mat4 view;
+		glm::mat4 projection;
+		glm::vec4 viewPosition;		// xyz = camera position
+	};
+	static const GLuint FRAME_BLOCK_BINDING = 3;
+
 	struct TEXTURE_INFO
 	{
 		std::string tag;
 		uint32_t ID;
 	};
 
+	// Enhancement: everything needed to draw one kind of scene object.
+	// Replaces the per-tag if/else chain in RenderScene with a table,
+	// so the draw state of each object is known before drawing starts.
+	struct RenderDescriptor
+	{
+		std::string tag;
+		MeshType mesh;
+		glm::vec3 scale;
+		float XrotationDegrees;
+		float YrotationDegrees;
+		float ZrotationDegrees;
+		std::string textureTag;		// empty = draw with color
+		std::string materialTag;
+		glm::vec2 uvScale;
+		glm::vec4 color;
+		// resolved once in ResolveRenderDescriptors()
+		int textureSlot;
+		int textureLayer;		// array layer when TextureManager uses texture arrays
+		int materialIndex;
+	};
+
+	// Enhancement: one visible object, reduced by a worker thread to
+	// what the GL thread needs to draw it. The matrices are not copied;
+	// entitySlot points into the cached world and normal matrices.
+	struct RenderCommand
+	{
+		uint32_t entitySlot;
+		MeshType mesh;
+		int textureSlot;
+		int textureLayer;
+		int materialIndex;
+		glm::vec2 uvScale;
+		glm::vec4 color;
+		int lod;				// MeshLibrary detail level
+		bool occluder;			// large enough to draw in the depth pre-pass
+	};
+
 private:
 
 	OctreeNode* m_octreeRoot = nullptr;
-	std::vector<SceneObject> m_sceneObjects;
+	// Enhancement: scene objects as SoA components behind generational
+	// handles; the octree stores handles, so nothing dangles when the
+	// component arrays grow
+	EntityStore m_entities;
+	std::vector<uint8_t> m_inOctree;	// per slot: has an octree entry
+	bool m_hierarchyChanged = false;	// scene graph needs a rebuild
 
 	// pointer to shader manager object
 	ShaderManager* m_pShaderManager;
+	// Enhancement: uniform locations of the scene program, resolved once
+	UniformCache m_uniforms;
+	// Enhancement: last vertex array and buffer bindings made by the draw paths
+	BindingCache m_bindings;
 	// pointer to basic shapes object
 	ShapeMeshes* m_basicMeshes;
 	TextureManager* m_textureManager;
 	MaterialManager* m_materialManager;
 
+	// Enhancement: draw state table and the per-frame sorted render queue
+	std::vector<RenderDescriptor> m_renderDescriptors;
+	RenderQueue m_renderQueue;
+	RenderStats m_renderStats;
+
+	// Enhancement: shared indexed meshes and per-frame instance data
+	MeshLibrary* m_meshLibrary;
+	std::vector<InstanceData> m_instanceData;
+	DrawMode m_drawMode = DRAW_INSTANCED;
+
+	// Enhancement: per-frame indirect commands and their per-draw data
+	std::vector<DrawElementsIndirectCommand> m_drawCommands;
+	std::vector<DrawData> m_drawData;
+
+	// Enhancement: triple-buffered, persistently mapped memory for
+	// everything written per frame, and this frame's constants.
+	// m_frameConstantsBuffer is only used if the driver cannot map the ring.
+	RingBuffer m_frameRing;
+	FrameConstants m_frameConstants;
+	GLuint m_frameConstantsBuffer = 0;
+
+	// Enhancement: scene lights, mirrored into the light uniform buffer
+	LightManager* m_lightManager;
+
+	// Enhancement: worker threads for culling and command generation,
+	// this frame's commands (indexed by the render queue items), and
+	// the per-thread output lists merged in a fixed order
+	WorkerPool* m_workerPool;
+	std::vector<RenderCommand> m_renderCommands;
+	std::vector<std::vector<EntityHandle>> m_cullLists;
+	std::vector<std::vector<RenderItem>> m_chunkItems;
+
+	// Enhancement: cached world and normal matrices, one per scene object.
+	// A matrix is only rebuilt when its object, or one of its parents, is
+	// dirty. The node matrices are the positions alone, which children inherit.
+	std::vector<glm::mat4> m_worldMatrices;
+	std::vector<glm::mat3> m_normalMatrices;
+	std::vector<glm::mat4> m_nodeMatrices;
+	SceneGraph m_sceneGraph;
+	std::vector<SceneGraph::Range> m_dirtyRanges;
+
+	// Enhancement: static objects baked into shared buffers, grouped
+	// by draw state and cell; regrouped in full after an import
+	StaticBatcher m_staticBatches;
+	bool m_staticBatchesChanged = false;
+	BakeShapes m_bakeShapes;			// what the batches are baked from, also handed to loads
+
+	// Enhancement: GPU frame time and the controller that holds the
+	// frame time budget; m_chunkCulled counts small objects per chunk
+	GpuTimer m_gpuTimer;
+	FrameBudget m_frameBudget;
+	std::vector<uint32_t> m_chunkCulled;
+
+	// Enhancement: opaque draw order and the fragments written by the
+	// depth pre-pass and the color pass
+	OpaqueOrder m_opaqueOrder = OPAQUE_FRONT_TO_BACK;
+	SampleCounter m_prePassSamples;
+	SampleCounter m_shadedSamples;
+
+	// Enhancement: records the frames' uniform sets, buffer contents and
+	// draws while a capture is running
+	CommandCapture m_capture;
+
+	// Enhancement: forward or deferred lighting, and the G-buffer and
+	// lighting pass of the deferred path
+	ShadingPath m_shadingPath = SHADING_FORWARD;
+	DeferredRenderer m_deferred;
+
+	// Enhancement: shadow maps of the first lights, the objects inside
+	// their views, and the unbatched static and moving objects that
+	// cast into them
+	ShadowMapper m_shadows;
+	std::vector<EntityHandle> m_shadowCandidates;
+	std::vector<ShadowCaster> m_staticShadowCasters;
+	std::vector<ShadowCaster> m_shadowCasters;
+
+	// Enhancement: background scene load, swapped in by FinishSceneLoad()
+	SceneLoader m_sceneLoader;
+	// Enhancement: the scene file whose edits are applied as they happen;
+	// declared first, as the saver reports its writes to it until it stops
+	SceneWatcher m_sceneWatcher;
+	// Enhancement: background scene saves, reported by FinishSceneSaves()
+	SceneSaver m_sceneSaver;
+	// Enhancement: live slots an edited file matched, reused by ApplySceneObjects()
+	std::vector<uint8_t> m_claimedSlots;
+
 
 	// REMOVED TEXTURE_INFO & m_textureIDs to use TextureManager and MaterialManager
 
@@ -73,6 +308,12 @@ private:
 		float ZrotationDegrees,
 		glm::vec3 positionXYZ);
 
+	// Enhancement: set an already built model matrix and its
+	// normal matrix into the transform buffer
+	void SetTransformations(
+		const glm::mat4& modelMatrix,
+		const glm::mat3& normalMatrix);
+
 	// set the color values into the shader
 	void SetShaderColor(
 		float redColorValue,
@@ -92,6 +333,118 @@ private:
 	void SetShaderMaterial(
 		std::string materialTag);
 
+	// Enhancement: set a texture by its pre-resolved slot
+	void SetShaderTextureSlot(
+		int textureSlot);
+
+	// Enhancement: select a layer of the bound texture array
+	void SetShaderTextureLayer(
+		int textureLayer);
+
+	// Enhancement: point the shader at the active texture backend
+	void SetTextureBackendUniforms();
+
+	// Enhancement: set a material by its pre-resolved index
+	void SetShaderMaterialIndex(
+		int materialIndex);
+
+	// Enhancement: define the draw state for each object tag
+	void DefineRenderDescriptors();
+
+	// Enhancement: look up texture slots, material indices and the
+	// descriptor index of every scene object once, after build or load
+	void ResolveRenderDescriptors();
+
+	// Enhancement: find the descriptor index for a tag, or -1
+	int FindRenderDescriptor(const std::string& tag) const;
+
+	// Enhancement: size the matrix cache to the scene, rebuild the scene
+	// graph and mark every object dirty, after the scene is built or loaded
+	void ResetTransformCache();
+
+	// Enhancement: rebuild the scene graph if objects were added,
+	// removed or re-parented since the last pass
+	void UpdateSceneGraph();
+
+	// Enhancement: rebuild the matrices of every dirty subtree in one
+	// batched pass, before drawing, and move changed objects in the octree
+	void UpdateDirtyTransforms();
+
+	// Enhancement: build the octree from the current world positions
+	void RebuildOctree();
+
+	// Enhancement: regroup the static objects after an import, and
+	// bake the batches whose members changed
+	void UpdateStaticBatches();
+
+	// Enhancement: a static object as the batcher takes it
+	StaticBatchMember StaticMemberOf(uint32_t slot) const;
+
+	// Enhancement: draw the static batches inside the view range
+	void DrawStaticBatches(const AABB& viewBounds);
+
+	// Enhancement: lay down the depth of the large occluders with color
+	// writes off, so the color pass shades only what is in front
+	void DrawDepthPrePass(const AABB& viewBounds);
+
+	// Enhancement: bring the shadow maps up to date with the lights and
+	// the moving objects inside their views, and bind them for the scene shader
+	void UpdateShadowMaps(bool capturing, const AABB& viewBounds);
+
+	// Enhancement: convert the entity store to and from the object
+	// list that JsonDatabase saves
+	std::vector<SceneObject> ExportSceneObjects() const;
+	void ImportSceneObjects(const std::vector<SceneObject>& objects);
+
+	// Enhancement: make a built scene the current one, handing the old
+	// entities and octree back in `scene`, and derive the matrix cache,
+	// static batches and shadows from it
+	void ApplyLoadedScene(LoadedScene& scene);
+
+	// Enhancement: what ApplySceneObjects() changed
+	struct SceneDiff
+	{
+		uint32_t added = 0;
+		uint32_t removed = 0;
+		uint32_t changed = 0;		// moved, re-parented, resized or (un)flagged static
+	};
+
+	// Enhancement: bring the live scene in line with a saved object list
+	// by adding, removing and changing only the objects that differ
+	SceneDiff ApplySceneObjects(const std::vector<SceneObject>& objects);
+
+	// Enhancement: the descriptor table in the form SceneLoader builds from
+	std::vector<SceneDescriptor> SceneDescriptors() const;
+
+	// Enhancement: point the global camera at a saved camera state, and
+	// read the state to save from it
+	void RestoreCamera(const CameraState& camera);
+	CameraState CurrentCamera() const;
+
+	// Enhancement: issue the draw call for a mesh type
+	void DrawMesh(MeshType mesh);
+
+	// Enhancement: query the octree, one top-level octant per worker
+	void CullVisibleObjects(const AABB& range, std::vector<EntityHandle>& visibleObjects);
+
+	// Enhancement: turn the visible objects into render commands and
+	// sort keys on the worker threads, then merge them into the queue;
+	// the quality settings pick each object's LOD and drop tiny objects
+	void BuildRenderCommands(const std::vector<EntityHandle>& visibleObjects,
+		const glm::vec3& cameraPosition, const QualitySettings& quality);
+
+	// Enhancement: draw the sorted queue one object at a time
+	void DrawQueue();
+
+	// Enhancement: draw the sorted queue as instanced groups
+	void DrawQueueInstanced();
+
+	// Enhancement: draw the sorted queue with multi-draw-indirect
+	void DrawQueueIndirect();
+
+	// Enhancement: write this frame's constants and bind them to the FrameBlock
+	void UploadFrameConstants();
+
 public:
 
 	// prepare the 3D scene for rendering
@@ -106,6 +459,114 @@ public:
 	// add and define the light sources before rendering
 	void SetupSceneLights();
 
+	// Enhancement: view state for the next RenderScene call, written
+	// into the per-frame ring buffer instead of set as uniforms
+	void SetFrameConstants(const glm::mat4& view, const glm::mat4& projection,
+		const glm::vec3& viewPosition);
+
+	// Enhancement: state change counters from the last RenderScene call
+	const RenderStats& GetRenderStats() const { return m_renderStats; }
+
+	// Enhancement: add an object, optionally as the child of another;
+	// the handle stays valid until the object is removed
+	EntityHandle AddObject(const glm::vec3& position, float boundingRadius,
+		const std::string& tag, EntityHandle parent = EntityHandle());
+
+	// Enhancement: remove an object; its children move up to its parent
+	bool RemoveObject(EntityHandle entity);
+
+	// Enhancement: first object with a tag, or a null handle
+	EntityHandle FindObject(const std::string& tag) const;
+
+	// Enhancement: read access to the object components
+	const EntityStore& GetEntities() const { return m_entities; }
+
+	// Enhancement: move a scene object relative to its parent; its matrices,
+	// and those of its children, are rebuilt on the next UpdateDirtyTransforms() pass
+	void SetObjectPosition(EntityHandle entity, const glm::vec3& position);
+
+	// Enhancement: turn (degrees about X, Y, Z) or scale a scene object
+	// relative to its parent; its children follow
+	void SetObjectRotation(EntityHandle entity, const glm::vec3& rotationDegrees);
+	void SetObjectScale(EntityHandle entity, const glm::vec3& scale);
+
+	// Enhancement: attach an object to a parent (null handle = none), keeping
+	// its world position; fails if the link would create a cycle
+	bool SetObjectParent(EntityHandle entity, EntityHandle parent);
+
+	// Enhancement: flag an object whose transform inputs changed
+	void MarkTransformDirty(EntityHandle entity);
+
+	// Enhancement: flag an object as never moving, so it is merged into a
+	// static batch with the objects that share its texture and material
+	void SetObjectStatic(EntityHandle entity, bool isStatic);
+
+	// Enhancement: time a uniform-heavy frame set through ShaderManager's
+	// name-based setters against the same frame set by cached handle
+	void BenchmarkUniformPaths(int frames, int drawsPerFrame);
+
+	// Enhancement: switch between per-object, instanced and indirect drawing
+	void SetDrawMode(DrawMode mode) { m_drawMode = mode; }
+	DrawMode GetDrawMode() const { return m_drawMode; }
+	static const char* DrawModeName(DrawMode mode);
+
+	// Enhancement: render the scene for a number of frames in every
+	// draw mode and print the average CPU time spent submitting draws
+	void BenchmarkDrawModes(int frames);
+
+	// Enhancement: number of threads building render commands,
+	// including the render thread; 0 = one per hardware thread
+	void SetWorkerThreadCount(unsigned threadCount);
+	unsigned GetWorkerThreadCount() const { return m_workerPool->ThreadCount(); }
+
+	// Enhancement: frame time controller; RenderScene feeds it every
+	// frame and takes its view range, LOD bias and small-object cull
+	FrameBudget& GetFrameBudget() { return m_frameBudget; }
+
+	// Enhancement: state-sorted, front-to-back or depth pre-pass ordering
+	// of the opaque geometry
+	void SetOpaqueOrder(OpaqueOrder order) { m_opaqueOrder = order; }
+	OpaqueOrder GetOpaqueOrder() const { return m_opaqueOrder; }
+	static const char* OpaqueOrderName(OpaqueOrder order);
+
+	// Enhancement: render the scene in every opaque order and print the
+	// fragments shaded per pixel and the GPU time of each
+	void BenchmarkOverdraw(int frames);
+
+	// Enhancement: render the scene with 1, 2, 4 ... worker threads
+	// and print the average CPU time spent building commands
+	void BenchmarkWorkerThreads(int frames);
+
+	// Enhancement: record the command stream of the next `frames` frames
+	// into `filename`, for CommandReplay
+	void StartCapture(const std::string& filename, int frames);
+	bool IsCapturing() const { return m_capture.IsRecording(); }
+
+	// Enhancement: compile the lighting pass of the deferred path;
+	// until it is loaded, the deferred path falls back to forward
+	bool LoadDeferredShaders(const std::string& vertexPath, const std::string& fragmentPath);
+
+	// Enhancement: switch between forward and deferred lighting
+	void SetShadingPath(ShadingPath path) { m_shadingPath = path; }
+	ShadingPath GetShadingPath() const { return m_shadingPath; }
+	static const char* ShadingPathName(ShadingPath path);
+
+	// Enhancement: render the scene with 8, 32 and 128 lights at several
+	// resolutions on both shading paths and print the GPU time of each
+	void BenchmarkLighting(int frames);
+
+	// Enhancement: compile the shadow depth pass; until it is loaded,
+	// nothing casts a shadow
+	bool LoadShadowShaders(const std::string& vertexPath, const std::string& fragmentPath);
+
+	// Enhancement: turn the shadows of the first two lights on or off
+	void SetShadowsEnabled(bool enabled) { m_shadows.SetEnabled(enabled); }
+	bool GetShadowsEnabled() const { return m_shadows.IsEnabled(); }
+
+	// Enhancement: add, remove or animate lights; changes are
+	// uploaded at the start of the next RenderScene call
+	LightManager* GetLightManager() { return m_lightManager; }
+
 	// methods for rendering the various objects in the 3D scene
 
 	void SaveSceneToJson(const std::string& filename);  //--- FIXME --- Enhancement ---
@@ -120,5 +581,37 @@ public:
 	void LoadSceneAndCameraFromJson(const std::string& filename);
 	// Enhancement: Adds a method to load both scene objects and camera state from a JSON file.
 
+	// Enhancement: load the scene and camera of a JSON file on a background
+	// thread; the current scene is drawn until FinishSceneLoad() swaps the
+	// new one in. False if a load is already under way.
+	bool LoadSceneAndCameraAsync(const std::string& filename);
+
+	// Enhancement: between frames, swap in a finished background load;
+	// true if the scene was replaced
+	bool FinishSceneLoad();
+	bool IsLoadingScene() const { return m_sceneLoader.IsBusy(); }
+	float SceneLoadProgress() const { return m_sceneLoader.Progress(); }
+
+	// Enhancement: snapshot the scene and camera and write them to a JSON
+	// file on a background thread; requests made while a write is running
+	// are coalesced into one
+	void SaveSceneAndCameraAsync(const std::string& filename);
+
+	// Enhancement: print the background saves finished since the last call
+	void FinishSceneSaves();
+	bool IsSavingScene() const { return m_sceneSaver.IsBusy(); }
+
+	// Enhancement: watch a scene file and apply its edits as they are
+	// saved, instead of reloading the whole scene
+	bool WatchSceneFile(const std::string& filename);
+
+	// Enhancement: between frames, apply the latest edit of the watched
+	// file; true if the scene changed
+	bool ApplySceneFileChanges();
+
+	// Enhancement: replace the scene with `rooms` seeded rooms of toys,
+	// and print the time taken and the memory held afterwards
+	void GenerateStressScene(size_t rooms, uint32_t seed);
+
 
 };
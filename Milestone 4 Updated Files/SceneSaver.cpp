@@ -0,0 +1,141 @@
+/***********************************************************
+ *
+ *  SceneSaver.cpp
+ *	============
+ *  writes scene saves on a background thread
+ *
+ ***********************************************************/
+
+#include "SceneSaver.h"
+#include "SceneWatcher.h"
+#include <chrono>
+#include <utility>
+
+
+SceneSaver::SceneSaver()
+    : m_watcher(nullptr), m_hasPending(false), m_writing(false), m_stop(false) {
+}
+
+SceneSaver::~SceneSaver() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    if (m_thread.joinable()) m_thread.join();
+}
+
+
+void SceneSaver::Request(const std::string& filename, const EntityStore& entities, const CameraState& camera) {
+    // copied before locking, so the writer never waits on the copy
+    m_filling.filename = filename;
+    m_filling.slots.CopyFrom(entities);
+    m_filling.camera = camera;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_filling.coalesced = m_hasPending ? m_pending.coalesced + 1 : 0;
+        std::swap(m_pending, m_filling);
+        m_hasPending = true;
+    }
+    if (!m_thread.joinable())
+        m_thread = std::thread(&SceneSaver::WriterLoop, this);
+    m_wake.notify_one();
+}
+
+
+bool SceneSaver::IsBusy() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_writing || m_hasPending;
+}
+
+
+bool SceneSaver::TakeResults(std::vector<SceneSaveResult>& results) {
+    results.clear();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::swap(results, m_results);
+    return !results.empty();
+}
+
+
+// --- Enhancement: Writer thread, one snapshot at a time ---
+void SceneSaver::WriterLoop() {
+    Snapshot snapshot;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        m_wake.wait(lock, [this] { return m_hasPending || m_stop; });
+        // pending saves are written before stopping
+        if (!m_hasPending) return;
+
+        std::swap(snapshot, m_pending);
+        m_hasPending = false;
+        m_writing = true;
+        lock.unlock();
+
+        auto start = std::chrono::steady_clock::now();
+        SceneSaveResult result;
+        result.filename = snapshot.filename;
+        result.coalesced = snapshot.coalesced;
+        std::vector<SceneObject> objects = snapshot.slots.Export();
+        result.objectCount = objects.size();
+        if (m_watcher) m_watcher->BeginOwnWrite();
+        result.saved = JsonDatabase::SaveSceneAndCamera(objects, snapshot.camera, snapshot.filename);
+        if (m_watcher) m_watcher->EndOwnWrite(snapshot.filename, result.saved);
+        result.writeMs = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+
+        lock.lock();
+        m_writing = false;
+        m_results.push_back(result);
+    }
+}
+
+
+std::vector<SceneObject> SceneSaver::ExportObjects(const EntityStore& entities) {
+    SavedSlots slots;
+    slots.CopyFrom(entities);
+    return slots.Export();
+}
+
+
+// --- Enhancement: Flat copies, no per-object work on the render thread ---
+void SavedSlots::CopyFrom(const EntityStore& entities) {
+    localPosition = entities.localPosition;
+    localRotation = entities.localRotation;
+    localScale = entities.localScale;
+    boundingRadius = entities.boundingRadius;
+    tagId = entities.tagId;
+    isStatic = entities.isStatic;
+    objectId = entities.objectId;
+    parent = entities.parent;
+    generation = entities.Generations();
+    alive = entities.AliveSlots();
+    tagNames.resize(entities.TagCount());
+    for (uint32_t id = 0; id < tagNames.size(); ++id)
+        tagNames[id] = entities.TagName(id);
+}
+
+
+std::vector<SceneObject> SavedSlots::Export() const {
+    std::vector<SceneObject> objects;
+    std::vector<int> savedIndex(alive.size(), -1);
+    for (uint32_t slot = 0; slot < alive.size(); ++slot) {
+        if (!alive[slot])
+            continue;
+        savedIndex[slot] = static_cast<int>(objects.size());
+        SceneObject obj = { localPosition[slot], boundingRadius[slot], tagNames[tagId[slot]] };
+        obj.rotation = localRotation[slot];
+        obj.scale = localScale[slot];
+        obj.isStatic = isStatic[slot] != 0;
+        obj.id = objectId[slot];
+        objects.push_back(obj);
+    }
+
+    // parents can sit in a later slot than their children
+    for (uint32_t slot = 0; slot < alive.size(); ++slot) {
+        EntityHandle link = parent[slot];
+        if (savedIndex[slot] < 0 || link.IsNull() || link.index >= alive.size()) continue;
+        if (alive[link.index] && generation[link.index] == link.generation)
+            objects[savedIndex[slot]].parentIndex = savedIndex[link.index];
+    }
+    return objects;
+}
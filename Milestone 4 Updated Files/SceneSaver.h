@@ -0,0 +1,125 @@
+/***********************************************************
+ *
+ *  SceneSaver.h
+ *	============
+ *  writes scene saves on a background thread
+ *
+ ***********************************************************/
+
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "EntityStore.h"
+#include "JsonDatabase.h"
+
+class SceneWatcher;
+
+
+// --- Enhancement: The saved components of every entity slot ---
+// Only what a save writes, copied array by array; filling it again
+// reuses the arrays' storage.
+struct SavedSlots {
+    std::vector<glm::vec3> localPosition;
+    std::vector<glm::vec3> localRotation;
+    std::vector<glm::vec3> localScale;
+    std::vector<float> boundingRadius;
+    std::vector<uint32_t> tagId;
+    std::vector<uint8_t> isStatic;
+    std::vector<uint32_t> objectId;
+    std::vector<EntityHandle> parent;
+    std::vector<uint32_t> generation;
+    std::vector<uint8_t> alive;
+    std::vector<std::string> tagNames;
+
+    void CopyFrom(const EntityStore& entities);
+
+    // The saved form: live slots in order, parents as indices into the list
+    std::vector<SceneObject> Export() const;
+};
+
+
+// --- Enhancement: Outcome of one background write ---
+struct SceneSaveResult {
+    std::string filename;
+    bool saved = false;
+    size_t objectCount = 0;
+    double writeMs = 0.0;           // converting, serializing and writing
+    unsigned coalesced = 0;         // requests replaced by this one while it waited
+};
+
+
+/***********************************************************
+ *  SceneSaver
+ *
+ *  Saving used to convert, pretty-print and write the whole
+ *  scene on the render thread. Here the render thread only
+ *  copies the saved components and the camera (a handful
+ *  of flat arrays, into storage reused from earlier saves);
+ *  a writer thread of its own turns the copy into JSON and
+ *  writes it through JsonDatabase, which replaces the file
+ *  atomically. A SceneWatcher on the same file is told
+ *  about each write, so the app's own saves are not
+ *  applied back to the scene as edits.
+ *
+ *  One write runs at a time. A request made while one is
+ *  running waits in a single slot, and a newer request
+ *  replaces it, so a burst of saves writes the first state
+ *  and the last one. Finished writes are collected with
+ *  TakeResults() on the render thread. The destructor
+ *  completes the running and queued writes before it
+ *  returns, so a save made just before exit is not lost.
+ ***********************************************************/
+class SceneSaver {
+public:
+    SceneSaver();
+    ~SceneSaver();
+
+    // Writes are reported to `watcher` so it skips them; set before the
+    // first request, nullptr for none
+    void SetWatcher(SceneWatcher* watcher) { m_watcher = watcher; }
+
+    // Queues a save of `entities` and `camera` to `filename`; the writer
+    // thread is started on the first request
+    void Request(const std::string& filename, const EntityStore& entities, const CameraState& camera);
+
+    // True while a write is running or queued
+    bool IsBusy() const;
+
+    // Moves the writes finished since the last call into `results`
+    // (cleared first); false if there were none
+    bool TakeResults(std::vector<SceneSaveResult>& results);
+
+    // The saved form of the live entities: slots in order, parents as
+    // indices into the list. Shared with SceneManager's synchronous saves.
+    static std::vector<SceneObject> ExportObjects(const EntityStore& entities);
+
+private:
+    struct Snapshot {
+        std::string filename;
+        SavedSlots slots;
+        CameraState camera;
+        unsigned coalesced = 0;
+    };
+
+    void WriterLoop();
+
+    // Request() fills this one and swaps it with m_pending, which hands
+    // back the storage of a replaced request or of a finished write
+    Snapshot m_filling;
+    SceneWatcher* m_watcher;
+
+    std::thread m_thread;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+
+    // guarded by m_mutex
+    Snapshot m_pending;
+    bool m_hasPending;
+    bool m_writing;
+    bool m_stop;
+    std::vector<SceneSaveResult> m_results;
+};
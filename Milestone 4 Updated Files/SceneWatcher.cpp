@@ -0,0 +1,191 @@
+/***********************************************************
+ *
+ *  SceneWatcher.cpp
+ *	============
+ *  re-parses a scene file in the background when it changes
+ *
+ ***********************************************************/
+
+#include "SceneWatcher.h"
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <utility>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    typedef std::chrono::steady_clock Clock;
+}
+
+
+SceneWatcher::SceneWatcher()
+    : m_stop(false), m_inotify(-1), m_changed(false), m_ownWritesInFlight(0), m_ownWriteSize(0) {
+}
+
+SceneWatcher::~SceneWatcher() {
+    Stop();
+}
+
+
+bool SceneWatcher::Start(const std::string& filename) {
+    Stop();
+    m_filename = filename;
+    m_stop = false;
+
+#ifdef __linux__
+    // watch the directory: a file replaced by a rename is a new inode,
+    // which a watch on the file itself would not follow
+    std::string directory = std::filesystem::path(filename).parent_path().string();
+    if (directory.empty()) directory = ".";
+    m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_inotify >= 0 &&
+        inotify_add_watch(m_inotify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        close(m_inotify);
+        m_inotify = -1;
+    }
+    if (m_inotify < 0) {
+        std::cout << "Cannot watch " << directory << " for changes" << std::endl;
+        return false;
+    }
+    m_thread = std::thread(&SceneWatcher::WatchLoop, this);
+#else
+    m_thread = std::thread(&SceneWatcher::PollLoop, this);
+#endif
+    return true;
+}
+
+
+void SceneWatcher::Stop() {
+    m_stop = true;
+    if (m_thread.joinable()) m_thread.join();
+#ifdef __linux__
+    if (m_inotify >= 0) close(m_inotify);
+#endif
+    m_inotify = -1;
+}
+
+
+bool SceneWatcher::TakeObjects(std::vector<SceneObject>& objects) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_changed) return false;
+    objects.clear();
+    std::swap(objects, m_objects);
+    m_changed = false;
+    return true;
+}
+
+
+void SceneWatcher::BeginOwnWrite() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_ownWritesInFlight;
+}
+
+
+void SceneWatcher::EndOwnWrite(const std::string& filename, bool written) {
+    std::error_code error;
+    std::filesystem::file_time_type time;
+    uintmax_t size = 0;
+    if (written) {
+        time = std::filesystem::last_write_time(filename, error);
+        if (!error) size = std::filesystem::file_size(filename, error);
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    --m_ownWritesInFlight;
+    if (written && !error) {
+        m_ownWritePath = filename;
+        m_ownWriteTime = time;
+        m_ownWriteSize = size;
+    }
+}
+
+
+// --- Enhancement: inotify events for the file, parsed once they settle ---
+void SceneWatcher::WatchLoop() {
+#ifdef __linux__
+    const std::string name = std::filesystem::path(m_filename).filename().string();
+    alignas(inotify_event) char buffer[4096];
+    bool pending = false;
+    Clock::time_point settled;
+
+    while (!m_stop) {
+        // wake up often enough to notice Stop() and the end of the quiet time
+        pollfd descriptor = { m_inotify, POLLIN, 0 };
+        if (poll(&descriptor, 1, SETTLE_MS / 2) > 0 && (descriptor.revents & POLLIN)) {
+            ssize_t length;
+            while ((length = read(m_inotify, buffer, sizeof(buffer))) > 0) {
+                for (char* event = buffer; event < buffer + length;) {
+                    const inotify_event* info = reinterpret_cast<const inotify_event*>(event);
+                    if (info->len > 0 && name == info->name) {
+                        pending = true;
+                        settled = Clock::now() + std::chrono::milliseconds(SETTLE_MS);
+                    }
+                    event += sizeof(inotify_event) + info->len;
+                }
+            }
+        }
+        if (pending && Clock::now() >= settled) {
+            pending = !Parse();
+            if (pending) settled = Clock::now() + std::chrono::milliseconds(SETTLE_MS);
+        }
+    }
+#endif
+}
+
+
+// --- Enhancement: Modification time checks where inotify is missing ---
+void SceneWatcher::PollLoop() {
+    std::error_code error;
+    std::filesystem::file_time_type seen = std::filesystem::last_write_time(m_filename, error);
+    bool pending = false;
+
+    while (!m_stop) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(POLL_MS));
+        std::filesystem::file_time_type written = std::filesystem::last_write_time(m_filename, error);
+        if (error) continue;
+        if (written != seen) {
+            // still being written; parse once a whole interval passes quietly
+            seen = written;
+            pending = true;
+        }
+        else if (pending) {
+            pending = !Parse();
+        }
+    }
+}
+
+
+bool SceneWatcher::Parse() {
+    // the app's own save: the scene already holds what the file does
+    std::error_code error;
+    std::filesystem::file_time_type written = std::filesystem::last_write_time(m_filename, error);
+    uintmax_t size = error ? 0 : std::filesystem::file_size(m_filename, error);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_ownWritesInFlight > 0)
+            return false;
+        if (!error && !m_ownWritePath.empty() && written == m_ownWriteTime && size == m_ownWriteSize &&
+            std::filesystem::equivalent(m_ownWritePath, m_filename, error))
+            return true;
+    }
+
+    // scene files saved with F5 carry the camera; plain object lists are
+    // accepted too. The camera is not reloaded.
+    std::vector<SceneObject> objects;
+    CameraState camera;
+    if (!JsonDatabase::LoadSceneAndCamera(objects, camera, m_filename) &&
+        !JsonDatabase::LoadSceneObjects(objects, m_filename)) {
+        std::cout << m_filename << " changed but does not parse, keeping the live scene" << std::endl;
+        return true;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_objects = std::move(objects);
+    m_changed = true;
+    return true;
+}
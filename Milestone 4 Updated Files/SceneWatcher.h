@@ -0,0 +1,88 @@
+/***********************************************************
+ *
+ *  SceneWatcher.h
+ *	============
+ *  re-parses a scene file in the background when it changes
+ *
+ ***********************************************************/
+
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "JsonDatabase.h"
+#include "Octree.h"
+
+
+/***********************************************************
+ *  SceneWatcher
+ *
+ *  Watches one scene file from a thread of its own. On Linux
+ *  the thread sleeps on inotify events for the file's
+ *  directory, which also catches editors and tools (and
+ *  SceneSaver) that write a new file and rename it over the
+ *  old one; elsewhere it compares the file's modification
+ *  time every POLL_MS. Once the file has been quiet for
+ *  SETTLE_MS it is parsed on the same thread, and the
+ *  objects are kept for TakeObjects(). A file that does not
+ *  parse (half written, or a typo) is reported and skipped
+ *  until it changes again.
+ *
+ *  The watcher only reads the file; comparing the objects
+ *  with the live scene is up to the caller, on the render
+ *  thread. The app's own saves are skipped: SceneSaver
+ *  brackets each write with BeginOwnWrite()/EndOwnWrite().
+ *  The file is not parsed while a write is in flight, and
+ *  one that still has the modification time and size the
+ *  last write left is not parsed at all.
+ ***********************************************************/
+class SceneWatcher {
+public:
+    static const int SETTLE_MS = 100;   // quiet time before a change is parsed
+    static const int POLL_MS = 250;     // check interval without inotify
+
+    SceneWatcher();
+    ~SceneWatcher();
+
+    // Starts watching `filename`; the current contents are not reported.
+    // False if the watch cannot be set up.
+    bool Start(const std::string& filename);
+    void Stop();
+    bool IsWatching() const { return m_thread.joinable(); }
+    const std::string& Filename() const { return m_filename; }
+
+    // Moves the objects of the latest parse into `objects`; false if the
+    // file has not changed since the last call
+    bool TakeObjects(std::vector<SceneObject>& objects);
+
+    // Bracket a write this process makes to `filename`: no parse runs in
+    // between, and the contents the file has at EndOwnWrite() are not
+    // reported. May be called from any thread.
+    void BeginOwnWrite();
+    void EndOwnWrite(const std::string& filename, bool written);
+
+private:
+    void WatchLoop();
+    void PollLoop();
+    // False, without parsing, while one of the app's own writes is in flight
+    bool Parse();
+
+    std::thread m_thread;
+    std::atomic<bool> m_stop;
+    std::string m_filename;     // set before the thread starts
+    int m_inotify;              // -1 when polling
+
+    std::mutex m_mutex;
+    std::vector<SceneObject> m_objects;     // guarded by m_mutex
+    bool m_changed;                         // guarded by m_mutex
+
+    // the app's own writes, guarded by m_mutex
+    int m_ownWritesInFlight;
+    std::string m_ownWritePath;
+    std::filesystem::file_time_type m_ownWriteTime;
+    uintmax_t m_ownWriteSize;
+};
@@ -0,0 +1,71 @@
+/***********************************************************
+ *
+ *  ShaderFiles.cpp
+ *	============
+ *  programs built from GLSL files, for passes outside ShaderManager
+ *
+ ***********************************************************/
+
+#include "ShaderFiles.h"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+    GLuint CompileShaderFile(GLenum type, const std::string& path, const char* label) {
+        std::ifstream file(path);
+        if (!file) {
+            std::cout << label << " shader not found: " << path << std::endl;
+            return 0;
+        }
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        std::string source = buffer.str();
+
+        GLuint shader = glCreateShader(type);
+        const char* text = source.c_str();
+        glShaderSource(shader, 1, &text, NULL);
+        glCompileShader(shader);
+
+        GLint compiled = GL_FALSE;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+        if (!compiled) {
+            char log[1024];
+            glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+            std::cout << label << " shader " << path << " failed to compile:\n" << log << std::endl;
+            glDeleteShader(shader);
+            return 0;
+        }
+        return shader;
+    }
+}
+
+
+GLuint LinkProgramFiles(const std::string& vertexPath, const std::string& fragmentPath,
+                        const char* label) {
+    GLuint vertexShader = CompileShaderFile(GL_VERTEX_SHADER, vertexPath, label);
+    GLuint fragmentShader = CompileShaderFile(GL_FRAGMENT_SHADER, fragmentPath, label);
+    if (!vertexShader || !fragmentShader) {
+        glDeleteShader(vertexShader);
+        glDeleteShader(fragmentShader);
+        return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    glLinkProgram(program);
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        char log[1024];
+        glGetProgramInfoLog(program, sizeof(log), NULL, log);
+        std::cout << label << " program failed to link:\n" << log << std::endl;
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
@@ -0,0 +1,18 @@
+/***********************************************************
+ *
+ *  ShaderFiles.h
+ *	============
+ *  programs built from GLSL files, for passes outside ShaderManager
+ *
+ ***********************************************************/
+
+#pragma once
+#include <string>
+#include <GL/glew.h>
+
+
+// --- Enhancement: Compile and link a vertex/fragment pair ---
+// Returns the program, or 0 after printing what failed; `label` names
+// the pass in those messages.
+GLuint LinkProgramFiles(const std::string& vertexPath, const std::string& fragmentPath,
+                        const char* label);
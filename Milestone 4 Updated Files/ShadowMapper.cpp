@@ -0,0 +1,396 @@
+/***********************************************************
+ *
+ *  ShadowMapper.cpp
+ *	============
+ *  shadow maps whose static part is rendered once and cached
+ *
+ ***********************************************************/
+
+#include "ShadowMapper.h"
+#include "ShaderFiles.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <iostream>
+#include <glm/gtc/matrix_transform.hpp>
+
+static_assert(sizeof(ShadowStd140) == 2 * 64 + 16 + 16, "ShadowStd140 must match the std140 ShadowBlock");
+
+namespace {
+    // Moves the lookup point off the surface along its normal, in world
+    // units, so a lit surface does not shadow itself
+    const float NORMAL_OFFSET = 0.02f;
+
+    GLuint CreateDepthMap(int size) {
+        GLuint texture = 0;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT24, size, size);
+        // hardware 2x2 percentage-closer filtering through sampler2DShadow
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        return texture;
+    }
+
+    GLuint CreateDepthFramebuffer(GLuint depthMap) {
+        GLuint framebuffer = 0;
+        glGenFramebuffers(1, &framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthMap, 0);
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+        return framebuffer;
+    }
+
+    bool SameBounds(const AABB& a, const AABB& b) {
+        return a.min == b.min && a.max == b.max;
+    }
+}
+
+
+ShadowMapper::ShadowMapper()
+    : m_program(0), m_viewProjectionLocation(-1), m_instancingLocation(-1), m_shadowBuffer(0),
+      m_enabled(true), m_shadowCount(0), m_staticRenders(0), m_dynamicCasters(0) {
+    m_receivers.min = m_receivers.max = glm::vec3(0.0f);
+    for (GLsizei& count : m_meshInstances) count = 0;
+}
+
+ShadowMapper::~ShadowMapper() {
+    Destroy();
+}
+
+
+bool ShadowMapper::LoadShaders(const std::string& vertexPath, const std::string& fragmentPath) {
+    if (m_program) {
+        glDeleteProgram(m_program);
+        m_program = 0;
+    }
+
+    GLuint program = LinkProgramFiles(vertexPath, fragmentPath, "Shadow depth");
+    if (!program) return false;
+
+    m_program = program;
+    m_viewProjectionLocation = glGetUniformLocation(m_program, "lightViewProjection");
+    m_instancingLocation = glGetUniformLocation(m_program, "bUseInstancing");
+    InvalidateAll();
+    return CreateMaps();
+}
+
+
+bool ShadowMapper::CreateMaps() {
+    if (m_maps[0].staticMap) return true;
+
+    GLint previous = 0;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previous);
+
+    bool complete = true;
+    for (ShadowMap& map : m_maps) {
+        map.staticMap = CreateDepthMap(MAP_SIZE);
+        map.liveMap = CreateDepthMap(MAP_SIZE);
+        map.staticFramebuffer = CreateDepthFramebuffer(map.staticMap);
+        complete = complete && glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+        map.liveFramebuffer = CreateDepthFramebuffer(map.liveMap);
+        complete = complete && glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, previous);
+
+    if (!complete) {
+        std::cout << "Shadow map framebuffer is incomplete" << std::endl;
+        Destroy();
+        return false;
+    }
+    return true;
+}
+
+
+void ShadowMapper::InvalidateRegion(const glm::vec3& center, float radius) {
+    for (ShadowMap& map : m_maps) {
+        if (map.valid && SphereInView(map, center, radius))
+            map.valid = false;
+    }
+}
+
+
+void ShadowMapper::InvalidateAll() {
+    for (ShadowMap& map : m_maps)
+        map.valid = false;
+}
+
+
+// --- Enhancement: Perspective view from the light, fitted to the receivers ---
+void ShadowMapper::FitView(ShadowMap& map, const glm::vec3& lightPosition, const AABB& receivers) const {
+    glm::vec3 direction = (receivers.min + receivers.max) * 0.5f - lightPosition;
+    direction = glm::length(direction) > 0.0001f ? glm::normalize(direction) : glm::vec3(0.0f, -1.0f, 0.0f);
+    glm::vec3 up = std::abs(direction.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+    glm::mat4 view = glm::lookAt(lightPosition, lightPosition + direction, up);
+
+    // widest corner of the receivers, capped; a corner beside or behind
+    // the light needs the whole cap
+    const float nearLimit = 0.1f;
+    const float maxTan = std::tan(glm::radians(MAX_FIELD_OF_VIEW * 0.5f));
+    float tanHalf = 0.0f;
+    float nearDepth = FLT_MAX;
+    float farDepth = 0.0f;
+    for (int corner = 0; corner < 8; ++corner) {
+        glm::vec3 point((corner & 1) ? receivers.max.x : receivers.min.x,
+                        (corner & 2) ? receivers.max.y : receivers.min.y,
+                        (corner & 4) ? receivers.max.z : receivers.min.z);
+        glm::vec4 viewPoint = view * glm::vec4(point, 1.0f);
+        float depth = -viewPoint.z;
+        farDepth = std::max(farDepth, depth);
+        if (depth <= nearLimit) {
+            tanHalf = maxTan;
+            nearDepth = nearLimit;
+            continue;
+        }
+        nearDepth = std::min(nearDepth, depth);
+        tanHalf = std::max(tanHalf, std::max(std::abs(viewPoint.x), std::abs(viewPoint.y)) / depth);
+    }
+    tanHalf = std::min(tanHalf, maxTan);
+    nearDepth = std::max(nearDepth, nearLimit);
+    farDepth = std::max(farDepth, nearDepth + 1.0f);
+
+    glm::mat4 projection = glm::perspective(2.0f * std::atan(tanHalf), 1.0f, nearDepth, farDepth);
+    map.viewProjection = projection * view;
+
+    // Gribb-Hartmann: each plane is the last row plus or minus another row
+    const glm::mat4& m = map.viewProjection;
+    for (int axis = 0; axis < 3; ++axis) {
+        for (int side = 0; side < 2; ++side) {
+            float sign = side == 0 ? 1.0f : -1.0f;
+            glm::vec4 plane(m[0][3] + sign * m[0][axis], m[1][3] + sign * m[1][axis],
+                            m[2][3] + sign * m[2][axis], m[3][3] + sign * m[3][axis]);
+            map.planes[axis * 2 + side] = plane / glm::length(glm::vec3(plane));
+        }
+    }
+
+    // the frustum's corners, back from clip space
+    glm::mat4 inverse = glm::inverse(map.viewProjection);
+    for (int corner = 0; corner < 8; ++corner) {
+        glm::vec4 point = inverse * glm::vec4((corner & 1) ? 1.0f : -1.0f, (corner & 2) ? 1.0f : -1.0f,
+                                              (corner & 4) ? 1.0f : -1.0f, 1.0f);
+        glm::vec3 world = glm::vec3(point) / point.w;
+        map.bounds.min = corner == 0 ? world : glm::min(map.bounds.min, world);
+        map.bounds.max = corner == 0 ? world : glm::max(map.bounds.max, world);
+    }
+}
+
+
+bool ShadowMapper::SphereInView(const ShadowMap& map, const glm::vec3& center, float radius) const {
+    for (const glm::vec4& plane : map.planes) {
+        if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+            return false;
+    }
+    return true;
+}
+
+
+// --- Enhancement: Stale lights are aimed again; their maps are rendered by Update() ---
+void ShadowMapper::FitViews(const LightManager& lights, const AABB& receivers) {
+    m_shadowCount = std::min(lights.LightCount(), static_cast<int>(MAX_SHADOWED_LIGHTS));
+    if (!m_enabled || !IsReady() || !m_maps[0].staticMap)
+        m_shadowCount = 0;
+
+    // a different fit moves every map
+    if (!SameBounds(receivers, m_receivers)) {
+        m_receivers = receivers;
+        InvalidateAll();
+    }
+
+    for (int light = 0; light < m_shadowCount; ++light) {
+        ShadowMap& map = m_maps[light];
+        const glm::vec3& position = lights.GetLight(light)->position;
+        if (map.valid && position != map.lightPosition)
+            map.valid = false;
+
+        if (!map.valid) {
+            map.lightPosition = position;
+            FitView(map, position, receivers);
+        }
+    }
+}
+
+
+bool ShadowMapper::CasterBounds(AABB& bounds) const {
+    for (int light = 0; light < m_shadowCount; ++light) {
+        const AABB& view = m_maps[light].bounds;
+        bounds.min = light == 0 ? view.min : glm::min(bounds.min, view.min);
+        bounds.max = light == 0 ? view.max : glm::max(bounds.max, view.max);
+    }
+    return m_shadowCount > 0;
+}
+
+
+// --- Enhancement: Stale lights get their static map rendered again ---
+void ShadowMapper::Update(const LightManager& lights, const StaticBatcher& batches,
+                         const std::vector<ShadowCaster>& staticCasters,
+                         const std::vector<ShadowCaster>& casters, MeshLibrary& meshes) {
+    m_staticRenders = 0;
+    m_dynamicCasters = 0;
+    ShadowStd140 block = {};
+    int shadowCount = std::min(m_shadowCount, lights.LightCount());
+
+    if (shadowCount > 0) {
+        GLint previousFramebuffer = 0;
+        GLint previousViewport[4] = { 0, 0, 0, 0 };
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+        glGetIntegerv(GL_VIEWPORT, previousViewport);
+
+        glUseProgram(m_program);
+        glViewport(0, 0, MAP_SIZE, MAP_SIZE);
+        glEnable(GL_DEPTH_TEST);
+        glDepthMask(GL_TRUE);
+        // casters in front of the near plane still write depth, clamped to it
+        glEnable(GL_DEPTH_CLAMP);
+        glEnable(GL_POLYGON_OFFSET_FILL);
+        glPolygonOffset(2.0f, 4.0f);
+
+        // one pass over the casters groups them by mesh for every light
+        SortByMesh(casters, m_casterOrder);
+        SortByMesh(staticCasters, m_staticOrder);
+
+        for (int light = 0; light < shadowCount; ++light) {
+            ShadowMap& map = m_maps[light];
+            if (!map.valid) {
+                glUniformMatrix4fv(m_viewProjectionLocation, 1, GL_FALSE, &map.viewProjection[0][0]);
+                RenderStatic(map, batches, staticCasters, meshes);
+                map.valid = true;
+                m_staticRenders++;
+            }
+
+            // moving casters inside this light's view, grouped by mesh
+            GatherCasters(map, casters, m_casterOrder);
+
+            GLuint sampled = map.staticMap;
+            if (!m_instances.empty()) {
+                glCopyImageSubData(map.staticMap, GL_TEXTURE_2D, 0, 0, 0, 0,
+                                   map.liveMap, GL_TEXTURE_2D, 0, 0, 0, 0, MAP_SIZE, MAP_SIZE, 1);
+                glUniformMatrix4fv(m_viewProjectionLocation, 1, GL_FALSE, &map.viewProjection[0][0]);
+                glBindFramebuffer(GL_FRAMEBUFFER, map.liveFramebuffer);
+                DrawCasters(meshes);
+                m_dynamicCasters += static_cast<uint32_t>(m_instances.size());
+                sampled = map.liveMap;
+            }
+
+            glActiveTexture(GL_TEXTURE0 + FIRST_TEXTURE_UNIT + light);
+            glBindTexture(GL_TEXTURE_2D, sampled);
+
+            // clip space to [0, 1] texture and depth coordinates
+            const glm::mat4 bias = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0.5f)), glm::vec3(0.5f));
+            block.shadowMatrix[light] = bias * map.viewProjection;
+        }
+        glActiveTexture(GL_TEXTURE0);
+
+        glDisable(GL_POLYGON_OFFSET_FILL);
+        glDisable(GL_DEPTH_CLAMP);
+        glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+        glViewport(previousViewport[0], previousViewport[1], previousViewport[2], previousViewport[3]);
+    }
+
+    block.shadowCount[0] = shadowCount;
+    WriteBlock(block);
+}
+
+
+void ShadowMapper::BindNone() {
+    m_staticRenders = 0;
+    m_dynamicCasters = 0;
+    ShadowStd140 block = {};
+    WriteBlock(block);
+}
+
+
+void ShadowMapper::WriteBlock(ShadowStd140& block) {
+    // bound even without maps, the shaders read shadowCount
+    if (!m_shadowBuffer) {
+        glGenBuffers(1, &m_shadowBuffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, m_shadowBuffer);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(ShadowStd140), NULL, GL_DYNAMIC_DRAW);
+    }
+    block.params = glm::vec4(NORMAL_OFFSET, 0.0f, 0.0f, 0.0f);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_shadowBuffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(ShadowStd140), &block);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, SHADOW_BLOCK_BINDING, m_shadowBuffer);
+}
+
+
+void ShadowMapper::RenderStatic(ShadowMap& map, const StaticBatcher& batches,
+                                const std::vector<ShadowCaster>& staticCasters, MeshLibrary& meshes) {
+    glBindFramebuffer(GL_FRAMEBUFFER, map.staticFramebuffer);
+    glClear(GL_DEPTH_BUFFER_BIT);
+    glUniform1i(m_instancingLocation, GL_FALSE);
+    for (size_t i = 0; i < batches.BatchCount(); ++i) {
+        const StaticBatcher::Batch& batch = batches.GetBatch(i);
+        glm::vec3 center = (batch.bounds.min + batch.bounds.max) * 0.5f;
+        float radius = glm::length(batch.bounds.max - center);
+        if (batch.IsDrawable() && SphereInView(map, center, radius))
+            batches.Draw(i);
+    }
+
+    // static objects too large to batch are drawn once here, not every frame
+    GatherCasters(map, staticCasters, m_staticOrder);
+    if (!m_instances.empty()) DrawCasters(meshes);
+}
+
+
+void ShadowMapper::SortByMesh(const std::vector<ShadowCaster>& casters, std::vector<uint32_t>& order) {
+    order.resize(casters.size());
+    for (uint32_t i = 0; i < casters.size(); ++i) order[i] = i;
+    std::stable_sort(order.begin(), order.end(),
+        [&casters](uint32_t a, uint32_t b) { return casters[a].mesh < casters[b].mesh; });
+}
+
+
+// --- Enhancement: The casters inside the map's view, as instances grouped by mesh ---
+void ShadowMapper::GatherCasters(const ShadowMap& map, const std::vector<ShadowCaster>& casters,
+                                 const std::vector<uint32_t>& order) {
+    m_instances.clear();
+    for (GLsizei& count : m_meshInstances) count = 0;
+    for (uint32_t index : order) {
+        const ShadowCaster& caster = casters[index];
+        if (!SphereInView(map, caster.center, caster.radius)) continue;
+        InstanceData instance = {};
+        instance.model = caster.model;
+        m_instances.push_back(instance);
+        m_meshInstances[caster.mesh]++;
+    }
+}
+
+
+// Into the bound framebuffer
+void ShadowMapper::DrawCasters(MeshLibrary& meshes) {
+    glUniform1i(m_instancingLocation, GL_TRUE);
+    meshes.UploadInstances(m_instances);
+    meshes.Bind();
+    GLuint first = 0;
+    for (int mesh = 0; mesh < MESH_COUNT; ++mesh) {
+        if (m_meshInstances[mesh] == 0) continue;
+        meshes.DrawInstanced(static_cast<MeshType>(mesh), first, m_meshInstances[mesh]);
+        first += m_meshInstances[mesh];
+    }
+}
+
+
+void ShadowMapper::Destroy() {
+    for (ShadowMap& map : m_maps) {
+        if (map.staticFramebuffer) glDeleteFramebuffers(1, &map.staticFramebuffer);
+        if (map.liveFramebuffer) glDeleteFramebuffers(1, &map.liveFramebuffer);
+        if (map.staticMap) glDeleteTextures(1, &map.staticMap);
+        if (map.liveMap) glDeleteTextures(1, &map.liveMap);
+        map = ShadowMap();
+    }
+    if (m_shadowBuffer) {
+        glDeleteBuffers(1, &m_shadowBuffer);
+        m_shadowBuffer = 0;
+    }
+    if (m_program) {
+        glDeleteProgram(m_program);
+        m_program = 0;
+    }
+}
@@ -0,0 +1,151 @@
+/***********************************************************
+ *
+ *  ShadowMapper.h
+ *	============
+ *  shadow maps whose static part is rendered once and cached
+ *
+ ***********************************************************/
+
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include "LightManager.h"
+#include "MeshLibrary.h"
+#include "Octree.h"
+#include "StaticBatcher.h"
+
+
+// --- Enhancement: One object drawn into the maps on its own, not in a batch ---
+struct ShadowCaster {
+    MeshType mesh;
+    glm::mat4 model;
+    glm::vec3 center;       // world space bounding sphere
+    float radius;
+};
+
+
+// --- Enhancement: std140 layout of the shaders' ShadowBlock ---
+struct ShadowStd140 {
+    glm::mat4 shadowMatrix[2];  // world space to shadow map [0, 1] coordinates
+    GLint shadowCount[4];       // x = lights with a shadow map
+    glm::vec4 params;           // x = normal offset in world units
+};
+
+
+/***********************************************************
+ *  ShadowMapper
+ *
+ *  Shadow maps for the first MAX_SHADOWED_LIGHTS lights. The
+ *  scene's lights are point lights; each map is a single
+ *  perspective view from the light, aimed at and fitted to
+ *  the receivers the caller picks, with a field of view of
+ *  at most MAX_FIELD_OF_VIEW. Surfaces outside it are
+ *  unshadowed.
+ *
+ *  Every light keeps two depth maps. The static map holds the
+ *  static batches, and the static objects too large to batch,
+ *  and is only rendered again when the light
+ *  moves or static geometry inside its view changes
+ *  (InvalidateRegion). Each frame, if any moving object lies
+ *  inside the light's view, the static map is copied into the
+ *  live map and the moving objects are drawn on top; if none
+ *  does, the static map is sampled directly.
+ ***********************************************************/
+class ShadowMapper {
+public:
+    static const int MAX_SHADOWED_LIGHTS = 2;
+    // First of the units the maps are bound to for shading; must match
+    // the sampler bindings in the scene and deferred lighting shaders
+    static const GLint FIRST_TEXTURE_UNIT = 25;
+    // Must match the binding of ShadowBlock in the shaders
+    static const GLuint SHADOW_BLOCK_BINDING = 4;
+    static const int MAP_SIZE = 2048;
+    static constexpr float MAX_FIELD_OF_VIEW = 120.0f;  // degrees
+
+    ShadowMapper();
+    ~ShadowMapper();
+
+    // Compiles and links the depth pass shaders
+    bool LoadShaders(const std::string& vertexPath, const std::string& fragmentPath);
+    bool IsReady() const { return m_program != 0; }
+
+    // With shadows off, the shaders see no shadow maps
+    void SetEnabled(bool enabled) { m_enabled = enabled; }
+    bool IsEnabled() const { return m_enabled; }
+
+    // Static geometry inside the sphere changed; stales the static map of
+    // every light that can see it
+    void InvalidateRegion(const glm::vec3& center, float radius);
+    void InvalidateAll();
+
+    // Aims the view of every light whose static map is stale at `receivers`,
+    // the geometry the maps are fitted to; a different box than last time
+    // stales every static map. Called before Update() each frame.
+    void FitViews(const LightManager& lights, const AABB& receivers);
+
+    // Box around the views of the shadowed lights, where an object has to
+    // be to cast into a map; false if no light has a map
+    bool CasterBounds(AABB& bounds) const;
+
+    // Renders the stale static maps, from the batches and the unbatched
+    // `staticCasters`, and this frame's moving `casters`, then binds the
+    // maps and the ShadowBlock for shading. Restores the framebuffer and
+    // viewport; the caller restores its program.
+    void Update(const LightManager& lights, const StaticBatcher& batches,
+                const std::vector<ShadowCaster>& staticCasters,
+                const std::vector<ShadowCaster>& casters, MeshLibrary& meshes);
+
+    // Binds a ShadowBlock without shadowed lights, for frames drawn
+    // without the maps; the maps stay cached
+    void BindNone();
+
+    // Static maps rendered and moving casters drawn by the last Update()
+    uint32_t StaticRenders() const { return m_staticRenders; }
+    uint32_t DynamicCasters() const { return m_dynamicCasters; }
+
+    // Deletes the maps, the buffer and the program
+    void Destroy();
+
+private:
+    struct ShadowMap {
+        GLuint staticMap = 0;
+        GLuint liveMap = 0;
+        GLuint staticFramebuffer = 0;
+        GLuint liveFramebuffer = 0;
+        glm::mat4 viewProjection = glm::mat4(1.0f);
+        glm::vec4 planes[6];            // frustum planes, inward facing
+        AABB bounds;                    // box around the frustum
+        glm::vec3 lightPosition = glm::vec3(0.0f);
+        bool valid = false;             // static map matches the light and scene
+    };
+
+    bool CreateMaps();
+    void FitView(ShadowMap& map, const glm::vec3& lightPosition, const AABB& receivers) const;
+    bool SphereInView(const ShadowMap& map, const glm::vec3& center, float radius) const;
+    void RenderStatic(ShadowMap& map, const StaticBatcher& batches,
+                      const std::vector<ShadowCaster>& staticCasters, MeshLibrary& meshes);
+    void GatherCasters(const ShadowMap& map, const std::vector<ShadowCaster>& casters,
+                       const std::vector<uint32_t>& order);
+    void DrawCasters(MeshLibrary& meshes);
+    static void SortByMesh(const std::vector<ShadowCaster>& casters, std::vector<uint32_t>& order);
+    void WriteBlock(ShadowStd140& block);
+
+    GLuint m_program;
+    GLint m_viewProjectionLocation;
+    GLint m_instancingLocation;
+    GLuint m_shadowBuffer;
+    ShadowMap m_maps[MAX_SHADOWED_LIGHTS];
+    AABB m_receivers;
+    bool m_enabled;
+    int m_shadowCount;                          // lights with a map, set by FitViews()
+
+    std::vector<uint32_t> m_casterOrder;        // casters sorted by mesh
+    std::vector<uint32_t> m_staticOrder;        // static casters sorted by mesh
+    std::vector<InstanceData> m_instances;
+    GLsizei m_meshInstances[MESH_COUNT];
+    uint32_t m_staticRenders;
+    uint32_t m_dynamicCasters;
+};
@@ -0,0 +1,407 @@
+/***********************************************************
+ *
+ *  StaticBatcher.cpp
+ *	============
+ *  immovable objects baked into shared vertex/index buffers
+ *
+ ***********************************************************/
+
+#include "StaticBatcher.h"
+#include "BindingCache.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstddef>
+#include <unordered_map>
+#include <utility>
+
+
+namespace
+{
+    // Vertex attribute locations shared with vertexShader.glsl
+    const GLuint ATTRIB_POSITION = 0;
+    const GLuint ATTRIB_NORMAL = 1;
+    const GLuint ATTRIB_UV = 2;
+
+    // the three cell coordinates in 21 bits each
+    uint64_t PackCell(const StaticBatchKey& key) {
+        const uint64_t mask = (1u << 21) - 1;
+        return (static_cast<uint64_t>(key.cellX) & mask) |
+            ((static_cast<uint64_t>(key.cellY) & mask) << 21) |
+            ((static_cast<uint64_t>(key.cellZ) & mask) << 42);
+    }
+
+    // the CELL_SIZE cube the member's position falls in
+    void SetCell(StaticBatchMember& member) {
+        member.key.cellX = static_cast<int>(std::floor(member.position.x / StaticBatcher::CELL_SIZE));
+        member.key.cellY = static_cast<int>(std::floor(member.position.y / StaticBatcher::CELL_SIZE));
+        member.key.cellZ = static_cast<int>(std::floor(member.position.z / StaticBatcher::CELL_SIZE));
+    }
+}
+
+
+const float StaticBatcher::CELL_SIZE = 64.0f;
+
+
+bool StaticBatchKey::operator==(const StaticBatchKey& other) const {
+    return textureSlot == other.textureSlot && textureLayer == other.textureLayer &&
+        materialIndex == other.materialIndex &&
+        cellX == other.cellX && cellY == other.cellY && cellZ == other.cellZ &&
+        (textureSlot >= 0 || color == other.color);
+}
+
+
+BakeShapes BakeShapes::FromLibrary(const MeshLibrary& meshes) {
+    BakeShapes shapes;
+    shapes.vertices = meshes.GetVertices();
+    shapes.indices = meshes.GetIndices();
+    for (int mesh = 0; mesh < MESH_COUNT; ++mesh)
+        shapes.ranges[mesh] = meshes.GetRange(static_cast<MeshType>(mesh));
+    return shapes;
+}
+
+
+StaticBatcher::StaticBatcher() : m_bindings(nullptr), m_uploadNext(0) {
+}
+
+StaticBatcher::~StaticBatcher() {
+    Destroy();
+}
+
+
+// --- Enhancement: Group the static objects by draw state and cell ---
+void StaticBatcher::Assign(const std::vector<StaticBatchMember>& members, const BakeShapes& shapes) {
+    std::vector<Batch> oldBatches;
+    oldBatches.swap(m_batches);
+    std::vector<StaticBatchMember> oldMembers;
+    oldMembers.swap(m_members);
+
+    uint32_t slotCount = 0;
+    for (const StaticBatchMember& member : members)
+        slotCount = std::max(slotCount, member.slot + 1);
+    m_batchOf.assign(slotCount, -1);
+    m_members.resize(slotCount);
+    m_cellBatches.clear();
+    for (int mesh = 0; mesh < MESH_COUNT; ++mesh)
+        m_ranges[mesh] = shapes.ranges[mesh];
+
+    for (const StaticBatchMember& given : members) {
+        if (m_batchOf[given.slot] >= 0) continue;
+        if (static_cast<size_t>(m_ranges[given.mesh].vertexCount) > MAX_MEMBER_VERTICES) continue;
+
+        StaticBatchMember member = given;
+        SetCell(member);
+        Insert(member);
+    }
+
+    // an unchanged batch takes over its old geometry instead of being baked
+    // again; the one to compare with is the old batch of its first member
+    std::unordered_map<uint32_t, size_t> oldByFirstMember;
+    for (size_t i = 0; i < oldBatches.size(); ++i) {
+        if (!oldBatches[i].members.empty())
+            oldByFirstMember.emplace(oldBatches[i].members.front(), i);
+    }
+    for (Batch& batch : m_batches) {
+        auto found = oldByFirstMember.find(batch.members.front());
+        if (found == oldByFirstMember.end()) continue;
+        Batch& old = oldBatches[found->second];
+        if ((!old.vao && !old.pending) || !(old.key == batch.key) || old.members != batch.members) continue;
+
+        bool sameShapes = true;
+        for (uint32_t slot : batch.members) {
+            const StaticBatchMember& before = oldMembers[slot];
+            const StaticBatchMember& after = m_members[slot];
+            if (before.mesh != after.mesh || before.uvScale != after.uvScale) {
+                sameShapes = false;
+                break;
+            }
+        }
+        if (!sameShapes) continue;
+
+        batch.bounds = old.bounds;
+        batch.vao = old.vao;
+        batch.vertexBuffer = old.vertexBuffer;
+        batch.indexBuffer = old.indexBuffer;
+        batch.indexCount = old.indexCount;
+        batch.dirty = old.dirty;
+        batch.bakedVertices.swap(old.bakedVertices);
+        batch.bakedIndices.swap(old.bakedIndices);
+        batch.pending = old.pending;
+        old.vao = old.vertexBuffer = old.indexBuffer = 0;
+    }
+
+    for (Batch& old : oldBatches)
+        DestroyBuffers(old);
+    // batch indices changed
+    m_uploadQueue.clear();
+}
+
+
+// --- Enhancement: Add a member to the first batch of its state and cell with room ---
+// A cell only holds a handful of draw states, so its batches are searched
+// linearly; the vertex and index totals enforce the caps.
+void StaticBatcher::Insert(const StaticBatchMember& member) {
+    const MeshRange& range = m_ranges[member.mesh];
+    const size_t vertexCount = static_cast<size_t>(range.vertexCount);
+    const size_t indexCount = static_cast<size_t>(range.indexCount);
+
+    std::vector<uint32_t>& inCell = m_cellBatches[PackCell(member.key)];
+    size_t batch = m_batches.size();
+    for (uint32_t candidate : inCell) {
+        const Batch& existing = m_batches[candidate];
+        if (!(existing.key == member.key)) continue;
+        if (existing.vertexTotal + vertexCount > MAX_BATCH_VERTICES ||
+            existing.indexTotal + indexCount > MAX_BATCH_INDICES) continue;
+        batch = candidate;
+        break;
+    }
+    if (batch == m_batches.size()) {
+        m_batches.emplace_back();
+        m_batches[batch].key = member.key;
+        inCell.push_back(static_cast<uint32_t>(batch));
+    }
+
+    Batch& target = m_batches[batch];
+    target.members.push_back(member.slot);
+    target.vertexTotal += vertexCount;
+    target.indexTotal += indexCount;
+    target.dirty = true;
+
+    if (member.slot >= m_batchOf.size()) {
+        m_batchOf.resize(member.slot + 1, -1);
+        m_members.resize(member.slot + 1);
+    }
+    m_batchOf[member.slot] = static_cast<int>(batch);
+    m_members[member.slot] = member;
+}
+
+
+// --- Enhancement: Add or regroup one member without touching the others ---
+bool StaticBatcher::PlaceMember(const StaticBatchMember& given, const BakeShapes& shapes) {
+    for (int mesh = 0; mesh < MESH_COUNT; ++mesh)
+        m_ranges[mesh] = shapes.ranges[mesh];
+    if (static_cast<size_t>(m_ranges[given.mesh].vertexCount) > MAX_MEMBER_VERTICES) {
+        RemoveMember(given.slot);
+        return false;
+    }
+
+    StaticBatchMember member = given;
+    SetCell(member);
+    int batch = BatchOf(member.slot);
+    if (batch >= 0) {
+        // same batch: only the UV scale or position can differ
+        if (m_batches[batch].key == member.key && m_members[member.slot].mesh == member.mesh) {
+            m_members[member.slot] = member;
+            m_batches[batch].dirty = true;
+            return true;
+        }
+        RemoveMember(member.slot);
+    }
+    Insert(member);
+    return true;
+}
+
+
+void StaticBatcher::MoveMember(uint32_t slot, const glm::vec3& position) {
+    int batch = BatchOf(slot);
+    if (batch < 0) return;
+
+    StaticBatchMember member = m_members[slot];
+    member.position = position;
+    SetCell(member);
+    if (member.key == m_batches[batch].key) {
+        m_members[slot] = member;
+        m_batches[batch].dirty = true;
+        return;
+    }
+
+    // baked into its old cell, its batch's bounds would span both
+    RemoveMember(slot);
+    Insert(member);
+}
+
+
+void StaticBatcher::RemoveMember(uint32_t slot) {
+    int batch = BatchOf(slot);
+    if (batch < 0) return;
+
+    std::vector<uint32_t>& members = m_batches[batch].members;
+    for (size_t i = 0; i < members.size(); ++i) {
+        if (members[i] != slot) continue;
+        members.erase(members.begin() + i);
+        break;
+    }
+    const MeshRange& range = m_ranges[m_members[slot].mesh];
+    m_batches[batch].vertexTotal -= static_cast<size_t>(range.vertexCount);
+    m_batches[batch].indexTotal -= static_cast<size_t>(range.indexCount);
+    m_batches[batch].dirty = true;
+    m_batchOf[slot] = -1;
+}
+
+
+// --- Enhancement: Transform the members' vertices into world space ---
+size_t StaticBatcher::Bake(const BakeShapes& shapes,
+                           const std::vector<glm::mat4>& worldMatrices,
+                           const std::vector<glm::mat3>& normalMatrices) {
+    size_t baked = 0;
+
+    for (Batch& batch : m_batches) {
+        if (!batch.dirty) continue;
+        batch.dirty = false;
+        batch.pending = true;
+        ++baked;
+
+        std::vector<MeshVertex>& vertices = batch.bakedVertices;
+        std::vector<GLuint>& indices = batch.bakedIndices;
+        vertices.clear();
+        indices.clear();
+        batch.bounds.min = glm::vec3(FLT_MAX);
+        batch.bounds.max = glm::vec3(-FLT_MAX);
+
+        for (uint32_t slot : batch.members) {
+            if (slot >= worldMatrices.size()) continue;
+            const StaticBatchMember& member = m_members[slot];
+            const MeshRange& range = shapes.ranges[member.mesh];
+            const glm::mat4& world = worldMatrices[slot];
+            const glm::mat3& normalMatrix = normalMatrices[slot];
+
+            GLuint base = static_cast<GLuint>(vertices.size());
+            for (GLsizei v = 0; v < range.vertexCount; ++v) {
+                const MeshVertex& source = shapes.vertices[range.baseVertex + v];
+                MeshVertex bakedVertex;
+                bakedVertex.position = glm::vec3(world * glm::vec4(source.position, 1.0f));
+                bakedVertex.normal = glm::normalize(normalMatrix * source.normal);
+                bakedVertex.uv = source.uv * member.uvScale;
+                batch.bounds.min = glm::min(batch.bounds.min, bakedVertex.position);
+                batch.bounds.max = glm::max(batch.bounds.max, bakedVertex.position);
+                vertices.push_back(bakedVertex);
+            }
+            for (GLsizei i = 0; i < range.indexCount; ++i)
+                indices.push_back(base + shapes.indices[range.firstIndex + i]);
+        }
+
+        if (indices.empty())
+            batch.bounds.min = batch.bounds.max = glm::vec3(0.0f);
+    }
+    if (baked > 0) m_uploadQueue.clear();
+    return baked;
+}
+
+
+// --- Enhancement: Copy baked batches to the GPU, nearest first, within a budget ---
+size_t StaticBatcher::Upload(size_t byteBudget, const glm::vec3& focus, std::vector<AABB>* uploadedBounds) {
+    if (m_uploadNext >= m_uploadQueue.size()) {
+        m_uploadQueue.clear();
+        m_uploadNext = 0;
+        for (uint32_t i = 0; i < m_batches.size(); ++i)
+            if (m_batches[i].pending) m_uploadQueue.push_back(i);
+        if (m_uploadQueue.empty()) return 0;
+
+        std::vector<float> distance(m_batches.size(), 0.0f);
+        for (uint32_t i : m_uploadQueue) {
+            glm::vec3 offset = (m_batches[i].bounds.min + m_batches[i].bounds.max) * 0.5f - focus;
+            distance[i] = glm::dot(offset, offset);
+        }
+        std::sort(m_uploadQueue.begin(), m_uploadQueue.end(),
+                  [&](uint32_t a, uint32_t b) { return distance[a] < distance[b]; });
+    }
+
+    size_t uploaded = 0;
+    size_t spent = 0;
+    while (m_uploadNext < m_uploadQueue.size() && (uploaded == 0 || spent < byteBudget)) {
+        Batch& batch = m_batches[m_uploadQueue[m_uploadNext++]];
+        if (!batch.pending) continue;
+        spent += batch.bakedVertices.size() * sizeof(MeshVertex) + batch.bakedIndices.size() * sizeof(GLuint);
+        UploadBatch(batch);
+        if (uploadedBounds) uploadedBounds->push_back(batch.bounds);
+        ++uploaded;
+    }
+
+    if (uploaded > 0) {
+        BindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+    return uploaded;
+}
+
+
+void StaticBatcher::UploadBatch(Batch& batch) {
+    batch.pending = false;
+    batch.indexCount = static_cast<GLsizei>(batch.bakedIndices.size());
+
+    if (!batch.bakedIndices.empty()) {
+        if (!batch.vao) {
+            glGenVertexArrays(1, &batch.vao);
+            glGenBuffers(1, &batch.vertexBuffer);
+            glGenBuffers(1, &batch.indexBuffer);
+        }
+        BindVertexArray(batch.vao);
+
+        glBindBuffer(GL_ARRAY_BUFFER, batch.vertexBuffer);
+        glBufferData(GL_ARRAY_BUFFER, batch.bakedVertices.size() * sizeof(MeshVertex),
+                     batch.bakedVertices.data(), GL_STATIC_DRAW);
+        glEnableVertexAttribArray(ATTRIB_POSITION);
+        glVertexAttribPointer(ATTRIB_POSITION, 3, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (void*)offsetof(MeshVertex, position));
+        glEnableVertexAttribArray(ATTRIB_NORMAL);
+        glVertexAttribPointer(ATTRIB_NORMAL, 3, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (void*)offsetof(MeshVertex, normal));
+        glEnableVertexAttribArray(ATTRIB_UV);
+        glVertexAttribPointer(ATTRIB_UV, 2, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (void*)offsetof(MeshVertex, uv));
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, batch.indexBuffer);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, batch.bakedIndices.size() * sizeof(GLuint),
+                     batch.bakedIndices.data(), GL_STATIC_DRAW);
+    }
+
+    // the GPU has its copy now
+    std::vector<MeshVertex>().swap(batch.bakedVertices);
+    std::vector<GLuint>().swap(batch.bakedIndices);
+}
+
+
+void StaticBatcher::Swap(StaticBatcher& other) {
+    m_batches.swap(other.m_batches);
+    m_batchOf.swap(other.m_batchOf);
+    m_members.swap(other.m_members);
+    m_cellBatches.swap(other.m_cellBatches);
+    std::swap(m_ranges, other.m_ranges);
+    m_uploadQueue.clear();
+    other.m_uploadQueue.clear();
+}
+
+
+// --- Enhancement: Every member of a batch in one draw call ---
+void StaticBatcher::Draw(size_t batch) const {
+    const Batch& b = m_batches[batch];
+    if (!b.IsDrawable()) return;
+
+    BindVertexArray(b.vao);
+    glDrawElements(GL_TRIANGLES, b.indexCount, GL_UNSIGNED_INT, (void*)0);
+}
+
+
+void StaticBatcher::Destroy() {
+    for (Batch& batch : m_batches)
+        DestroyBuffers(batch);
+    m_batches.clear();
+    m_batchOf.clear();
+    m_members.clear();
+    m_cellBatches.clear();
+    m_uploadQueue.clear();
+}
+
+
+void StaticBatcher::DestroyBuffers(Batch& batch) {
+    if (!batch.vao) return;
+    glDeleteBuffers(1, &batch.indexBuffer);
+    glDeleteBuffers(1, &batch.vertexBuffer);
+    glDeleteVertexArrays(1, &batch.vao);
+    batch.vao = batch.vertexBuffer = batch.indexBuffer = 0;
+    // deleted names can be handed out again, so no binding of them may stay shadowed
+    if (m_bindings) m_bindings->Invalidate();
+}
+
+
+void StaticBatcher::BindVertexArray(GLuint vao) const {
+    if (m_bindings) m_bindings->BindVertexArray(vao);
+    else glBindVertexArray(vao);
+}
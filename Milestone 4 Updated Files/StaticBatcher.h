@@ -0,0 +1,191 @@
+/***********************************************************
+ *
+ *  StaticBatcher.h
+ *	============
+ *  immovable objects baked into shared vertex/index buffers
+ *
+ ***********************************************************/
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include "MeshLibrary.h"
+#include "Octree.h"
+
+class BindingCache;
+
+
+// --- Enhancement: Draw state shared by every object in a static batch ---
+// The cell keeps a batch local, so it can be culled; StaticBatcher fills
+// it in from the member's position.
+struct StaticBatchKey {
+    int textureSlot;        // -1 = untextured, drawn with color
+    int textureLayer;
+    int materialIndex;
+    glm::vec4 color;        // only compared for untextured objects
+    int cellX = 0;
+    int cellY = 0;
+    int cellZ = 0;
+
+    bool operator==(const StaticBatchKey& other) const;
+};
+
+
+// --- Enhancement: One static object handed to StaticBatcher ---
+// The UV scale is baked into the texture coordinates, so objects that
+// only differ in UV scale still share a batch.
+struct StaticBatchMember {
+    uint32_t slot;          // entity slot, indexes the world matrices
+    MeshType mesh;
+    glm::vec2 uvScale;
+    glm::vec3 position;     // world position, picks the cell
+    StaticBatchKey key;
+};
+
+
+// --- Enhancement: The shapes batches are baked from ---
+// MeshLibrary's CPU copy at full detail. A few hundred kilobytes, so a
+// loader thread can bake from a copy of its own instead of the library.
+struct BakeShapes {
+    std::vector<MeshVertex> vertices;
+    std::vector<GLuint> indices;
+    MeshRange ranges[MESH_COUNT];
+
+    static BakeShapes FromLibrary(const MeshLibrary& meshes);
+};
+
+
+/***********************************************************
+ *  StaticBatcher
+ *
+ *  Objects that never move are grouped by draw state and by
+ *  the CELL_SIZE cube their position falls in, and the
+ *  vertices of each group are transformed to world space once
+ *  and copied into one vertex and one index buffer. A batch is
+ *  then drawn with a single glDrawElements call, an identity
+ *  model matrix and no per-object uniforms. The cells keep a
+ *  batch's bounds small enough to cull in a large scene, and
+ *  a group past MAX_BATCH_VERTICES or MAX_BATCH_INDICES goes
+ *  on in another batch, so no buffer grows with the scene.
+ *  Meshes over MAX_MEMBER_VERTICES are not batched at all:
+ *  a baked copy per object would outweigh the draw call it
+ *  saves, and drawn on their own they keep their LODs. The
+ *  vertices come from MeshLibrary's CPU copy of the basic
+ *  shapes. A batch is only baked again when one of its
+ *  members is moved, removed or regrouped. A single object is
+ *  added, moved or taken out without regrouping the rest; one
+ *  that moves into another cell changes batch.
+ *
+ *  Baking and uploading are separate steps: Bake() only does
+ *  CPU work and can run on any thread that owns the batcher,
+ *  Upload() moves the baked geometry to the GPU and needs the
+ *  GL thread. A loaded scene arrives baked, and is swapped in
+ *  with Swap(); its batches then go to the GPU a budget at a
+ *  time, nearest first. A batch draws what was last uploaded
+ *  for it, and nothing before its first upload.
+ ***********************************************************/
+class StaticBatcher {
+public:
+    struct Batch {
+        StaticBatchKey key;
+        std::vector<uint32_t> members;  // entity slots, in the order given to Assign()
+        AABB bounds;                    // world space bounds of the baked vertices
+        GLuint vao = 0;
+        GLuint vertexBuffer = 0;
+        GLuint indexBuffer = 0;
+        GLsizei indexCount = 0;         // of the uploaded geometry
+        bool dirty = true;
+        // of the members' meshes, held under the batch caps
+        size_t vertexTotal = 0;
+        size_t indexTotal = 0;
+        // baked but not uploaded yet; emptied by Upload()
+        std::vector<MeshVertex> bakedVertices;
+        std::vector<GLuint> bakedIndices;
+        bool pending = false;
+
+        // Uploaded and not empty
+        bool IsDrawable() const { return vao != 0 && indexCount > 0; }
+    };
+
+    static const float CELL_SIZE;
+    static const size_t MAX_BATCH_VERTICES = 256 * 1024;
+    static const size_t MAX_BATCH_INDICES = 768 * 1024;
+    static const size_t MAX_MEMBER_VERTICES = 256;
+
+    StaticBatcher();
+    ~StaticBatcher();
+
+    // Routes the binds through `bindings`, like MeshLibrary; nullptr binds directly
+    void SetBindingCache(BindingCache* bindings) { m_bindings = bindings; }
+
+    // Regroups the static objects by draw state and cell; `shapes` gives
+    // the size of each member's mesh, and members with too large a mesh
+    // are left out. A batch whose state and members are unchanged keeps
+    // its baked geometry.
+    void Assign(const std::vector<StaticBatchMember>& members, const BakeShapes& shapes);
+
+    // Adds one static object to the first batch of its state and cell
+    // with room, or moves it there if its state, mesh or cell changed;
+    // returns false, leaving it unbatched, if its mesh is too large
+    bool PlaceMember(const StaticBatchMember& member, const BakeShapes& shapes);
+
+    // A batched entity moved to `position`: flags its batch for baking and,
+    // if it left its cell, moves it to a batch of the new cell
+    void MoveMember(uint32_t slot, const glm::vec3& position);
+
+    // Takes a removed entity out of its batch
+    void RemoveMember(uint32_t slot);
+
+    // Batch index of an entity slot, or -1 if it is drawn on its own
+    int BatchOf(uint32_t slot) const {
+        return slot < m_batchOf.size() ? m_batchOf[slot] : -1;
+    }
+
+    // Bakes every dirty batch from the current world and normal matrices,
+    // on the CPU only; returns the number of batches baked
+    size_t Bake(const BakeShapes& shapes,
+                const std::vector<glm::mat4>& worldMatrices,
+                const std::vector<glm::mat3>& normalMatrices);
+
+    // Copies batches baked since their last upload to the GPU, those
+    // nearest `focus` first, until `byteBudget` bytes are spent (at least
+    // one batch per call). The bounds of each batch uploaded are added to
+    // `uploadedBounds` if given; returns the number uploaded.
+    size_t Upload(size_t byteBudget = SIZE_MAX, const glm::vec3& focus = glm::vec3(0.0f),
+                  std::vector<AABB>* uploadedBounds = nullptr);
+
+    // Exchanges the batches with `other`; each keeps its binding cache
+    void Swap(StaticBatcher& other);
+
+    size_t BatchCount() const { return m_batches.size(); }
+    const Batch& GetBatch(size_t batch) const { return m_batches[batch]; }
+
+    // Binds the batch's VAO and draws it; the caller sets the draw state
+    void Draw(size_t batch) const;
+
+    // Deletes every batch and its GPU buffers
+    void Destroy();
+
+private:
+    void Insert(const StaticBatchMember& member);
+    void UploadBatch(Batch& batch);
+    void DestroyBuffers(Batch& batch);
+    void BindVertexArray(GLuint vao) const;
+
+    std::vector<Batch> m_batches;
+    std::vector<int> m_batchOf;                 // per entity slot, -1 = not batched
+    std::vector<StaticBatchMember> m_members;   // per entity slot, valid where m_batchOf >= 0
+    BindingCache* m_bindings;
+
+    // batches by packed cell, and the mesh sizes of the last shapes given
+    std::unordered_map<uint64_t, std::vector<uint32_t>> m_cellBatches;
+    MeshRange m_ranges[MESH_COUNT];
+
+    // pending batches by distance, built on the first Upload() after a change
+    std::vector<uint32_t> m_uploadQueue;
+    size_t m_uploadNext;
+};
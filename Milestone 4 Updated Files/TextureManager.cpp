@@ -0,0 +1,241 @@
+/***********************************************************
+ *  TextureManager Implementation
+ *
+ *  Implements all texture management logic, moved out of
+ *  SceneManager for better modularity and code reuse.
+ ***********************************************************/
+
+#include "TextureManager.h"
+#include "stb_image.h"
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <utility>
+
+
+namespace
+{
+    // Rounds up to a power of two, capped at maxValue, so differently sized
+    // images of roughly the same size end up in the same array without
+    // losing resolution below the cap
+    int CeilPowerOfTwo(int value, int maxValue) {
+        int power = 1;
+        while (power < value && power * 2 <= maxValue) power <<= 1;
+        return power;
+    }
+
+    // Bilinear resample of an RGBA8 image
+    void ResampleRGBA8(const unsigned char* src, int srcWidth, int srcHeight,
+                       unsigned char* dst, int dstWidth, int dstHeight) {
+        for (int y = 0; y < dstHeight; ++y) {
+            float sy = (y + 0.5f) * srcHeight / dstHeight - 0.5f;
+            int y0 = std::max(0, std::min(srcHeight - 1, static_cast<int>(sy)));
+            int y1 = std::min(srcHeight - 1, y0 + 1);
+            float fy = std::max(0.0f, std::min(1.0f, sy - y0));
+
+            for (int x = 0; x < dstWidth; ++x) {
+                float sx = (x + 0.5f) * srcWidth / dstWidth - 0.5f;
+                int x0 = std::max(0, std::min(srcWidth - 1, static_cast<int>(sx)));
+                int x1 = std::min(srcWidth - 1, x0 + 1);
+                float fx = std::max(0.0f, std::min(1.0f, sx - x0));
+
+                for (int c = 0; c < 4; ++c) {
+                    float top = src[(y0 * srcWidth + x0) * 4 + c] * (1.0f - fx) + src[(y0 * srcWidth + x1) * 4 + c] * fx;
+                    float bottom = src[(y1 * srcWidth + x0) * 4 + c] * (1.0f - fx) + src[(y1 * srcWidth + x1) * 4 + c] * fx;
+                    dst[(y * dstWidth + x) * 4 + c] = static_cast<unsigned char>(top * (1.0f - fy) + bottom * fy + 0.5f);
+                }
+            }
+        }
+    }
+}
+
+
+TextureManager::TextureManager(Backend backend) : m_backend(backend) {}
+
+TextureManager::~TextureManager() {
+    DestroyTextures(); // Ensure all textures are cleaned up
+}
+
+bool TextureManager::LoadTexture(const char* filename, const std::string& tag) {
+    // Loads an image file and creates an OpenGL texture, storing it with the given tag
+    int width, height, colorChannels;
+    GLuint textureID;
+    stbi_set_flip_vertically_on_load(true);
+
+    // Enhancement: the array backend converts every image to RGBA8 so that
+    // all of them can share an array, and defers the upload to BindTextures()
+    if (m_backend == BACKEND_TEXTURE_ARRAY) {
+        unsigned char* image = stbi_load(filename, &width, &height, &colorChannels, 4);
+        if (!image) {
+            std::cout << "Could not load image: " << filename << std::endl;
+            return false;
+        }
+        PendingImage pending;
+        pending.textureIndex = m_textures.size();
+        pending.width = width;
+        pending.height = height;
+        pending.pixels.assign(image, image + static_cast<size_t>(width) * height * 4);
+        stbi_image_free(image);
+
+        m_pendingImages.push_back(std::move(pending));
+        m_textures.push_back({ tag, 0, -1, 0 }); // ID, array and layer are set when the array is built
+        return true;
+    }
+
+    unsigned char* image = stbi_load(filename, &width, &height, &colorChannels, 0);
+
+    if (image) {
+        glGenTextures(1, &textureID);
+        glBindTexture(GL_TEXTURE_2D, textureID);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        if (colorChannels == 3)
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
+        else if (colorChannels == 4)
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
+        else {
+            std::cout << "Unsupported channel count: " << colorChannels << std::endl;
+            stbi_image_free(image);
+            return false;
+        }
+
+        glGenerateMipmap(GL_TEXTURE_2D);
+        stbi_image_free(image);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        m_textures.push_back({ tag, textureID, -1, 0 }); // Store the texture info
+        return true;
+    }
+    std::cout << "Could not load image: " << filename << std::endl;
+    return false;
+}
+
+void TextureManager::BuildTextureArrays() {
+    // Packs every pending image into a GL_TEXTURE_2D_ARRAY. Images are grouped
+    // by their size rounded to a power of two and resampled when they do not
+    // match it; a group larger than the layer limit is split over several arrays.
+    GLint maxLayers = 256;
+    GLint maxSize = MAX_ARRAY_SIZE;
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+    maxSize = std::min(maxSize, static_cast<GLint>(MAX_ARRAY_SIZE));
+
+    std::map<std::pair<int, int>, std::vector<PendingImage*>> groups;
+    for (auto& pending : m_pendingImages) {
+        int width = CeilPowerOfTwo(pending.width, maxSize);
+        int height = CeilPowerOfTwo(pending.height, maxSize);
+        groups[{ width, height }].push_back(&pending);
+    }
+
+    std::vector<unsigned char> resampled;
+    for (auto& group : groups) {
+        int width = group.first.first;
+        int height = group.first.second;
+        const std::vector<PendingImage*>& images = group.second;
+
+        GLsizei levels = 1;
+        while ((std::max(width, height) >> levels) > 0) ++levels;
+
+        for (size_t first = 0; first < images.size(); first += maxLayers) {
+            GLsizei layers = static_cast<GLsizei>(std::min(images.size() - first, static_cast<size_t>(maxLayers)));
+
+            GLuint arrayID;
+            glGenTextures(1, &arrayID);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, arrayID);
+            glTexStorage3D(GL_TEXTURE_2D_ARRAY, levels, GL_RGBA8, width, height, layers);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+            int arrayIndex = static_cast<int>(m_arrays.size());
+            for (GLsizei layer = 0; layer < layers; ++layer) {
+                const PendingImage& image = *images[first + layer];
+                const unsigned char* pixels = image.pixels.data();
+                if (image.width != width || image.height != height) {
+                    resampled.resize(static_cast<size_t>(width) * height * 4);
+                    ResampleRGBA8(image.pixels.data(), image.width, image.height, resampled.data(), width, height);
+                    pixels = resampled.data();
+                }
+                glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+
+                TextureInfo& info = m_textures[image.textureIndex];
+                info.ID = arrayID;
+                info.arrayIndex = arrayIndex;
+                info.layer = layer;
+            }
+
+            glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+            m_arrays.push_back(arrayID);
+        }
+    }
+
+    m_pendingImages.clear();
+}
+
+void TextureManager::BindTextures() {
+    // Enhancement: the array backend binds each array to its own unit once;
+    // a draw then only has to select a layer
+    if (m_backend == BACKEND_TEXTURE_ARRAY) {
+        if (!m_pendingImages.empty()) BuildTextureArrays();
+        for (size_t i = 0; i < m_arrays.size(); ++i) {
+            glActiveTexture(GL_TEXTURE0 + i);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, m_arrays[i]);
+        }
+        return;
+    }
+
+    // Binds each loaded texture to its corresponding texture unit
+    for (size_t i = 0; i < m_textures.size(); ++i) {
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D, m_textures[i].ID);
+    }
+}
+
+void TextureManager::DestroyTextures() {
+    // Deletes all textures from OpenGL and clears the list
+    if (m_backend == BACKEND_TEXTURE_ARRAY) {
+        for (auto& arrayID : m_arrays) {
+            glDeleteTextures(1, &arrayID);
+        }
+        m_arrays.clear();
+        m_pendingImages.clear();
+        m_textures.clear();
+        return;
+    }
+
+    for (auto& tex : m_textures) {
+        glDeleteTextures(1, &tex.ID);
+    }
+    m_textures.clear();
+}
+
+int TextureManager::FindTextureID(const std::string& tag) const {
+    // Returns the OpenGL texture ID for the given tag, or -1 if not found
+    for (const auto& tex : m_textures) {
+        if (tex.tag == tag) return tex.ID;
+    }
+    return -1;
+}
+
+int TextureManager::FindTextureSlot(const std::string& tag) const {
+    // Returns the texture slot (unit) for the given tag, or -1 if not found.
+    // With the array backend the slot is the unit of the texture's array.
+    for (size_t i = 0; i < m_textures.size(); ++i) {
+        if (m_textures[i].tag == tag)
+            return m_backend == BACKEND_TEXTURE_ARRAY ? m_textures[i].arrayIndex : static_cast<int>(i);
+    }
+    return -1;
+}
+
+int TextureManager::FindTextureLayer(const std::string& tag) const {
+    // Returns the array layer for the given tag, or -1 if not found
+    for (const auto& tex : m_textures) {
+        if (tex.tag == tag) return tex.layer;
+    }
+    return -1;
+}
@@ -0,0 +1,90 @@
+/***********************************************************
+ *  TextureManager
+ *
+ *  This new class was added to modularize and centralize
+ *  all texture loading, binding, and management operations.
+ *  This replaces the previous approach where SceneManager
+ *  handled textures directly, improving modularity and
+ *  maintainability.
+ ***********************************************************/
+
+#pragma once
+#include <string>
+#include <vector>
+#include <GL/glew.h>
+
+
+class TextureManager {
+public:
+    // Enhancement: how loaded textures are handed to the shader
+    enum Backend {
+        BACKEND_TEXTURE_UNITS,  // one GL_TEXTURE_2D per texture unit
+        BACKEND_TEXTURE_ARRAY   // layers of shared GL_TEXTURE_2D_ARRAY objects
+    };
+
+    // Unit that no texture is bound to. The sampler of the backend that is
+    // not in use points here, since OpenGL rejects draws where samplers of
+    // different types share a unit.
+    static const GLint SPARE_TEXTURE_UNIT = 31;
+
+    // Largest layer size used by the array backend
+    static const int MAX_ARRAY_SIZE = 2048;
+
+    // Structure to store texture tag and OpenGL ID
+    struct TextureInfo {
+        std::string tag;
+        GLuint ID;
+        int arrayIndex; // array backend: index of the array (and its texture unit)
+        int layer;      // array backend: layer inside that array
+    };
+
+    TextureManager(Backend backend = BACKEND_TEXTURE_UNITS);   // Constructor
+    ~TextureManager();  // Destructor
+
+    // Loads a texture from file and associates it with a tag
+    bool LoadTexture(const char* filename, const std::string& tag);
+
+    // Binds all loaded textures to their respective texture units
+    void BindTextures();
+
+    // Deletes all loaded textures from OpenGL and clears the list
+    void DestroyTextures();
+
+    // Finds the OpenGL texture ID by tag
+    int FindTextureID(const std::string& tag) const;
+
+    // Finds the texture slot (unit) by tag
+    int FindTextureSlot(const std::string& tag) const;
+
+    // Finds the array layer by tag (always 0 for the texture unit backend)
+    int FindTextureLayer(const std::string& tag) const;
+
+    // Number of texture units BindTextures() binds textures to, from unit 0
+    int UnitCount() const {
+        return static_cast<int>(m_backend == BACKEND_TEXTURE_ARRAY ? m_arrays.size() : m_textures.size());
+    }
+
+    Backend GetBackend() const { return m_backend; }
+    bool UsesTextureArrays() const { return m_backend == BACKEND_TEXTURE_ARRAY; }
+
+private:
+    // Image decoded by LoadTexture() and waiting to be packed into an array
+    struct PendingImage {
+        size_t textureIndex;
+        int width;
+        int height;
+        std::vector<unsigned char> pixels; // RGBA8
+    };
+
+    // Groups pending images by layer size and uploads one array per group
+    void BuildTextureArrays();
+
+    Backend m_backend;
+
+    // Stores all loaded textures and their tags
+    std::vector<TextureInfo> m_textures;
+
+    // Array backend: array texture objects, bound to units 0..n-1
+    std::vector<GLuint> m_arrays;
+    std::vector<PendingImage> m_pendingImages;
+};
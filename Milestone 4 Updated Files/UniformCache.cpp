@@ -0,0 +1,121 @@
+/***********************************************************
+ *
+ *  UniformCache.cpp
+ *	============
+ *  resolve shader uniform locations once, set them by handle
+ *
+ ***********************************************************/
+
+#include "UniformCache.h"
+#include "CommandCapture.h"
+#include <cstring>
+
+
+namespace
+{
+    // Uniform names, in UniformHandle order
+    const char* g_UniformNames[U_COUNT] = {
+        "model",
+        "normalMatrix",
+        "objectColor",
+        "objectTexture",
+        "bUseTexture",
+        "bUseLighting",
+        "bUseInstancing",
+        "UVscale",
+        "materialIndex",
+        "bUseTextureArray",
+        "objectTextureArray",
+        "textureLayer",
+        "bUseIndirect",
+        "bDepthOnly",
+        "bWriteGBuffer"
+    };
+}
+
+
+UniformCache::UniformCache() : m_program(0), m_shadowing(true), m_issued(0), m_skipped(0), m_capture(nullptr) {
+    for (int i = 0; i < U_COUNT; ++i) m_locations[i] = -1;
+    Invalidate();
+}
+
+
+// --- Enhancement: The only place uniform names are looked up ---
+bool UniformCache::Resolve(GLuint program) {
+    m_program = program;
+    if (program == 0) return false;
+
+    for (int i = 0; i < U_COUNT; ++i)
+        m_locations[i] = glGetUniformLocation(program, g_UniformNames[i]);
+    Invalidate();
+    return true;
+}
+
+
+void UniformCache::Invalidate() {
+    for (int i = 0; i < U_COUNT; ++i) m_shadowValid[i] = false;
+}
+
+
+// --- Enhancement: Compare against the last value sent, then remember the new one ---
+bool UniformCache::Update(UniformHandle handle, const void* value, size_t size) {
+    if (m_shadowing && m_shadowValid[handle] && memcmp(m_shadow[handle], value, size) == 0) {
+        ++m_skipped;
+        return false;
+    }
+    memcpy(m_shadow[handle], value, size);
+    m_shadowValid[handle] = m_shadowing;
+    ++m_issued;
+    return true;
+}
+
+
+void UniformCache::SetBool(UniformHandle handle, bool value) {
+    SetInt(handle, value ? 1 : 0);
+}
+
+void UniformCache::SetInt(UniformHandle handle, int value) {
+    if (!Update(handle, &value, sizeof(value))) return;
+    glUniform1i(m_locations[handle], value);
+    if (m_capture) m_capture->Uniform(handle, CAPTURE_INT, &value, sizeof(value));
+}
+
+void UniformCache::SetFloat(UniformHandle handle, float value) {
+    if (!Update(handle, &value, sizeof(value))) return;
+    glUniform1f(m_locations[handle], value);
+    if (m_capture) m_capture->Uniform(handle, CAPTURE_FLOAT, &value, sizeof(value));
+}
+
+void UniformCache::SetVec2(UniformHandle handle, const glm::vec2& value) {
+    if (!Update(handle, &value[0], sizeof(float) * 2)) return;
+    glUniform2f(m_locations[handle], value.x, value.y);
+    if (m_capture) m_capture->Uniform(handle, CAPTURE_VEC2, &value[0], sizeof(float) * 2);
+}
+
+void UniformCache::SetVec3(UniformHandle handle, const glm::vec3& value) {
+    if (!Update(handle, &value[0], sizeof(float) * 3)) return;
+    glUniform3f(m_locations[handle], value.x, value.y, value.z);
+    if (m_capture) m_capture->Uniform(handle, CAPTURE_VEC3, &value[0], sizeof(float) * 3);
+}
+
+void UniformCache::SetVec4(UniformHandle handle, const glm::vec4& value) {
+    if (!Update(handle, &value[0], sizeof(float) * 4)) return;
+    glUniform4f(m_locations[handle], value.x, value.y, value.z, value.w);
+    if (m_capture) m_capture->Uniform(handle, CAPTURE_VEC4, &value[0], sizeof(float) * 4);
+}
+
+void UniformCache::SetMat3(UniformHandle handle, const glm::mat3& value) {
+    if (!Update(handle, &value[0][0], sizeof(float) * 9)) return;
+    glUniformMatrix3fv(m_locations[handle], 1, GL_FALSE, &value[0][0]);
+    if (m_capture) m_capture->Uniform(handle, CAPTURE_MAT3, &value[0][0], sizeof(float) * 9);
+}
+
+void UniformCache::SetMat4(UniformHandle handle, const glm::mat4& value) {
+    if (!Update(handle, &value[0][0], sizeof(float) * 16)) return;
+    glUniformMatrix4fv(m_locations[handle], 1, GL_FALSE, &value[0][0]);
+    if (m_capture) m_capture->Uniform(handle, CAPTURE_MAT4, &value[0][0], sizeof(float) * 16);
+}
+
+const char* UniformCache::Name(UniformHandle handle) {
+    return g_UniformNames[handle];
+}
@@ -0,0 +1,106 @@
+/***********************************************************
+ *
+ *  UniformCache.h
+ *	============
+ *  resolve shader uniform locations once, set them by handle
+ *
+ ***********************************************************/
+
+#pragma once
+#include <cstdint>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+class CommandCapture;
+
+
+// --- Enhancement: Handles for every uniform the scene shaders use ---
+enum UniformHandle {
+    U_MODEL = 0,
+    U_NORMAL_MATRIX,
+    U_OBJECT_COLOR,
+    U_OBJECT_TEXTURE,
+    U_USE_TEXTURE,
+    U_USE_LIGHTING,
+    U_USE_INSTANCING,
+    U_UV_SCALE,
+    U_MATERIAL_INDEX,
+    U_USE_TEXTURE_ARRAY,
+    U_OBJECT_TEXTURE_ARRAY,
+    U_TEXTURE_LAYER,
+    U_USE_INDIRECT,
+    U_DEPTH_ONLY,
+    U_WRITE_GBUFFER,
+    U_COUNT
+};
+
+
+/***********************************************************
+ *  UniformCache
+ *
+ *  ShaderManager looks a uniform up by name on every set
+ *  call. This class looks every scene uniform up once, right
+ *  after the program is linked, and then sets values by
+ *  integer handle. Handles whose uniform is missing from the
+ *  program resolve to -1, which OpenGL silently ignores.
+ *
+ *  Every value sent is also shadowed, and a set call whose
+ *  value matches the shadow is dropped before it reaches
+ *  OpenGL. The shadow is only valid while nothing else sets
+ *  these uniforms; call Invalidate() after code that does
+ *  (e.g. ShaderManager's name-based setters).
+ ***********************************************************/
+class UniformCache {
+public:
+    UniformCache();
+
+    // Looks up every known uniform in the given linked program
+    bool Resolve(GLuint program);
+
+    GLuint Program() const { return m_program; }
+    GLint Location(UniformHandle handle) const { return m_locations[handle]; }
+
+    // Setters for the currently bound program, by handle
+    void SetBool(UniformHandle handle, bool value);
+    void SetInt(UniformHandle handle, int value);
+    void SetFloat(UniformHandle handle, float value);
+    void SetVec2(UniformHandle handle, const glm::vec2& value);
+    void SetVec3(UniformHandle handle, const glm::vec3& value);
+    void SetVec4(UniformHandle handle, const glm::vec4& value);
+    void SetMat3(UniformHandle handle, const glm::mat3& value);
+    void SetMat4(UniformHandle handle, const glm::mat4& value);
+
+    // --- Enhancement: Redundant-set elimination ---
+    // Forgets every shadowed value, so the next set of each uniform is sent
+    void Invalidate();
+    // With shadowing off every set call is sent (for benchmarks)
+    void SetShadowing(bool enabled) { m_shadowing = enabled; Invalidate(); }
+
+    // Set calls sent to OpenGL / dropped as redundant since the last reset
+    uint32_t IssuedCount() const { return m_issued; }
+    uint32_t SkippedCount() const { return m_skipped; }
+    void ResetCounters() { m_issued = m_skipped = 0; }
+
+    // Name used to resolve a handle, for logging
+    static const char* Name(UniformHandle handle);
+
+    // --- Enhancement: Command capture ---
+    // Every set call sent to OpenGL is also recorded into `capture`; nullptr stops it
+    void SetCapture(CommandCapture* capture) { m_capture = capture; }
+
+private:
+    // Records `value` as the uniform's shadow; false if it was already
+    // the shadowed value and the set call can be dropped
+    bool Update(UniformHandle handle, const void* value, size_t size);
+
+    GLuint m_program;
+    GLint m_locations[U_COUNT];
+
+    // last value sent for each uniform, large enough for a mat4
+    float m_shadow[U_COUNT][16];
+    bool m_shadowValid[U_COUNT];
+    bool m_shadowing;
+    uint32_t m_issued;
+    uint32_t m_skipped;
+    CommandCapture* m_capture;
+};
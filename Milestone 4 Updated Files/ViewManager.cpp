@@ -25,8 +25,6 @@ namespace
 	// Variables for window width and height
 	const int WINDOW_WIDTH = 1000;
 	const int WINDOW_HEIGHT = 800;
-	const char* g_ViewName = "view";
-	const char* g_ProjectionName = "projection";
 
 	// these variables are used for mouse movement processing
 	float gLastX = WINDOW_WIDTH / 2.0f;
@@ -277,14 +275,55 @@ void ViewManager::PrepareSceneView()
 	// define the current projection matrix
 	projection = glm::perspective(glm::radians(g_pCamera->Zoom), (GLfloat)WINDOW_WIDTH / (GLfloat)WINDOW_HEIGHT, 0.1f, 100.0f);
 
-	// if the shader manager object is valid
-	if (NULL != m_pShaderManager)
+	// Enhancement: the view, projection and view position are no longer
+	// set as uniforms here; SceneManager writes them into its per-frame
+	// ring buffer, so they are only kept for GetViewMatrix() and friends
+	m_viewMatrix = view;
+	m_projectionMatrix = projection;
+	m_viewPosition = g_pCamera->Position;
+}
+
+/***********************************************************
+ *						*** ENHANCEMENT ***
+ *
+ *  SetCamera()
+ *
+ *  This method is used for placing the camera directly, as
+ *  a scripted camera path does in headless runs.
+ ***********************************************************/
+void ViewManager::SetCamera(const glm::vec3& position, const glm::vec3& front,
+	const glm::vec3& up, float zoom)
+{
+	if (NULL == g_pCamera)
 	{
-		// set the view matrix into the shader for proper rendering
-		m_pShaderManager->setMat4Value(g_ViewName, view);
-		// set the view matrix into the shader for proper rendering
-		m_pShaderManager->setMat4Value(g_ProjectionName, projection);
-		// set the view position of the camera into the shader for proper rendering
-		m_pShaderManager->setVec3Value("viewPosition", g_pCamera->Position);
+		return;
 	}
+
+	g_pCamera->Position = position;
+	g_pCamera->Front = front;
+	g_pCamera->Up = up;
+	g_pCamera->Zoom = zoom;
+}
+
+const Camera* ViewManager::GetCamera() const
+{
+	return g_pCamera;
+}
+
+/***********************************************************
+ *						*** ENHANCEMENT ***
+ *
+ *  PrepareOffscreenView()
+ *
+ *  This method is used for computing the view state like
+ *  PrepareSceneView(), but without a window: no keyboard
+ *  events are processed and the aspect ratio is that of the
+ *  offscreen target being rendered to.
+ ***********************************************************/
+void ViewManager::PrepareOffscreenView(int width, int height)
+{
+	m_viewMatrix = g_pCamera->GetViewMatrix();
+	m_projectionMatrix = glm::perspective(glm::radians(g_pCamera->Zoom),
+		(GLfloat)width / (GLfloat)height, 0.1f, 100.0f);
+	m_viewPosition = g_pCamera->Position;
 }
\ No newline at end of file
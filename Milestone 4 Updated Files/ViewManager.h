@@ -36,10 +36,27 @@ private:
 	// process keyboard events for interaction with the 3D scene
 	void ProcessKeyboardEvents();
 
+	// Enhancement: view state computed by the last PrepareSceneView call
+	glm::mat4 m_viewMatrix = glm::mat4(1.0f);
+	glm::mat4 m_projectionMatrix = glm::mat4(1.0f);
+	glm::vec3 m_viewPosition = glm::vec3(0.0f);
+
 public:
 	// create the initial OpenGL display window
 	GLFWwindow* CreateDisplayWindow(const char* windowTitle);
 
 	// prepare the conversion from 3D object display to 2D scene display
 	void PrepareSceneView();
+
+	// Enhancement: per-frame constants for SceneManager::SetFrameConstants()
+	const glm::mat4& GetViewMatrix() const { return m_viewMatrix; }
+	const glm::mat4& GetProjectionMatrix() const { return m_projectionMatrix; }
+	const glm::vec3& GetViewPosition() const { return m_viewPosition; }
+
+	// Enhancement: headless runs have no window or input; the camera
+	// is placed directly and the projection fits the offscreen target
+	void SetCamera(const glm::vec3& position, const glm::vec3& front,
+		const glm::vec3& up, float zoom);
+	const Camera* GetCamera() const;
+	void PrepareOffscreenView(int width, int height);
 };
@@ -0,0 +1,124 @@
+/***********************************************************
+ *
+ *  WorkerPool.cpp
+ *	============
+ *  fixed pool of worker threads for data-parallel frame work
+ *
+ ***********************************************************/
+
+#include "WorkerPool.h"
+#include "Profiler.h"
+#include <algorithm>
+
+
+WorkerPool::WorkerPool(unsigned threadCount)
+    : m_job(nullptr), m_count(0), m_chunkSize(0), m_chunkCount(0),
+      m_nextChunk(0), m_chunksDone(0),
+      m_generation(0), m_activeWorkers(0), m_stop(false) {
+    if (threadCount == AUTO_THREADS) {
+        unsigned hardwareThreads = std::thread::hardware_concurrency();
+        threadCount = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+    }
+    for (unsigned i = 0; i < threadCount; ++i)
+        m_threads.emplace_back(&WorkerPool::WorkerLoop, this);
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (auto& thread : m_threads)
+        thread.join();
+}
+
+
+size_t WorkerPool::ChunkCount(size_t count, size_t minChunkSize) const {
+    if (count == 0) return 0;
+    minChunkSize = std::max<size_t>(minChunkSize, 1);
+
+    // a few chunks per thread, so a slow chunk does not hold up the others
+    size_t chunks = std::min<size_t>(ThreadCount() * 4, (count + minChunkSize - 1) / minChunkSize);
+    chunks = std::max<size_t>(chunks, 1);
+
+    // rounding the chunk size up can leave trailing chunks empty; drop them
+    size_t chunkSize = (count + chunks - 1) / chunks;
+    return (count + chunkSize - 1) / chunkSize;
+}
+
+
+// --- Enhancement: Split a range over the pool and the calling thread ---
+void WorkerPool::ParallelFor(size_t count, size_t minChunkSize, const Job& job) {
+    size_t chunkCount = ChunkCount(count, minChunkSize);
+    if (chunkCount == 0) return;
+
+    size_t chunkSize = (count + chunkCount - 1) / chunkCount;
+    if (chunkCount == 1 || m_threads.empty()) {
+        for (size_t chunk = 0; chunk < chunkCount; ++chunk)
+            job(chunk, chunk * chunkSize, std::min(count, (chunk + 1) * chunkSize));
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_job = &job;
+        m_count = count;
+        m_chunkSize = chunkSize;
+        m_chunkCount = chunkCount;
+        m_nextChunk = 0;
+        m_chunksDone = 0;
+        ++m_generation;
+    }
+    m_wake.notify_all();
+
+    RunChunks();
+
+    // wait for the last chunk, and for every worker to leave the job, so
+    // that no worker can still be looking at it when the next one starts
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_finished.wait(lock, [this] { return m_chunksDone == m_chunkCount && m_activeWorkers == 0; });
+    m_job = nullptr;
+}
+
+
+void WorkerPool::RunChunks() {
+    for (;;) {
+        size_t chunk = m_nextChunk++;
+        if (chunk >= m_chunkCount) return;
+
+        {
+            PROFILE_SCOPE("WorkerPool chunk");
+            (*m_job)(chunk, chunk * m_chunkSize, std::min(m_count, (chunk + 1) * m_chunkSize));
+        }
+
+        if (++m_chunksDone == m_chunkCount) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_finished.notify_one();
+        }
+    }
+}
+
+
+void WorkerPool::WorkerLoop() {
+    PROFILE_THREAD_NAME("Worker");
+    unsigned seenGeneration = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&] { return m_stop || m_generation != seenGeneration; });
+            if (m_stop) return;
+            seenGeneration = m_generation;
+            if (!m_job) continue;
+            ++m_activeWorkers;
+        }
+
+        RunChunks();
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            --m_activeWorkers;
+        }
+        m_finished.notify_one();
+    }
+}
@@ -0,0 +1,77 @@
+/***********************************************************
+ *
+ *  WorkerPool.h
+ *	============
+ *  fixed pool of worker threads for data-parallel frame work
+ *
+ ***********************************************************/
+
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+/***********************************************************
+ *  WorkerPool
+ *
+ *  Threads are started once and sleep between jobs. A job
+ *  is a range [0, count) split into equal chunks; the pool
+ *  threads and the calling thread take chunks until none are
+ *  left, and ParallelFor() returns once every chunk is done.
+ *  Chunks are numbered, so a job can write one output list
+ *  per chunk and merge them in chunk order, which gives the
+ *  same result whichever thread ran which chunk. No OpenGL
+ *  calls may be made from a job.
+ ***********************************************************/
+class WorkerPool {
+public:
+    // (chunk index, first item, one past the last item)
+    typedef std::function<void(size_t, size_t, size_t)> Job;
+
+    // Pool size that starts one thread per hardware thread, minus the
+    // calling thread
+    static const unsigned AUTO_THREADS = ~0u;
+
+    // `threadCount` pool threads besides the calling thread; 0 runs every
+    // job on the calling thread
+    explicit WorkerPool(unsigned threadCount = AUTO_THREADS);
+    ~WorkerPool();
+
+    // Pool threads plus the calling thread
+    unsigned ThreadCount() const { return static_cast<unsigned>(m_threads.size()) + 1; }
+
+    // Number of chunks ParallelFor() will split `count` items into
+    size_t ChunkCount(size_t count, size_t minChunkSize) const;
+
+    // Runs `job` over [0, count) in chunks of at least `minChunkSize` items.
+    // Small ranges run on the calling thread without waking the pool.
+    void ParallelFor(size_t count, size_t minChunkSize, const Job& job);
+
+private:
+    void WorkerLoop();
+
+    // Takes and runs chunks of the current job until none are left
+    void RunChunks();
+
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_finished;
+
+    // current job, only changed while no worker is active
+    const Job* m_job;
+    size_t m_count;
+    size_t m_chunkSize;
+    size_t m_chunkCount;
+    std::atomic<size_t> m_nextChunk;
+    std::atomic<size_t> m_chunksDone;
+
+    unsigned m_generation;      // bumped for every job, wakes the workers
+    unsigned m_activeWorkers;   // workers still inside RunChunks()
+    bool m_stop;
+};
@@ -0,0 +1,172 @@
+/***********************************************************
+ *
+ *  deferredLightFragment.glsl
+ *	============
+ *  deferred lighting pass, new file for Utilities/shaders
+ *
+ ***********************************************************/
+
+#version 440 core
+
+// --- Enhancement: same material and light buffers as fragmentShader.glsl ---
+#define MAX_MATERIALS 64
+#define MAX_LIGHTS 128
+
+struct MaterialData {
+    vec4 ambientColorStrength;
+    vec4 diffuseColor;
+    vec4 specularColorShininess;
+};
+
+layout (std140, binding = 0) uniform MaterialBlock {
+    MaterialData materials[MAX_MATERIALS];
+};
+
+struct LightData {
+    vec4 positionFocal;
+    vec4 ambientColorRange;     // w = range, 0 = unlimited
+    vec4 diffuseColorIntensity;
+    vec4 specularColor;
+};
+
+layout (std140, binding = 1) uniform LightBlock {
+    ivec4 lightCount;
+    LightData lights[MAX_LIGHTS];
+};
+
+layout (std140, binding = 3) uniform FrameBlock {
+    mat4 view;
+    mat4 projection;
+    vec4 viewPosition;      // xyz = camera position
+};
+
+// --- Enhancement: same shadow maps as fragmentShader.glsl ---
+#define MAX_SHADOWED_LIGHTS 2
+
+layout (std140, binding = 4) uniform ShadowBlock {
+    mat4 shadowMatrix[MAX_SHADOWED_LIGHTS];
+    ivec4 shadowCount;
+    vec4 shadowParams;
+};
+
+layout (binding = 25) uniform sampler2DShadow shadowMaps[MAX_SHADOWED_LIGHTS];
+
+// --- Enhancement: the G-buffer, on the units DeferredRenderer binds it to ---
+layout (binding = 27) uniform sampler2D gBufferAlbedo;
+layout (binding = 28) uniform sampler2D gBufferNormal;
+layout (binding = 29) uniform isampler2D gBufferMaterial;
+layout (binding = 30) uniform sampler2D gBufferDepth;
+
+flat in int lightIndex;
+
+out vec4 outFragmentColor;
+
+// false: full-viewport pass of the unlit pixels and the lights without a range
+// true: one light volume, added to what is already there
+uniform bool bLightVolume = false;
+uniform mat4 inverseViewProjection;
+uniform vec2 viewportSize;
+
+vec3 CalcLight(int light, int material, vec3 normal, vec3 position, vec3 viewDirection);
+float LightShadow(int light, vec3 position, vec3 normal);
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    float depth = texelFetch(gBufferDepth, pixel, 0).r;
+    if (depth >= 1.0f)
+    {
+        // nothing was drawn here; the cleared background stays
+        discard;
+    }
+
+    vec4 albedo = texelFetch(gBufferAlbedo, pixel, 0);
+    int material = texelFetch(gBufferMaterial, pixel, 0).r;
+    if (material < 0)
+    {
+        if (bLightVolume)
+        {
+            discard;
+        }
+        outFragmentColor = albedo;
+        return;
+    }
+    material = min(material, MAX_MATERIALS - 1);
+
+    // world position from the depth buffer
+    vec3 ndc = vec3(gl_FragCoord.xy / viewportSize, depth) * 2.0f - 1.0f;
+    vec4 world = inverseViewProjection * vec4(ndc, 1.0f);
+    vec3 position = world.xyz / world.w;
+    vec3 normal = normalize(texelFetch(gBufferNormal, pixel, 0).xyz);
+    vec3 viewDirection = normalize(viewPosition.xyz - position);
+
+    vec3 phongResult = vec3(0.0f);
+    if (bLightVolume)
+    {
+        phongResult = CalcLight(lightIndex, material, normal, position, viewDirection);
+        outFragmentColor = vec4(phongResult * albedo.xyz, 0.0f);
+        return;
+    }
+
+    int totalLights = min(lightCount.x, MAX_LIGHTS);
+    for (int i = 0; i < totalLights; i++)
+    {
+        if (lights[i].ambientColorRange.w <= 0.0f)
+        {
+            phongResult += CalcLight(i, material, normal, position, viewDirection);
+        }
+    }
+    outFragmentColor = vec4(phongResult * albedo.xyz, albedo.w);
+}
+
+// --- Enhancement: CalcLightSource() and LightAttenuation() of fragmentShader.glsl ---
+vec3 CalcLight(int light, int material, vec3 normal, vec3 position, vec3 viewDirection)
+{
+    vec3 lightPosition = lights[light].positionFocal.xyz;
+    float range = lights[light].ambientColorRange.w;
+    float attenuation = 1.0f;
+    if (range > 0.0f)
+    {
+        vec3 toLight = lightPosition - position;
+        float fade = clamp(1.0f - dot(toLight, toLight) / (range * range), 0.0f, 1.0f);
+        attenuation = fade * fade;
+        if (attenuation <= 0.0f)
+        {
+            return vec3(0.0f);
+        }
+    }
+
+    vec3 ambient = lights[light].ambientColorRange.xyz *
+        materials[material].ambientColorStrength.xyz * materials[material].ambientColorStrength.w;
+
+    vec3 lightDirection = normalize(lightPosition - position);
+    float impact = max(dot(normal, lightDirection), 0.0f);
+    vec3 diffuse = impact * lights[light].diffuseColorIntensity.xyz * materials[material].diffuseColor.xyz;
+
+    vec3 reflectDir = reflect(-lightDirection, normal);
+    float specularComponent = pow(max(dot(viewDirection, reflectDir), 0.0f), lights[light].positionFocal.w);
+    vec3 specular = lights[light].diffuseColorIntensity.w * specularComponent *
+        lights[light].specularColor.xyz * materials[material].specularColorShininess.xyz;
+
+    return (ambient + (diffuse + specular) * LightShadow(light, position, normal)) * attenuation;
+}
+
+// --- Enhancement: LightShadow() of fragmentShader.glsl ---
+float LightShadow(int light, vec3 position, vec3 normal)
+{
+    if (light >= min(shadowCount.x, MAX_SHADOWED_LIGHTS))
+    {
+        return 1.0f;
+    }
+    vec4 coordinate = shadowMatrix[light] * vec4(position + normal * shadowParams.x, 1.0f);
+    if (coordinate.w <= 0.0f)
+    {
+        return 1.0f;
+    }
+    coordinate.xyz /= coordinate.w;
+    if (any(lessThan(coordinate.xyz, vec3(0.0f))) || any(greaterThan(coordinate.xyz, vec3(1.0f))))
+    {
+        return 1.0f;
+    }
+    return light == 0 ? texture(shadowMaps[0], coordinate.xyz) : texture(shadowMaps[1], coordinate.xyz);
+}
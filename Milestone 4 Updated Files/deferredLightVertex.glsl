@@ -0,0 +1,42 @@
+/***********************************************************
+ *
+ *  deferredLightVertex.glsl
+ *	============
+ *  deferred lighting pass, new file for Utilities/shaders
+ *
+ ***********************************************************/
+
+#version 440 core
+
+// --- Enhancement: light volumes are MeshLibrary spheres, drawn instanced ---
+// DeferredRenderer writes one instance per light with a range: the model
+// matrix places and scales the sphere, the material index slot holds the
+// light's index.
+layout (location = 0) in vec3 inVertexPosition;
+layout (location = 3) in mat4 inInstanceModel;
+layout (location = 11) in int inInstanceMaterialIndex;
+
+layout (std140, binding = 3) uniform FrameBlock {
+    mat4 view;
+    mat4 projection;
+    vec4 viewPosition;      // xyz = camera position
+};
+
+flat out int lightIndex;
+
+uniform bool bLightVolume = false;
+
+void main()
+{
+    if (bLightVolume)
+    {
+        gl_Position = projection * view * inInstanceModel * vec4(inVertexPosition, 1.0f);
+        lightIndex = inInstanceMaterialIndex;
+        return;
+    }
+
+    // one triangle that covers the viewport, no vertex buffer needed
+    vec2 corner = vec2(float((gl_VertexID << 1) & 2), float(gl_VertexID & 2));
+    gl_Position = vec4(corner * 2.0f - 1.0f, 0.0f, 1.0f);
+    lightIndex = -1;
+}
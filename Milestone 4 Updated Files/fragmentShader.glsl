@@ -0,0 +1,283 @@
+/***********************************************************
+ *
+ *  fragmentShader.glsl
+ *	============
+ *  updated copy of Utilities/shaders/fragmentShader.glsl
+ *
+ ***********************************************************/
+
+#version 440 core
+
+struct Material {
+    vec3 ambientColor;
+    float ambientStrength;
+    vec3 diffuseColor;
+    vec3 specularColor;
+    float shininess;
+};
+
+// --- Enhancement: every material lives in one std140 uniform buffer ---
+// Packed by MaterialManager::UploadMaterialBuffer(); a draw only selects
+// an entry with materialIndex (or the per-instance index when instanced).
+#define MAX_MATERIALS 64
+
+struct MaterialData {
+    vec4 ambientColorStrength;
+    vec4 diffuseColor;
+    vec4 specularColorShininess;
+};
+
+layout (std140, binding = 0) uniform MaterialBlock {
+    MaterialData materials[MAX_MATERIALS];
+};
+
+struct LightSource {
+    vec3 position;
+    vec3 ambientColor;
+    vec3 diffuseColor;
+    vec3 specularColor;
+    float focalStrength;
+    float specularIntensity;
+    float range;
+    float shadow;               // 0 = fully shadowed, 1 = lit
+};
+
+// --- Enhancement: lights live in a persistent std140 uniform buffer ---
+// Kept up to date by LightManager::UploadLightBuffer(), which only
+// re-uploads the lights that changed since the last frame.
+#define MAX_LIGHTS 128
+
+struct LightData {
+    vec4 positionFocal;
+    vec4 ambientColorRange;     // w = range, 0 = unlimited
+    vec4 diffuseColorIntensity;
+    vec4 specularColor;
+};
+
+layout (std140, binding = 1) uniform LightBlock {
+    ivec4 lightCount;
+    LightData lights[MAX_LIGHTS];
+};
+
+// --- Enhancement: per-frame constants ---
+// Written once per frame by SceneManager into its persistently mapped
+// ring buffer and bound with glBindBufferRange.
+layout (std140, binding = 3) uniform FrameBlock {
+    mat4 view;
+    mat4 projection;
+    vec4 viewPosition;      // xyz = camera position
+};
+
+// --- Enhancement: shadow maps of the first lights ---
+// Kept by ShadowMapper, which only re-renders a light's static depth
+// when that light or the static geometry it sees changed.
+#define MAX_SHADOWED_LIGHTS 2
+
+layout (std140, binding = 4) uniform ShadowBlock {
+    mat4 shadowMatrix[MAX_SHADOWED_LIGHTS];   // world space to shadow map coordinates
+    ivec4 shadowCount;                        // x = lights with a shadow map
+    vec4 shadowParams;                        // x = normal offset
+};
+
+layout (binding = 25) uniform sampler2DShadow shadowMaps[MAX_SHADOWED_LIGHTS];
+
+in vec3 fragmentPosition;
+in vec3 fragmentVertexNormal;
+in vec2 fragmentTextureCoordinate;
+flat in vec4 fragmentInstanceColor;
+flat in int fragmentMaterialIndex;
+flat in int fragmentTextureLayer;
+
+layout (location = 0) out vec4 outFragmentColor;
+
+// --- Enhancement: G-buffer outputs of the deferred path ---
+// Written instead of the lit color while bWriteGBuffer is set; location 0
+// then holds the albedo. DeferredRenderer attaches the matching textures.
+layout (location = 1) out vec4 outGBufferNormal;
+layout (location = 2) out int outGBufferMaterial;     // -1 = unlit
+uniform bool bWriteGBuffer = false;
+
+uniform bool bUseTexture = false;
+uniform bool bUseLighting = false;
+uniform bool bUseInstancing = false;
+uniform bool bUseIndirect = false;
+uniform vec4 objectColor = vec4(1.0f);
+uniform sampler2D objectTexture;
+uniform vec2 UVscale = vec2(1.0f, 1.0f);
+uniform int materialIndex = 0;
+
+// --- Enhancement: texture array backend of TextureManager ---
+// Textures are layers of a sampler2DArray; a draw selects one with
+// textureLayer (or the per-instance layer when instanced).
+uniform bool bUseTextureArray = false;
+uniform sampler2DArray objectTextureArray;
+uniform int textureLayer = 0;
+
+// --- Enhancement: depth pre-pass ---
+// Only depth is written while bDepthOnly is set (color writes are masked
+// off), so the lighting is skipped entirely.
+uniform bool bDepthOnly = false;
+
+// material of the current fragment, unpacked from the material buffer
+Material material;
+
+// function prototypes
+vec3 CalcLightSource(LightSource light, vec3 lightNormal, vec3 vertexPosition, vec3 viewDirection);
+float LightAttenuation(float range, float distance);
+float LightShadow(int light, vec3 position, vec3 normal);
+vec4 SampleObjectTexture(vec2 textureCoordinate);
+
+void main()
+{
+    if (bDepthOnly)
+    {
+        outFragmentColor = vec4(0.0f);
+        return;
+    }
+
+    // --- Enhancement: instanced and indirect draws carry their color per draw ---
+    bool bPerDrawData = bUseInstancing || bUseIndirect;
+    vec4 baseColor = bPerDrawData ? fragmentInstanceColor : objectColor;
+
+    // --- Enhancement: indirect draws mix textured and untextured objects ---
+    bool bTextured = bUseIndirect ? fragmentTextureLayer >= 0 : bUseTexture;
+
+    // --- Enhancement: look the material up by index ---
+    // -1 (no material) and out-of-range indices clamp to a real entry
+    int index = clamp(bPerDrawData ? fragmentMaterialIndex : materialIndex, 0, MAX_MATERIALS - 1);
+    material.ambientColor = materials[index].ambientColorStrength.xyz;
+    material.ambientStrength = materials[index].ambientColorStrength.w;
+    material.diffuseColor = materials[index].diffuseColor.xyz;
+    material.specularColor = materials[index].specularColorShininess.xyz;
+    material.shininess = materials[index].specularColorShininess.w;
+
+    // --- Enhancement: deferred path, store the surface and light it later ---
+    if (bWriteGBuffer)
+    {
+        vec4 albedo = baseColor;
+        if (bTextured == true)
+        {
+            vec4 textureColor = SampleObjectTexture(fragmentTextureCoordinate * UVscale);
+            albedo = bUseLighting ? vec4(textureColor.xyz, 1.0f) : textureColor;
+        }
+        outFragmentColor = albedo;
+        outGBufferNormal = vec4(normalize(fragmentVertexNormal), 0.0f);
+        outGBufferMaterial = bUseLighting ? index : -1;
+        return;
+    }
+
+    if (bUseLighting == true)
+    {
+        vec3 lightNormal = normalize(fragmentVertexNormal);
+        vec3 viewDirection = normalize(viewPosition.xyz - fragmentPosition);
+        vec3 phongResult = vec3(0.0f);
+
+        int totalLights = min(lightCount.x, MAX_LIGHTS);
+        for (int i = 0; i < totalLights; i++)
+        {
+            LightSource light;
+            light.position = lights[i].positionFocal.xyz;
+            light.focalStrength = lights[i].positionFocal.w;
+            light.ambientColor = lights[i].ambientColorRange.xyz;
+            light.range = lights[i].ambientColorRange.w;
+            light.diffuseColor = lights[i].diffuseColorIntensity.xyz;
+            light.specularIntensity = lights[i].diffuseColorIntensity.w;
+            light.specularColor = lights[i].specularColor.xyz;
+            light.shadow = LightShadow(i, fragmentPosition, lightNormal);
+            phongResult += CalcLightSource(light, lightNormal, fragmentPosition, viewDirection);
+        }
+
+        if (bTextured == true)
+        {
+            vec4 textureColor = SampleObjectTexture(fragmentTextureCoordinate * UVscale);
+            outFragmentColor = vec4(phongResult * textureColor.xyz, 1.0f);
+        }
+        else
+        {
+            outFragmentColor = vec4(phongResult * baseColor.xyz, baseColor.w);
+        }
+    }
+    else
+    {
+        if (bTextured == true)
+        {
+            outFragmentColor = SampleObjectTexture(fragmentTextureCoordinate * UVscale);
+        }
+        else
+        {
+            outFragmentColor = baseColor;
+        }
+    }
+}
+
+vec3 CalcLightSource(LightSource light, vec3 lightNormal, vec3 vertexPosition, vec3 viewDirection)
+{
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+
+    // Calculate ambient lighting
+    ambient = light.ambientColor * material.ambientColor * material.ambientStrength;
+
+    // Calculate diffuse lighting
+    vec3 lightDirection = normalize(light.position - vertexPosition);
+    float impact = max(dot(lightNormal, lightDirection), 0.0f);
+    diffuse = impact * light.diffuseColor * material.diffuseColor;
+
+    // Calculate specular lighting
+    vec3 reflectDir = reflect(-lightDirection, lightNormal);
+    float specularComponent = pow(max(dot(viewDirection, reflectDir), 0.0f), light.focalStrength);
+    specular = light.specularIntensity * specularComponent * light.specularColor * material.specularColor;
+
+    // --- Enhancement: lights with a range fade out before it ---
+    // --- Enhancement: a shadow keeps only the ambient part ---
+    return (ambient + (diffuse + specular) * light.shadow) *
+        LightAttenuation(light.range, length(light.position - vertexPosition));
+}
+
+// --- Enhancement: 1 at the light, smoothly down to 0 at its range ---
+// A range of 0 lights the whole scene, as every light did before.
+// deferredLightFragment.glsl uses the same falloff.
+float LightAttenuation(float range, float distance)
+{
+    if (range <= 0.0f)
+    {
+        return 1.0f;
+    }
+    float fade = clamp(1.0f - (distance * distance) / (range * range), 0.0f, 1.0f);
+    return fade * fade;
+}
+
+// --- Enhancement: how much of a light reaches a point, from its shadow map ---
+// Points outside the map's view are lit. The lookup point is pushed off the
+// surface along the normal so the surface does not shadow itself.
+// deferredLightFragment.glsl uses the same lookup.
+float LightShadow(int light, vec3 position, vec3 normal)
+{
+    if (light >= min(shadowCount.x, MAX_SHADOWED_LIGHTS))
+    {
+        return 1.0f;
+    }
+    vec4 coordinate = shadowMatrix[light] * vec4(position + normal * shadowParams.x, 1.0f);
+    if (coordinate.w <= 0.0f)
+    {
+        return 1.0f;
+    }
+    coordinate.xyz /= coordinate.w;
+    if (any(lessThan(coordinate.xyz, vec3(0.0f))) || any(greaterThan(coordinate.xyz, vec3(1.0f))))
+    {
+        return 1.0f;
+    }
+    return light == 0 ? texture(shadowMaps[0], coordinate.xyz) : texture(shadowMaps[1], coordinate.xyz);
+}
+
+// --- Enhancement: sample whichever texture backend is active ---
+vec4 SampleObjectTexture(vec2 textureCoordinate)
+{
+    if (bUseTextureArray)
+    {
+        int layer = (bUseInstancing || bUseIndirect) ? fragmentTextureLayer : textureLayer;
+        return texture(objectTextureArray, vec3(textureCoordinate, float(layer)));
+    }
+    return texture(objectTexture, textureCoordinate);
+}
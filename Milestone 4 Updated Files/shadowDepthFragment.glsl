@@ -0,0 +1,14 @@
+/***********************************************************
+ *
+ *  shadowDepthFragment.glsl
+ *	============
+ *  shadow map depth pass, new file for Utilities/shaders
+ *
+ ***********************************************************/
+
+#version 440 core
+
+// only the depth is kept; the shadow map has no color attachment
+void main()
+{
+}
@@ -0,0 +1,23 @@
+/***********************************************************
+ *
+ *  shadowDepthVertex.glsl
+ *	============
+ *  shadow map depth pass, new file for Utilities/shaders
+ *
+ ***********************************************************/
+
+#version 440 core
+
+// --- Enhancement: static batches are baked in world space, moving ---
+// objects are drawn instanced with their model matrix per instance
+layout (location = 0) in vec3 inVertexPosition;
+layout (location = 3) in mat4 inInstanceModel;
+
+uniform mat4 lightViewProjection;
+uniform bool bUseInstancing = false;
+
+void main()
+{
+    mat4 model = bUseInstancing ? inInstanceModel : mat4(1.0f);
+    gl_Position = lightViewProjection * model * vec4(inVertexPosition, 1.0f);
+}
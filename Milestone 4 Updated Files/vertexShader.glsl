@@ -0,0 +1,94 @@
+/***********************************************************
+ *
+ *  vertexShader.glsl
+ *	============
+ *  updated copy of Utilities/shaders/vertexShader.glsl
+ *
+ ***********************************************************/
+
+#version 440 core
+
+layout (location = 0) in vec3 inVertexPosition;
+layout (location = 1) in vec3 inVertexNormal;
+layout (location = 2) in vec2 inTextureCoordinate;
+
+// --- Enhancement: per-instance attributes for instanced drawing ---
+// Only read when bUseInstancing is true; MeshLibrary feeds them with
+// a divisor of 1, one model matrix and color per instance.
+layout (location = 3) in mat4 inInstanceModel;
+layout (location = 7) in vec4 inInstanceColor;
+layout (location = 8) in mat3 inInstanceNormalMatrix;
+layout (location = 11) in int inInstanceMaterialIndex;
+layout (location = 12) in int inInstanceTextureLayer;
+
+// --- Enhancement: per-draw data for multi-draw-indirect ---
+// Only read when bUseIndirect is true. MeshLibrary writes one entry per
+// visible object; inDrawIndex comes from the command's baseInstance.
+layout (location = 13) in int inDrawIndex;
+
+struct DrawData {
+    mat4 model;
+    mat4 normalMatrix;
+    vec4 color;
+    vec2 uvScale;
+    int materialIndex;
+    int textureLayer;
+};
+
+layout (std430, binding = 2) readonly buffer DrawDataBlock {
+    DrawData draws[];
+};
+
+// --- Enhancement: per-frame constants ---
+// Written once per frame by SceneManager into its persistently mapped
+// ring buffer and bound with glBindBufferRange.
+layout (std140, binding = 3) uniform FrameBlock {
+    mat4 view;
+    mat4 projection;
+    vec4 viewPosition;      // xyz = camera position
+};
+
+// --- Enhancement: the depth pre-pass and the color pass must produce the
+// same depth for the same vertex, or the color pass fails its GL_LEQUAL test
+invariant gl_Position;
+
+out vec3 fragmentPosition;
+out vec3 fragmentVertexNormal;
+out vec2 fragmentTextureCoordinate;
+flat out vec4 fragmentInstanceColor;
+flat out int fragmentMaterialIndex;
+flat out int fragmentTextureLayer;
+
+uniform mat4 model;
+// --- Enhancement: normal matrix is cached on the CPU with the model matrix ---
+uniform mat3 normalMatrix;
+uniform bool bUseInstancing = false;
+uniform bool bUseIndirect = false;
+
+void main()
+{
+    mat4 modelMatrix = bUseInstancing ? inInstanceModel : model;
+    mat3 normalTransform = bUseInstancing ? inInstanceNormalMatrix : normalMatrix;
+    vec2 textureCoordinate = inTextureCoordinate;
+
+    fragmentInstanceColor = inInstanceColor;
+    fragmentMaterialIndex = inInstanceMaterialIndex;
+    fragmentTextureLayer = inInstanceTextureLayer;
+
+    if (bUseIndirect)
+    {
+        // the UV scale differs per draw, so it is applied here
+        modelMatrix = draws[inDrawIndex].model;
+        normalTransform = mat3(draws[inDrawIndex].normalMatrix);
+        textureCoordinate *= draws[inDrawIndex].uvScale;
+        fragmentInstanceColor = draws[inDrawIndex].color;
+        fragmentMaterialIndex = draws[inDrawIndex].materialIndex;
+        fragmentTextureLayer = draws[inDrawIndex].textureLayer;
+    }
+
+    gl_Position = projection * view * modelMatrix * vec4(inVertexPosition, 1.0f);
+
+    fragmentPosition = vec3(modelMatrix * vec4(inVertexPosition, 1.0f));
+    fragmentVertexNormal = normalTransform * inVertexNormal;
+    fragmentTextureCoordinate = textureCoordinate;
+}